@@ -0,0 +1,287 @@
+/****************************************************************************
+ *                                                                          *
+ * File    : msgbench.c                                                     *
+ *                                                                          *
+ * Purpose : Resizer per-message overhead benchmark.                        *
+ *                                                                          *
+ *           Creates a plain and a resizable dialog from the same in-memory *
+ *           template, and sends each of them the same stream of frequent   *
+ *           messages (WM_NCHITTEST, WM_SETCURSOR, WM_NULL). The difference *
+ *           is what the Resizer subclass costs for each message. Link it   *
+ *           with an older resizer.lib to compare before and after.         *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../resizer.h"
+#include "../dlgtmpl.h"
+
+#define NELEMS(a)  (sizeof(a) / sizeof(a[0]))
+
+// Default number of messages, for each kind.
+#define C_MESSAGES  1000000
+
+// Default number of controls in the template.
+#define C_CONTROLS  64
+
+// Template buffer, in WORDs.
+typedef struct TMPLBUF {
+    WORD *pw;               // Data.
+    size_t cw;              // WORDs used.
+} TMPLBUF;
+
+// Message to measure.
+typedef struct BENCHMSG {
+    const char *pszName;    // Display name.
+    UINT msg;               // Message.
+} BENCHMSG;
+
+static const BENCHMSG g_aMessages[] = {
+    { "WM_NCHITTEST", WM_NCHITTEST },
+    { "WM_SETCURSOR", WM_SETCURSOR },
+    { "WM_NULL",      WM_NULL },
+};
+
+// Static function prototypes.
+static void Usage(void);
+static LPDLGTEMPLATEW MakeTemplate(int);
+static double Measure(HWND, UINT, int);
+static INT_PTR CALLBACK BenchDlgProc(HWND, UINT, WPARAM, LPARAM);
+static void PutWord(TMPLBUF *, WORD);
+static void PutDWord(TMPLBUF *, DWORD);
+static void PutAlign(TMPLBUF *);
+
+/****************************************************************************
+ *                                                                          *
+ * Function: main                                                           *
+ *                                                                          *
+ * Purpose : Main entry point.                                              *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+int main(int argc, char *argv[])
+{
+    int cMessages = C_MESSAGES;
+    int cControls = C_CONTROLS;
+    LPDLGTEMPLATEW pTemplate;
+    HWND hwndPlain, hwndResizable;
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-messages") == 0 && i + 1 < argc)
+            cMessages = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-controls") == 0 && i + 1 < argc)
+            cControls = atoi(argv[++i]);
+        else
+        {
+            Usage();
+            return 1;
+        }
+    }
+
+    if (cMessages <= 0 || cControls <= 0 || cControls > 0x7FFF)
+    {
+        Usage();
+        return 1;
+    }
+
+    if ((pTemplate = MakeTemplate(cControls)) == NULL)
+    {
+        fprintf(stderr, "msgbench: out of memory\n");
+        return 1;
+    }
+
+    // Same template, same dialog procedure; only the subclass differs.
+    hwndPlain = CreateDialogIndirectParamW(GetModuleHandle(NULL), pTemplate, NULL, BenchDlgProc, 0);
+    hwndResizable = CreateResizableDialogIndirectParamW(GetModuleHandle(NULL), pTemplate, NULL, BenchDlgProc, 0);
+    if (hwndPlain == NULL || hwndResizable == NULL)
+    {
+        fprintf(stderr, "msgbench: can't create dialogs (error %lu)\n", GetLastError());
+        return 1;
+    }
+
+    printf("%d messages, %d controls\n\n", cMessages, cControls);
+    printf("message          plain ns/msg  resizable ns/msg  overhead ns/msg\n");
+
+    for (i = 0; i < (int)NELEMS(g_aMessages); i++)
+    {
+        double plain, resizable;
+
+        // Warm up, then measure.
+        (void)Measure(hwndPlain, g_aMessages[i].msg, cMessages / 10 + 1);
+        (void)Measure(hwndResizable, g_aMessages[i].msg, cMessages / 10 + 1);
+        plain = Measure(hwndPlain, g_aMessages[i].msg, cMessages);
+        resizable = Measure(hwndResizable, g_aMessages[i].msg, cMessages);
+
+        printf("%-16s %13.1f %17.1f %16.1f\n", g_aMessages[i].pszName, plain, resizable, resizable - plain);
+    }
+
+    DestroyWindow(hwndResizable);
+    DestroyWindow(hwndPlain);
+    free(pTemplate);
+
+    return 0;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Usage                                                          *
+ *                                                                          *
+ * Purpose : Display usage.                                                 *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static void Usage(void)
+{
+    fprintf(stderr, "Usage: msgbench [-messages n] [-controls n]\n");
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: MakeTemplate                                                   *
+ *                                                                          *
+ * Purpose : Make extended dialog template, with anchored push buttons.     *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static LPDLGTEMPLATEW MakeTemplate(int cControls)
+{
+    TMPLBUF buf;
+    int i;
+
+    // Header, plus a generous upper bound for each control.
+    if ((buf.pw = malloc(64 + (size_t)cControls * 64)) == NULL)
+        return NULL;
+    buf.cw = 0;
+
+    // DLGTEMPLATEEX: version, signature, help id, exstyle, style, controls, x, y, cx, cy, menu, class, title.
+    PutWord(&buf, 1);
+    PutWord(&buf, 0xFFFF);
+    PutDWord(&buf, 0);
+    PutDWord(&buf, 0);
+    PutDWord(&buf, WS_POPUP|WS_CAPTION|WS_THICKFRAME);
+    PutWord(&buf, (WORD)cControls);
+    PutWord(&buf, 0); PutWord(&buf, 0);
+    PutWord(&buf, 320); PutWord(&buf, 240);
+    PutWord(&buf, 0);
+    PutWord(&buf, 0);
+    PutWord(&buf, 0);
+
+    for (i = 0; i < cControls; i++)
+    {
+        // DLGITEMTEMPLATEEX: help id, exstyle, style, x, y, cx, cy, id, class (button), title.
+        PutAlign(&buf);
+        PutDWord(&buf, 0);
+        PutDWord(&buf, 0);
+        PutDWord(&buf, WS_CHILD|WS_VISIBLE|BS_PUSHBUTTON);
+        PutWord(&buf, (WORD)(i % 8 * 38)); PutWord(&buf, (WORD)(i / 8 % 16 * 14));
+        PutWord(&buf, 36); PutWord(&buf, 12);
+        PutDWord(&buf, (DWORD)(1000 + i));
+        PutWord(&buf, 0xFFFF); PutWord(&buf, 0x0080);
+        PutWord(&buf, 0);
+
+        // Creation data; half of the buttons follow the lower right corner.
+        PutWord(&buf, sizeof(EXTRADATA));
+        PutWord(&buf, EXTRA_MAGIC);
+        PutWord(&buf, EXTRA_VERSION);
+        PutWord(&buf, (i & 1) ? RESIZER_RIGHT|RESIZER_BOTTOM : RESIZER_NONE);
+    }
+
+    return (LPDLGTEMPLATEW)buf.pw;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Measure                                                        *
+ *                                                                          *
+ * Purpose : Send message to a dialog, and return nanoseconds per message.  *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static double Measure(HWND hwndDlg, UINT msg, int cMessages)
+{
+    LARGE_INTEGER liFreq, liStart, liEnd;
+    WPARAM wParam = 0;
+    LPARAM lParam = 0;
+    RECT rc;
+    int i;
+
+    // Middle of the client area; not on the gripper.
+    GetWindowRect(hwndDlg, &rc);
+    if (msg == WM_NCHITTEST)
+        lParam = MAKELPARAM((rc.left + rc.right) / 2, (rc.top + rc.bottom) / 2);
+    else if (msg == WM_SETCURSOR)
+        wParam = (WPARAM)hwndDlg, lParam = MAKELPARAM(HTCLIENT, WM_MOUSEMOVE);
+
+    QueryPerformanceFrequency(&liFreq);
+    QueryPerformanceCounter(&liStart);
+    for (i = 0; i < cMessages; i++)
+        SendMessageW(hwndDlg, msg, wParam, lParam);
+    QueryPerformanceCounter(&liEnd);
+
+    return (double)(liEnd.QuadPart - liStart.QuadPart) * 1e9 / liFreq.QuadPart / cMessages;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: BenchDlgProc                                                   *
+ *                                                                          *
+ * Purpose : Dialog procedure; does nothing, like most of them.             *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static INT_PTR CALLBACK BenchDlgProc(HWND hwndDlg, UINT msg, WPARAM wParam, LPARAM lParam)
+{
+    return (msg == WM_INITDIALOG);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: PutWord, PutDWord, PutAlign                                    *
+ *                                                                          *
+ * Purpose : Append to template buffer.                                     *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static void PutWord(TMPLBUF *pBuf, WORD w)
+{
+    pBuf->pw[pBuf->cw++] = w;
+}
+
+static void PutDWord(TMPLBUF *pBuf, DWORD dw)
+{
+    PutWord(pBuf, LOWORD(dw));
+    PutWord(pBuf, HIWORD(dw));
+}
+
+static void PutAlign(TMPLBUF *pBuf)
+{
+    if (pBuf->cw & 1)
+        PutWord(pBuf, 0);
+}
@@ -0,0 +1,997 @@
+/****************************************************************************
+ *                                                                          *
+ * File    : rszbench.c                                                     *
+ *                                                                          *
+ * Purpose : Resizer benchmark and replay tool.                             *
+ *                                                                          *
+ *           Generates synthetic extended dialog templates, and measures    *
+ *           the template compiler and the layout engine against an         *
+ *           in-memory stand-in for the window manager (no HWNDs, no        *
+ *           DeferWindowPos). Can also replay recorded WM_SIZE sequences,   *
+ *           printing a checksum (or all rectangles) for regression tests.  *
+ *                                                                          *
+ *           With -modal, runs nested modal dialogs on several threads at   *
+ *           once, through the modal hand-over of the Resizer (modal.c),    *
+ *           against a fake dialog manager.                                 *
+ *                                                                          *
+ *           Only uses the C11 standard library (with threads); builds on   *
+ *           any host:                                                      *
+ *           cc -O2 rszbench.c ../dlgtmpl.c ../layout.c ../modal.c          *
+ *              -o rszbench                                                 *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+#include <time.h>
+#include "../dlgtmpl.h"
+#include "../layout.h"
+#include "../modal.h"
+
+#define ROUNDUP(n,m)  (((n)+((m)-1)) & (~((m)-1)))
+
+// Dialog size, in pixels (nothing here cares about dialog units).
+#define DLG_CX  640
+#define DLG_CY  480
+
+// Output buffer for template generator.
+typedef struct TMPLBUF {
+    uint8_t *pb;            // Data.
+    size_t cb;              // Bytes used.
+    size_t cbMax;           // Bytes allocated.
+} TMPLBUF;
+
+// Fake window manager: one "window" for each anchored control.
+typedef struct FAKEWM {
+    LAYOUT layout;          // Layout table.
+    void *pvLayout;         // Memory for layout table.
+    LAYOUTRECT *prcWnd;     // Current window rectangles.
+    LAYOUTRECT *prcTmp;     // Computed rectangles.
+    size_t cWnd;            // Number of windows.
+    int32_t cxMin, cyMin;   // Minimum (original) client size.
+    int32_t cxCur, cyCur;   // Current client size.
+    size_t cMoves;          // Number of "DeferWindowPos" calls.
+} FAKEWM;
+
+// Modal stress test: dialogs opened by each thread, nesting depth, and one in how many
+// dialogs fails before its first message, or opens another one before its first message.
+#define C_MODALROUNDS  2000
+#define C_MODALDEPTH   4
+#define C_MODALFAIL    8
+#define C_MODALHOOK    4
+
+// Fake dialog manager messages; like the real one, WM_SETFONT comes before WM_INITDIALOG.
+#define FM_SETFONT      1
+#define FM_INITDIALOG   2
+#define FM_NCDESTROY    3
+
+// Fake dialog window.
+typedef struct FAKEDLG {
+    void *pvProp;           // Window property (the claimed context).
+    void *pvUser;           // DWLP_USER.
+    intptr_t result;        // Result, from EndDialog().
+} FAKEDLG;
+
+typedef intptr_t (*FAKEDLGPROC)(FAKEDLG *, unsigned int, intptr_t);
+
+// Fake CBT hook; runs while the dialog is created, before its first message.
+typedef void (*FAKEHOOKPROC)(void *);
+
+// Modal context, like MODALCONTEXT in the Resizer.
+typedef struct FAKECONTEXT {
+    MODALLINK link;         // Pending context, on this thread (first member).
+    FAKEDLGPROC pfnDialog;  // Original dialog procedure.
+    uint32_t id;            // Dialog it was made for (the Resizer has a RESIZER here).
+    int cClaims;            // Number of times claimed.
+} FAKECONTEXT;
+
+// One thread of the modal stress test.
+typedef struct MODALTHREAD {
+    unsigned int iThread;   // Thread number.
+    unsigned int cDepth;    // Maximum nesting depth.
+    uint32_t uSeed;         // Random state, for failing and hooked dialogs.
+    uint32_t cOpened;       // Dialogs asked for (for unique ids).
+    unsigned long cDialogs; // Dialogs created.
+    unsigned long cFailed;  // Dialogs that failed, on purpose.
+    unsigned long cErrors;  // Dialogs with the wrong context, or none; or contexts left behind.
+} MODALTHREAD;
+
+// One modal dialog; its WM_INITDIALOG data.
+typedef struct MODALREQ {
+    MODALTHREAD *pThread;   // Thread.
+    unsigned int iDepth;    // Nesting depth (0 = top).
+    uint32_t id;            // Unique for each dialog.
+} MODALREQ;
+
+static _Thread_local PMODALLINK g_pPending;  /* pending contexts, one stack for each thread; TLS in the Resizer */
+
+// Static function prototypes.
+static void Usage(void);
+static int Benchmark(unsigned int);
+static int Replay(const char *, size_t, unsigned int, int);
+static int Generate(size_t, unsigned int);
+static uint8_t *MakeTemplate(size_t, unsigned int, size_t *);
+static int ModalStress(unsigned int, unsigned int);
+static int ModalThread(void *);
+static void ModalDialog(MODALTHREAD *, unsigned int);
+static void ModalHook(void *);
+static intptr_t FakeDialogBox(FAKEDLGPROC, intptr_t, int, FAKEHOOKPROC, void *);
+static intptr_t FakeResizerDlgProc(FAKEDLG *, unsigned int, intptr_t);
+static intptr_t ModalDlgProc(FAKEDLG *, unsigned int, intptr_t);
+static int MakeFakeWM(FAKEWM *, const uint8_t *, size_t, unsigned int);
+static void FreeFakeWM(FAKEWM *);
+static void FakeResize(FAKEWM *, int32_t, int32_t);
+static uint64_t Checksum(const FAKEWM *);
+static double Now(void);
+static uint32_t Random(uint32_t *);
+static void Put(TMPLBUF *, const void *, size_t);
+static void PutWord(TMPLBUF *, uint16_t);
+static void PutDWord(TMPLBUF *, uint32_t);
+static void PutString(TMPLBUF *, const char *);
+static void PutAlign(TMPLBUF *);
+
+// Inline functions (one-liners).
+static inline PMODALLINK GetPendingSlot(void) { return g_pPending; }
+static inline void SetPendingSlot(PMODALLINK pLink) { g_pPending = pLink; }
+
+// Pending modal dialogs, for ModalPush() and friends.
+static const MODALSLOT g_slotPending = { GetPendingSlot, SetPendingSlot };
+
+/****************************************************************************
+ *                                                                          *
+ * Function: main                                                           *
+ *                                                                          *
+ * Purpose : Main entry point.                                              *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+int main(int argc, char *argv[])
+{
+    const char *pszReplay = NULL;
+    size_t cControls = 1000;
+    size_t cGenerate = 0;
+    unsigned int seed = 1;
+    unsigned int cThreads = 0;
+    int fDump = 0;
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-replay") == 0 && i + 1 < argc)
+            pszReplay = argv[++i];
+        else if (strcmp(argv[i], "-generate") == 0 && i + 1 < argc)
+            cGenerate = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-controls") == 0 && i + 1 < argc)
+            cControls = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc)
+            seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-dump") == 0)
+            fDump = 1;
+        else if (strcmp(argv[i], "-modal") == 0 && i + 1 < argc)
+            cThreads = (unsigned int)strtoul(argv[++i], NULL, 10);
+        else
+        {
+            Usage();
+            return 1;
+        }
+    }
+
+    if (cControls == 0 || cControls > 0xFFFF)
+    {
+        Usage();
+        return 1;
+    }
+
+    if (cThreads != 0)
+        return ModalStress(cThreads, C_MODALDEPTH);
+    if (cGenerate != 0)
+        return Generate(cGenerate, seed);
+    else if (pszReplay != NULL)
+        return Replay(pszReplay, cControls, seed, fDump);
+    else
+        return Benchmark(seed);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Usage                                                          *
+ *                                                                          *
+ * Purpose : Display usage.                                                 *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static void Usage(void)
+{
+    fprintf(stderr,
+        "Usage: rszbench [-seed n]                                 run benchmark\n"
+        "       rszbench -generate n [-seed n]                     write n random WM_SIZE events\n"
+        "       rszbench -replay file [-controls n] [-seed n] [-dump]  replay WM_SIZE events\n"
+        "       rszbench -modal n                                  nested modal dialogs on n threads\n"
+        "\n"
+        "Replay files have one \"cx cy\" client size for each line.\n");
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Benchmark                                                      *
+ *                                                                          *
+ * Purpose : Measure template compile and layout, for different sizes.      *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int Benchmark(unsigned int seed)
+{
+    static const size_t acControls[] = { 10, 100, 1000, 10000 };
+    size_t n;
+
+    printf("%8s %10s %12s %12s %12s %12s\n", "controls", "bytes", "compile MB/s", "us/compile", "us/layout", "ns/control");
+
+    for (n = 0; n < sizeof(acControls) / sizeof(acControls[0]); n++)
+    {
+        size_t cControls = acControls[n];
+        size_t cbTemplate;
+        uint8_t *pbTemplate, *pbCompiled;
+        DLGANCHOR *pAnchors;
+        DLGCOMPILEINFO info;
+        double t0, tCompile, tLayout;
+        size_t cIter, i;
+        FAKEWM wm;
+
+        pbTemplate = MakeTemplate(cControls, seed, &cbTemplate);
+        pbCompiled = malloc(cbTemplate);
+        pAnchors = malloc(cControls * sizeof(DLGANCHOR));
+        if (pbTemplate == NULL || pbCompiled == NULL || pAnchors == NULL)
+        {
+            fprintf(stderr, "rszbench: out of memory\n");
+            return 1;
+        }
+
+        // Template compile; about 64 MB worth of templates.
+        cIter = 1 + (64 << 20) / cbTemplate;
+        t0 = Now();
+        for (i = 0; i < cIter; i++)
+        {
+            if (DlgCompileTemplate(pbTemplate, cbTemplate, pbCompiled, cbTemplate, pAnchors, cControls, &info) != DLGT_OK)
+            {
+                fprintf(stderr, "rszbench: bad template\n");
+                return 1;
+            }
+        }
+        tCompile = (Now() - t0) / cIter;
+
+        // Layout; a live drag, back and forth, about 16 million control moves.
+        if (!MakeFakeWM(&wm, pbTemplate, cbTemplate, seed))
+        {
+            fprintf(stderr, "rszbench: out of memory\n");
+            return 1;
+        }
+        cIter = 1 + (16 << 20) / cControls;
+        t0 = Now();
+        for (i = 0; i < cIter; i++)
+        {
+            int32_t d = (int32_t)(i % 512);
+            d = (d < 256) ? d : 512 - d;
+            FakeResize(&wm, DLG_CX + d, DLG_CY + d / 2);
+        }
+        tLayout = (Now() - t0) / cIter;
+
+        printf("%8zu %10zu %12.1f %12.2f %12.2f %12.2f\n", cControls, cbTemplate,
+            cbTemplate / tCompile / (1 << 20), tCompile * 1e6, tLayout * 1e6, tLayout * 1e9 / cControls);
+
+        FreeFakeWM(&wm);
+        free(pAnchors);
+        free(pbCompiled);
+        free(pbTemplate);
+    }
+
+    return 0;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Replay                                                         *
+ *                                                                          *
+ * Purpose : Replay recorded WM_SIZE events.                                *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int Replay(const char *pszFile, size_t cControls, unsigned int seed, int fDump)
+{
+    uint8_t *pbTemplate;
+    size_t cbTemplate;
+    size_t cEvents = 0;
+    long cx, cy;
+    double t0, t;
+    FAKEWM wm;
+    FILE *pf;
+
+    if ((pf = fopen(pszFile, "r")) == NULL)
+    {
+        fprintf(stderr, "rszbench: can't open '%s'\n", pszFile);
+        return 1;
+    }
+
+    if ((pbTemplate = MakeTemplate(cControls, seed, &cbTemplate)) == NULL || !MakeFakeWM(&wm, pbTemplate, cbTemplate, seed))
+    {
+        fprintf(stderr, "rszbench: out of memory\n");
+        return 1;
+    }
+
+    t = 0;
+    while (fscanf(pf, "%ld %ld", &cx, &cy) == 2)
+    {
+        t0 = Now();
+        FakeResize(&wm, (int32_t)cx, (int32_t)cy);
+        t += Now() - t0;
+        cEvents++;
+
+        if (fDump)
+        {
+            size_t i;
+
+            printf("size %ld %ld\n", cx, cy);
+            for (i = 0; i < wm.cWnd; i++)
+                printf("%zu %ld %ld %ld %ld\n", i, (long)wm.prcWnd[i].left, (long)wm.prcWnd[i].top, (long)wm.prcWnd[i].right, (long)wm.prcWnd[i].bottom);
+        }
+    }
+    fclose(pf);
+
+    // Stable output first, so it can be compared between runs.
+    printf("events %zu, windows %zu, moves %zu, checksum %016llx\n", cEvents, wm.cWnd, wm.cMoves, (unsigned long long)Checksum(&wm));
+    fprintf(stderr, "%.2f us/event\n", cEvents ? t * 1e6 / cEvents : 0.0);
+
+    FreeFakeWM(&wm);
+    free(pbTemplate);
+    return 0;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Generate                                                       *
+ *                                                                          *
+ * Purpose : Write a random, drag-like, sequence of WM_SIZE events.         *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int Generate(size_t cEvents, unsigned int seed)
+{
+    uint32_t state = seed;
+    long cx = DLG_CX, cy = DLG_CY;
+    size_t i;
+
+    for (i = 0; i < cEvents; i++)
+    {
+        // Mostly small steps, on one or both axes; sometimes below the minimum size.
+        switch (Random(&state) % 4)
+        {
+            case 0: cx += (long)(Random(&state) % 17) - 8; break;
+            case 1: cy += (long)(Random(&state) % 17) - 8; break;
+            case 2: cx += (long)(Random(&state) % 9) - 4; cy += (long)(Random(&state) % 9) - 4; break;
+            case 3: break;
+        }
+        cx = (cx < DLG_CX / 2) ? DLG_CX / 2 : (cx > DLG_CX * 3) ? DLG_CX * 3 : cx;
+        cy = (cy < DLG_CY / 2) ? DLG_CY / 2 : (cy > DLG_CY * 3) ? DLG_CY * 3 : cy;
+        printf("%ld %ld\n", cx, cy);
+    }
+
+    return 0;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: MakeTemplate                                                   *
+ *                                                                          *
+ * Purpose : Generate a DLGTEMPLATEEX with the given number of controls.    *
+ *           About 3 out of 4 controls get random RESIZER_* flags; the      *
+ *           rest have no creation data, or someone else's.                 *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static uint8_t *MakeTemplate(size_t cControls, unsigned int seed, size_t *pcb)
+{
+    uint32_t state = seed;
+    TMPLBUF buf = {0};
+    size_t i;
+
+    // DLGTEMPLATEEX: version, signature, help id, exstyle, style (DS_SETFONT), items, x, y, cx, cy.
+    PutWord(&buf, 1);
+    PutWord(&buf, 0xFFFF);
+    PutDWord(&buf, 0);
+    PutDWord(&buf, 0);
+    PutDWord(&buf, 0x80C80040);
+    PutWord(&buf, (uint16_t)cControls);
+    PutWord(&buf, 0); PutWord(&buf, 0); PutWord(&buf, DLG_CX / 2); PutWord(&buf, DLG_CY / 2);
+    PutWord(&buf, 0);  /* menu */
+    PutWord(&buf, 0);  /* class */
+    PutString(&buf, "Benchmark");
+    PutWord(&buf, 8); PutWord(&buf, 400); Put(&buf, "\0\1", 2);
+    PutString(&buf, "MS Shell Dlg");
+
+    for (i = 0; i < cControls; i++)
+    {
+        uint32_t r = Random(&state);
+
+        // DLGITEMTEMPLATEEX: help id, exstyle, style, x, y, cx, cy, id.
+        PutAlign(&buf);
+        PutDWord(&buf, 0);
+        PutDWord(&buf, 0);
+        PutDWord(&buf, 0x50010000);
+        PutWord(&buf, (uint16_t)(i % 32 * 10)); PutWord(&buf, (uint16_t)(i / 32 % 32 * 7));
+        PutWord(&buf, 40); PutWord(&buf, 12);
+        PutDWord(&buf, (uint32_t)(1000 + i));
+
+        // Class (ordinal or name), and title.
+        if (r & 0x100)
+            PutWord(&buf, 0xFFFF), PutWord(&buf, 0x0080);
+        else
+            PutString(&buf, "SysListView32");
+        PutString(&buf, (r & 0x200) ? "Text" : "");
+
+        // Creation data.
+        if ((r & 3) == 3 && (r & 0x800))
+        {
+            PutWord(&buf, sizeof(EXTRADATA2));
+            PutWord(&buf, EXTRA_MAGIC);
+            PutWord(&buf, EXTRA_VERSION2);
+            PutWord(&buf, (uint16_t)((r >> 4) & RESIZER_VERT));
+            PutWord(&buf, 50); PutWord(&buf, 0);
+            PutWord(&buf, 50); PutWord(&buf, 0);
+        }
+        else if ((r & 3) != 0)
+        {
+            PutWord(&buf, sizeof(EXTRADATA));
+            PutWord(&buf, EXTRA_MAGIC);
+            PutWord(&buf, EXTRA_VERSION);
+            PutWord(&buf, (uint16_t)((r >> 4) & (RESIZER_HORZ|RESIZER_VERT)));
+        }
+        else if (r & 0x400)
+        {
+            PutWord(&buf, 4);
+            PutDWord(&buf, r);
+        }
+        else
+        {
+            PutWord(&buf, 0);
+        }
+    }
+
+    *pcb = buf.cb;
+    return buf.pb;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ModalStress                                                    *
+ *                                                                          *
+ * Purpose : Open nested modal dialogs on several threads at once, through  *
+ *           the modal hand-over of the Resizer (../modal.c), against a     *
+ *           fake dialog manager. Each dialog must get the context made     *
+ *           for it, and no context may be left behind.                     *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int ModalStress(unsigned int cThreads, unsigned int cDepth)
+{
+    unsigned long cDialogs = 0, cFailed = 0, cErrors = 0;
+    MODALTHREAD *pThreads;
+    thrd_t *pthrd;
+    unsigned int i;
+    double t0;
+
+    // Ids have room for 4096 threads.
+    if (cThreads > 0x1000)
+    {
+        Usage();
+        return 1;
+    }
+
+    pthrd = malloc(cThreads * sizeof(thrd_t));
+    pThreads = calloc(cThreads, sizeof(MODALTHREAD));
+    if (pthrd == NULL || pThreads == NULL)
+    {
+        fprintf(stderr, "rszbench: out of memory\n");
+        return 1;
+    }
+
+    t0 = Now();
+    for (i = 0; i < cThreads; i++)
+    {
+        pThreads[i].iThread = i;
+        pThreads[i].cDepth = cDepth;
+        pThreads[i].uSeed = i + 1;
+        if (thrd_create(&pthrd[i], ModalThread, &pThreads[i]) != thrd_success)
+        {
+            fprintf(stderr, "rszbench: can't create thread\n");
+            return 1;
+        }
+    }
+
+    for (i = 0; i < cThreads; i++)
+    {
+        thrd_join(pthrd[i], NULL);
+        cDialogs += pThreads[i].cDialogs;
+        cFailed += pThreads[i].cFailed;
+        cErrors += pThreads[i].cErrors;
+    }
+
+    printf("threads %u, depth %u, dialogs %lu, failed %lu, errors %lu\n", cThreads, cDepth, cDialogs, cFailed, cErrors);
+    fprintf(stderr, "%.3f us/dialog\n", cDialogs ? (Now() - t0) * 1e6 / cDialogs : 0.0);
+
+    free(pThreads);
+    free(pthrd);
+    return (cErrors == 0 && cDialogs != 0) ? 0 : 1;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ModalThread                                                    *
+ *                                                                          *
+ * Purpose : Open the top modal dialog, over and over, on this thread.      *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int ModalThread(void *pvThread)
+{
+    MODALTHREAD *pThread = pvThread;
+    int i;
+
+    for (i = 0; i < C_MODALROUNDS; i++)
+    {
+        ModalDialog(pThread, 0);
+
+        // Every context claimed, or popped.
+        if (g_pPending != NULL)
+        {
+            pThread->cErrors++;
+            g_pPending = NULL;
+        }
+    }
+
+    return 0;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ModalDialog                                                    *
+ *                                                                          *
+ * Purpose : Run one modal dialog, like ResizableDialogBoxWorker(): push    *
+ *           a context, run the dialog, and pop the context if the dialog   *
+ *           never claimed it.                                              *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static void ModalDialog(MODALTHREAD *pThread, unsigned int iDepth)
+{
+    PMODALLINK pSaved = g_pPending;
+    FAKECONTEXT ctx;
+    MODALREQ req;
+    FAKEHOOKPROC pfnHook = NULL;
+    intptr_t result;
+    int fFail;
+
+    req.pThread = pThread;
+    req.iDepth = iDepth;
+    req.id = ((uint32_t)pThread->iThread << 20) | (++pThread->cOpened & 0xFFFFF);
+
+    ctx.pfnDialog = ModalDlgProc;
+    ctx.id = req.id;
+    ctx.cClaims = 0;
+
+    // Like a bad template, now and then.
+    fFail = (Random(&pThread->uSeed) % C_MODALFAIL) == 0;
+
+    // Like a hook that opens a dialog of its own, now and then; then two are pending.
+    if (iDepth + 1 < pThread->cDepth && (Random(&pThread->uSeed) % C_MODALHOOK) == 0)
+        pfnHook = ModalHook;
+
+    ModalPush(&g_slotPending, &ctx.link);
+    result = FakeDialogBox(FakeResizerDlgProc, (intptr_t)&req, fFail, pfnHook, &req);
+    ModalPop(&g_slotPending, &ctx.link);
+
+    // Claimed once, by this dialog; or not at all, if it failed. Either way, gone.
+    if (fFail)
+        pThread->cFailed++;
+    if ((fFail) ? (result != -1 || ctx.cClaims != 0) : (result != (intptr_t)req.id || ctx.cClaims != 1))
+        pThread->cErrors++;
+    if (g_pPending != pSaved)
+        pThread->cErrors++;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ModalHook                                                      *
+ *                                                                          *
+ * Purpose : Open the next nesting level while the dialog is created, so    *
+ *           its context is still pending under the new one.                *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static void ModalHook(void *pvReq)
+{
+    MODALREQ *pReq = pvReq;
+
+    ModalDialog(pReq->pThread, pReq->iDepth + 1);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: FakeDialogBox                                                  *
+ *                                                                          *
+ * Purpose : Fake DialogBoxIndirectParam(): send the messages a modal       *
+ *           dialog gets, and return the result from EndDialog(), or -1 if  *
+ *           the dialog can't be created. Calls the hook (if any) before    *
+ *           the first message. Gives up the processor while the dialog is  *
+ *           created, and between messages, so the threads take turns in    *
+ *           the middle of the hand-over.                                   *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static intptr_t FakeDialogBox(FAKEDLGPROC pfnDialog, intptr_t lParam, int fFail, FAKEHOOKPROC pfnHook, void *pvHook)
+{
+    FAKEDLG dlg = {0};
+
+    thrd_yield();
+    if (fFail)
+        return -1;
+
+    if (pfnHook != NULL)
+        (*pfnHook)(pvHook);
+
+    dlg.result = -1;
+    (*pfnDialog)(&dlg, FM_SETFONT, 0);
+    thrd_yield();
+    (*pfnDialog)(&dlg, FM_INITDIALOG, lParam);
+    thrd_yield();
+    (*pfnDialog)(&dlg, FM_NCDESTROY, 0);
+
+    return dlg.result;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: FakeResizerDlgProc                                             *
+ *                                                                          *
+ * Purpose : Like ResizerDlgProc(): claim the newest pending context with   *
+ *           the first message, and pass all messages on.                   *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static intptr_t FakeResizerDlgProc(FAKEDLG *pDlg, unsigned int msg, intptr_t lParam)
+{
+    FAKECONTEXT *pCtx = pDlg->pvProp;
+    intptr_t result;
+
+    if (pCtx == NULL)
+    {
+        if ((pCtx = (FAKECONTEXT *)ModalClaim(&g_slotPending)) == NULL)
+            return 0;
+        pCtx->cClaims++;
+        pDlg->pvProp = pCtx;
+    }
+
+    result = (*pCtx->pfnDialog)(pDlg, msg, lParam);
+
+    if (msg == FM_NCDESTROY)
+        pDlg->pvProp = NULL;
+
+    return result;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ModalDlgProc                                                   *
+ *                                                                          *
+ * Purpose : Dialog procedure for the modal stress test. Checks that the    *
+ *           dialog got its own context, and opens the next nesting level   *
+ *           from WM_INITDIALOG, while the Resizer would still be busy.     *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static intptr_t ModalDlgProc(FAKEDLG *pDlg, unsigned int msg, intptr_t lParam)
+{
+    MODALREQ *pReq = pDlg->pvUser;
+
+    switch (msg)
+    {
+        case FM_INITDIALOG:
+            pReq = (MODALREQ *)lParam;
+            pDlg->pvUser = pReq;
+            pReq->pThread->cDialogs++;
+
+            // Someone else's context? The Resizer would lay out the wrong controls.
+            if (((FAKECONTEXT *)pDlg->pvProp)->id != pReq->id)
+                pReq->pThread->cErrors++;
+
+            if (pReq->iDepth + 1 < pReq->pThread->cDepth)
+                ModalDialog(pReq->pThread, pReq->iDepth + 1);
+
+            // Like EndDialog(), with the id.
+            pDlg->result = (intptr_t)pReq->id;
+            return 1;
+    }
+
+    return 0;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: MakeFakeWM                                                     *
+ *                                                                          *
+ * Purpose : Compile template, and set up windows like the Resizer does.    *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int MakeFakeWM(FAKEWM *pwm, const uint8_t *pbTemplate, size_t cbTemplate, unsigned int seed)
+{
+    int cDlgItems = DlgGetItemCount(pbTemplate, cbTemplate);
+    DLGANCHOR *pAnchors = malloc(cDlgItems * sizeof(DLGANCHOR));
+    uint8_t *pbCompiled = malloc(cbTemplate);
+    uint32_t state = seed;
+    DLGCOMPILEINFO info;
+    size_t i;
+
+    memset(pwm, 0, sizeof(*pwm));
+    if (pAnchors == NULL || pbCompiled == NULL ||
+        DlgCompileTemplate(pbTemplate, cbTemplate, pbCompiled, cbTemplate, pAnchors, cDlgItems, &info) != DLGT_OK)
+    {
+        free(pAnchors);
+        free(pbCompiled);
+        return 0;
+    }
+
+    pwm->cWnd = info.cAnchors;
+    pwm->pvLayout = malloc(LayoutGetSize(pwm->cWnd));
+    pwm->prcWnd = malloc(pwm->cWnd * sizeof(LAYOUTRECT));
+    pwm->prcTmp = malloc(pwm->cWnd * sizeof(LAYOUTRECT));
+    if (pwm->pvLayout == NULL || pwm->prcWnd == NULL || pwm->prcTmp == NULL)
+    {
+        free(pAnchors);
+        free(pbCompiled);
+        return 0;
+    }
+
+    pwm->cxMin = pwm->cxCur = DLG_CX;
+    pwm->cyMin = pwm->cyCur = DLG_CY;
+
+    // Original "window" rectangles, in a grid.
+    LayoutInit(&pwm->layout, pwm->pvLayout, pwm->cWnd);
+    for (i = 0; i < pwm->cWnd; i++)
+    {
+        LAYOUTRECT *prc = &pwm->prcWnd[i];
+        uint32_t r = Random(&state);
+
+        prc->left = (int32_t)(r % (DLG_CX - 80));
+        prc->top = (int32_t)((r >> 12) % (DLG_CY - 24));
+        prc->right = prc->left + 80;
+        prc->bottom = prc->top + 24;
+
+        LayoutSetItem(&pwm->layout, i, &pAnchors[i]);
+        LayoutSetBase(&pwm->layout, i, prc, 0, 0);
+    }
+    LayoutBuildDirtySets(&pwm->layout);
+
+    free(pAnchors);
+    free(pbCompiled);
+    return 1;
+}
+
+static void FreeFakeWM(FAKEWM *pwm)
+{
+    free(pwm->pvLayout);
+    free(pwm->prcWnd);
+    free(pwm->prcTmp);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: FakeResize                                                     *
+ *                                                                          *
+ * Purpose : Same steps as MoveDialogControls(), with a fake window         *
+ *           manager; "DeferWindowPos" just stores the rectangle.           *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static void FakeResize(FAKEWM *pwm, int32_t cx, int32_t cy)
+{
+    const uint32_t *pIndex;
+    unsigned int fAxes = 0;
+    size_t cIndex, k;
+
+    // Make sure we don't go below the minimum dialog size.
+    cx = (cx > pwm->cxMin) ? cx : pwm->cxMin;
+    cy = (cy > pwm->cyMin) ? cy : pwm->cyMin;
+
+    // Only controls anchored to a changed axis will move.
+    if (cx != pwm->cxCur) fAxes |= LAYOUT_HORZ;
+    if (cy != pwm->cyCur) fAxes |= LAYOUT_VERT;
+    if ((cIndex = LayoutGetDirtySet(&pwm->layout, fAxes, &pIndex)) == 0)
+        return;
+
+    pwm->cxCur = cx;
+    pwm->cyCur = cy;
+
+    LayoutComputeSet(&pwm->layout, cx - pwm->cxMin, cy - pwm->cyMin, pIndex, cIndex, pwm->prcTmp);
+
+    for (k = 0; k < cIndex; k++)
+        pwm->prcWnd[pIndex[k]] = pwm->prcTmp[k];
+    pwm->cMoves += cIndex;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Checksum                                                       *
+ *                                                                          *
+ * Purpose : Return FNV-1a hash of all window rectangles.                   *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static uint64_t Checksum(const FAKEWM *pwm)
+{
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    size_t i, j;
+
+    for (i = 0; i < pwm->cWnd; i++)
+    {
+        int32_t ai[4] = { pwm->prcWnd[i].left, pwm->prcWnd[i].top, pwm->prcWnd[i].right, pwm->prcWnd[i].bottom };
+
+        // Byte order independent.
+        for (j = 0; j < 16; j++)
+        {
+            hash ^= ((uint32_t)ai[j / 4] >> (j % 4 * 8)) & 0xFF;
+            hash *= 0x100000001B3ULL;
+        }
+    }
+
+    return hash;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Now                                                            *
+ *                                                                          *
+ * Purpose : Return current time, in seconds.                               *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static double Now(void)
+{
+    struct timespec ts;
+
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Random                                                         *
+ *                                                                          *
+ * Purpose : Return pseudo-random number; same sequence on every host.      *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static uint32_t Random(uint32_t *pState)
+{
+    // xorshift32; zero is a fixed point, so avoid it.
+    uint32_t x = (*pState != 0) ? *pState : 0x9E3779B9;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *pState = x;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Put                                                            *
+ *                                                                          *
+ * Purpose : Append bytes to template buffer (little-endian).               *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static void Put(TMPLBUF *pBuf, const void *pv, size_t cb)
+{
+    if (cb > pBuf->cbMax - pBuf->cb)
+    {
+        size_t cbMax = (pBuf->cbMax != 0) ? pBuf->cbMax : 4096;
+
+        while (cb > cbMax - pBuf->cb)
+            cbMax *= 2;
+
+        if ((pBuf->pb = realloc(pBuf->pb, cbMax)) == NULL)
+        {
+            fprintf(stderr, "rszbench: out of memory\n");
+            exit(1);
+        }
+        pBuf->cbMax = cbMax;
+    }
+
+    memcpy(pBuf->pb + pBuf->cb, pv, cb);
+    pBuf->cb += cb;
+}
+
+static void PutWord(TMPLBUF *pBuf, uint16_t w)
+{
+    uint8_t ab[2] = { w & 0xFF, w >> 8 };
+    Put(pBuf, ab, sizeof(ab));
+}
+
+static void PutDWord(TMPLBUF *pBuf, uint32_t dw)
+{
+    PutWord(pBuf, dw & 0xFFFF);
+    PutWord(pBuf, dw >> 16);
+}
+
+static void PutString(TMPLBUF *pBuf, const char *psz)
+{
+    do
+        PutWord(pBuf, (uint8_t)*psz);
+    while (*psz++ != '\0');
+}
+
+static void PutAlign(TMPLBUF *pBuf)
+{
+    static const uint8_t abZero[sizeof(uint32_t)] = {0};
+    Put(pBuf, abZero, ROUNDUP(pBuf->cb, sizeof(uint32_t)) - pBuf->cb);
+}
@@ -0,0 +1,426 @@
+/****************************************************************************
+ *                                                                          *
+ * File    : dlgtmpl.c                                                      *
+ *                                                                          *
+ * Purpose : Portable, single-pass dialog template compiler.                *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+#include <string.h>
+#include "dlgtmpl.h"
+
+#define ROUNDUP(n,m)  (((n)+((m)-1)) & (~((m)-1)))
+
+// Our own copies, since we don't include <windows.h>.
+#define DLGT_DS_SETFONT      0x00000040UL
+#define DLGT_WS_THICKFRAME   0x00040000UL
+
+// Offsets into DLGTEMPLATEEX.
+#define OFS_DLG_VERSION     0
+#define OFS_DLG_SIGNATURE   2
+#define OFS_DLG_STYLE       12
+#define OFS_DLG_ITEMCOUNT   16
+#define OFS_DLG_MENU        26
+
+// Offsets into DLGITEMTEMPLATEEX.
+#define OFS_ITEM_ID         20
+#define OFS_ITEM_CLASS      24
+
+// Compiler state.
+typedef struct COMPILER {
+    const uint8_t *pbSrc;   // Source template.
+    size_t cbSrc;           // Size of source template.
+    size_t ibSrc;           // Current source offset.
+    uint8_t *pbDst;         // Compiled template (or NULL).
+    size_t cbDst;           // Size of compiled template buffer.
+    size_t ibDst;           // Current destination offset (keeps counting past cbDst).
+} COMPILER;
+
+// Static function prototypes.
+static void ReadAnchor(PDLGANCHOR, uint32_t, uint16_t, const uint16_t *);
+static int SkipNameOrd(COMPILER *);
+static void Emit(COMPILER *, const void *, size_t);
+static void EmitWord(COMPILER *, uint16_t);
+static void EmitAlign(COMPILER *);
+
+// Inline functions (one-liners).
+static inline uint16_t ReadWord(const uint8_t *pb) { uint16_t w; memcpy(&w, pb, sizeof(w)); return w; }
+static inline uint32_t ReadDWord(const uint8_t *pb) { uint32_t dw; memcpy(&dw, pb, sizeof(dw)); return dw; }
+static inline int HasBytes(const COMPILER *pc, size_t cb) { return pc->ibSrc <= pc->cbSrc && pc->cbSrc - pc->ibSrc >= cb; }
+
+/****************************************************************************
+ *                                                                          *
+ * Function: DlgGetItemCount                                                *
+ *                                                                          *
+ * Purpose : Return number of controls in extended dialog template, or -1.  *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+int DlgGetItemCount(const void *pvSrc, size_t cbSrc)
+{
+    const uint8_t *pb = pvSrc;
+
+    if (cbSrc < OFS_DLG_MENU || ReadWord(pb + OFS_DLG_VERSION) != 1 || ReadWord(pb + OFS_DLG_SIGNATURE) != 0xFFFF)
+        return -1;
+
+    return ReadWord(pb + OFS_DLG_ITEMCOUNT);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: DlgCompileTemplate                                             *
+ *                                                                          *
+ * Purpose : Copy an extended dialog template in a single pass, stripping   *
+ *           our creation data and collecting the anchor records. Every     *
+ *           read is checked against cbSrc. The compiled template is never  *
+ *           larger than the source, so cbDst == cbSrc is always enough.    *
+ *           On DLGT_E_NOSPACE the required sizes are still returned.       *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+int DlgCompileTemplate(const void *pvSrc, size_t cbSrc, void *pvDst, size_t cbDst,
+    PDLGANCHOR pAnchors, size_t cAnchorsMax, PDLGCOMPILEINFO pInfo)
+{
+    COMPILER c = { pvSrc, cbSrc, 0, pvDst, cbDst, 0 };
+    size_t cAnchors = 0;
+    uint32_t style;
+    uint16_t cDlgItems;
+    uint16_t i;
+
+    memset(pInfo, 0, sizeof(*pInfo));
+
+    // Must have an extended dialog.
+    if (DlgGetItemCount(pvSrc, cbSrc) < 0)
+        return DLGT_E_NOTEXTENDED;
+
+    style = ReadDWord(c.pbSrc + OFS_DLG_STYLE);
+    cDlgItems = ReadWord(c.pbSrc + OFS_DLG_ITEMCOUNT);
+
+    // Skip fixed part, menu, class, and window title.
+    c.ibSrc = OFS_DLG_MENU;
+    if (!SkipNameOrd(&c) || !SkipNameOrd(&c) || !SkipNameOrd(&c))
+        return DLGT_E_TRUNCATED;
+
+    // Font specification present?
+    if ((style & DLGT_DS_SETFONT) != 0)
+    {
+        // Skip point size, weight, italic, and charset.
+        if (!HasBytes(&c, 2 * sizeof(uint16_t) + 2 * sizeof(uint8_t)))
+            return DLGT_E_TRUNCATED;
+        c.ibSrc += 2 * sizeof(uint16_t) + 2 * sizeof(uint8_t);
+
+        // Skip typeface.
+        if (!SkipNameOrd(&c))
+            return DLGT_E_TRUNCATED;
+    }
+
+    // Append dialog header to new template.
+    Emit(&c, c.pbSrc, c.ibSrc);
+
+    // Process the controls.
+    for (i = 0; i < cDlgItems; i++)
+    {
+        size_t ibItem;
+        uint16_t cbExtraData;
+
+        // Align (but never pad beyond the last control).
+        EmitAlign(&c);
+        c.ibSrc = ibItem = ROUNDUP(c.ibSrc, sizeof(uint32_t));
+
+        // Skip fixed part, window class, and window title.
+        if (!HasBytes(&c, OFS_ITEM_CLASS))
+            return DLGT_E_TRUNCATED;
+        c.ibSrc += OFS_ITEM_CLASS;
+        if (!SkipNameOrd(&c) || !SkipNameOrd(&c))
+            return DLGT_E_TRUNCATED;
+
+        // Append item header to new template.
+        Emit(&c, c.pbSrc + ibItem, c.ibSrc - ibItem);
+
+        // Process control creation data.
+        if (!HasBytes(&c, sizeof(uint16_t)))
+            return DLGT_E_TRUNCATED;
+        cbExtraData = ReadWord(c.pbSrc + c.ibSrc);
+        c.ibSrc += sizeof(uint16_t);
+        if (!HasBytes(&c, cbExtraData))
+            return DLGT_E_TRUNCATED;
+
+        // Look for our version of "creation data" (either version).
+        if ((cbExtraData == sizeof(EXTRADATA) &&
+             ReadWord(c.pbSrc + c.ibSrc + offsetof(EXTRADATA, magic)) == EXTRA_MAGIC &&
+             ReadWord(c.pbSrc + c.ibSrc + offsetof(EXTRADATA, version)) == EXTRA_VERSION) ||
+            (cbExtraData == sizeof(EXTRADATA2) &&
+             ReadWord(c.pbSrc + c.ibSrc + offsetof(EXTRADATA2, magic)) == EXTRA_MAGIC &&
+             ReadWord(c.pbSrc + c.ibSrc + offsetof(EXTRADATA2, version)) == EXTRA_VERSION2))
+        {
+            uint32_t id = ReadDWord(c.pbSrc + ibItem + OFS_ITEM_ID);
+
+            // Avoid "nameless" controls.
+            if (id != (uint32_t)-1)
+            {
+                // Found a control to handle during resize.
+                if (cAnchors < cAnchorsMax && pAnchors != NULL)
+                {
+                    uint16_t awShare[4] = {0};
+                    int iEdge;
+
+                    if (cbExtraData == sizeof(EXTRADATA2))
+                    {
+                        for (iEdge = 0; iEdge < 4; iEdge++)
+                            awShare[iEdge] = ReadWord(c.pbSrc + c.ibSrc + offsetof(EXTRADATA2, awShare) + iEdge * sizeof(uint16_t));
+                    }
+
+                    ReadAnchor(&pAnchors[cAnchors], id, ReadWord(c.pbSrc + c.ibSrc + offsetof(EXTRADATA, fuAlign)), awShare);
+                }
+                cAnchors++;
+            }
+
+            // Strip away creation data.
+            EmitWord(&c, 0);
+        }
+        else
+        {
+            // Append user-defined creation data.
+            EmitWord(&c, cbExtraData);
+            Emit(&c, c.pbSrc + c.ibSrc, cbExtraData);
+        }
+        c.ibSrc += cbExtraData;
+    }
+
+    pInfo->cbSource = c.ibSrc;
+    pInfo->cbTemplate = c.ibDst;
+    pInfo->cAnchors = cAnchors;
+    pInfo->cDlgItems = cDlgItems;
+
+    if (c.ibDst > c.cbDst || c.pbDst == NULL || cAnchors > cAnchorsMax)
+        return DLGT_E_NOSPACE;
+
+    // Make the dialog resizable.
+    if (cAnchors > 0)
+    {
+        style |= DLGT_WS_THICKFRAME;
+        memcpy(c.pbDst + OFS_DLG_STYLE, &style, sizeof(style));
+    }
+
+    return DLGT_OK;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: DlgCheckAnchorTable                                            *
+ *                                                                          *
+ * Purpose : Validate an anchor table produced by the resanchor tool.       *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+int DlgCheckAnchorTable(const void *pvTable, size_t cbTable)
+{
+    const uint8_t *pb = pvTable;
+    uint32_t cAnchors;
+    size_t cbAnchor;
+
+    if (cbTable < offsetof(ANCHORTABLE, aAnchors))
+        return DLGT_E_TRUNCATED;
+
+    if (ReadWord(pb + offsetof(ANCHORTABLE, magic)) != EXTRA_MAGIC)
+        return DLGT_E_BADTABLE;
+
+    switch (ReadWord(pb + offsetof(ANCHORTABLE, version)))
+    {
+        case ANCHORTABLE_VERSION: cbAnchor = sizeof(DLGANCHOR); break;
+        case ANCHORTABLE_VERSION1: cbAnchor = CB_ANCHOR_V1; break;
+        default: return DLGT_E_BADTABLE;
+    }
+
+    cAnchors = ReadDWord(pb + offsetof(ANCHORTABLE, cAnchors));
+    if (cAnchors > (cbTable - offsetof(ANCHORTABLE, aAnchors)) / cbAnchor)
+        return DLGT_E_TRUNCATED;
+
+    return DLGT_OK;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: DlgReadAnchorTable                                             *
+ *                                                                          *
+ * Purpose : Copy the records from a checked anchor table; version 1        *
+ *           records are converted. Current tables can be used in place.    *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+void DlgReadAnchorTable(const void *pvTable, PDLGANCHOR pAnchors)
+{
+    const uint8_t *pb = pvTable;
+    uint32_t cAnchors = ReadDWord(pb + offsetof(ANCHORTABLE, cAnchors));
+    uint32_t i;
+
+    pb += offsetof(ANCHORTABLE, aAnchors);
+
+    if (ReadWord((const uint8_t *)pvTable + offsetof(ANCHORTABLE, version)) == ANCHORTABLE_VERSION)
+    {
+        memcpy(pAnchors, pb, cAnchors * sizeof(DLGANCHOR));
+    }
+    else
+    {
+        static const uint16_t awNone[4] = {0};
+
+        for (i = 0; i < cAnchors; i++, pb += CB_ANCHOR_V1)
+            ReadAnchor(&pAnchors[i], ReadDWord(pb + offsetof(DLGANCHOR, id)), ReadWord(pb + offsetof(DLGANCHOR, fuAlign)), awNone);
+    }
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: DlgHashBytes                                                   *
+ *                                                                          *
+ * Purpose : Return 64-bit FNV-1a hash of a template (or anything else).    *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+uint64_t DlgHashBytes(const void *pv, size_t cb)
+{
+    return DlgHashMore(0xCBF29CE484222325ULL, pv, cb);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: DlgHashMore                                                    *
+ *                                                                          *
+ * Purpose : Continue a DlgHashBytes hash with more bytes.                  *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+uint64_t DlgHashMore(uint64_t hash, const void *pv, size_t cb)
+{
+    const uint8_t *pb = pv;
+
+    while (cb-- > 0)
+    {
+        hash ^= *pb++;
+        hash *= 0x100000001B3ULL;
+    }
+
+    return hash;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ReadAnchor                                                     *
+ *                                                                          *
+ * Purpose : Fill in an anchor record; flagged edges get all of the size    *
+ *           change, the others their share (if any).                       *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static void ReadAnchor(PDLGANCHOR pAnchor, uint32_t id, uint16_t fuAlign, const uint16_t *pwShare)
+{
+    static const uint16_t afuEdge[4] = { RESIZER_LEFT, RESIZER_TOP, RESIZER_RIGHT, RESIZER_BOTTOM };
+    int iEdge;
+
+    pAnchor->id = id;
+    pAnchor->fuAlign = 0;
+    pAnchor->wReserved = 0;
+
+    for (iEdge = 0; iEdge < 4; iEdge++)
+    {
+        unsigned int uShare = (fuAlign & afuEdge[iEdge]) ? 100 : (pwShare[iEdge] < 100) ? pwShare[iEdge] : 100;
+
+        pAnchor->abShare[iEdge] = (uint8_t)uShare;
+        if (uShare != 0)
+            pAnchor->fuAlign |= afuEdge[iEdge];
+    }
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: SkipNameOrd                                                    *
+ *                                                                          *
+ * Purpose : Skip name/ordinal value; return zero if past end of input.     *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int SkipNameOrd(COMPILER *pc)
+{
+    const uint8_t *pb, *pbEnd;
+
+    if (!HasBytes(pc, sizeof(uint16_t)))
+        return 0;
+
+    // Ordinal value: 0xFFFF followed by the ordinal.
+    if (ReadWord(pc->pbSrc + pc->ibSrc) == 0xFFFF)
+    {
+        if (!HasBytes(pc, 2 * sizeof(uint16_t)))
+            return 0;
+        pc->ibSrc += 2 * sizeof(uint16_t);
+        return 1;
+    }
+
+    // Name: zero-terminated UTF-16 string.
+    pbEnd = pc->pbSrc + pc->ibSrc + ((pc->cbSrc - pc->ibSrc) & ~(size_t)1);
+    for (pb = pc->pbSrc + pc->ibSrc; pb < pbEnd; pb += sizeof(uint16_t))
+    {
+        if (pb[0] == 0 && pb[1] == 0)
+        {
+            pc->ibSrc = (pb - pc->pbSrc) + sizeof(uint16_t);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Emit                                                           *
+ *                                                                          *
+ * Purpose : Append bytes to the compiled template, if there is room.       *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static void Emit(COMPILER *pc, const void *pv, size_t cb)
+{
+    if (pc->pbDst != NULL && pc->ibDst <= pc->cbDst && cb <= pc->cbDst - pc->ibDst)
+        memcpy(pc->pbDst + pc->ibDst, pv, cb);
+    pc->ibDst += cb;
+}
+
+static void EmitWord(COMPILER *pc, uint16_t w)
+{
+    Emit(pc, &w, sizeof(w));
+}
+
+static void EmitAlign(COMPILER *pc)
+{
+    static const uint8_t abZero[sizeof(uint32_t)] = {0};
+    Emit(pc, abZero, ROUNDUP(pc->ibDst, sizeof(uint32_t)) - pc->ibDst);
+}
@@ -0,0 +1,106 @@
+/****************************************************************************
+ *                                                                          *
+ * File    : dlgtmpl.h                                                      *
+ *                                                                          *
+ * Purpose : Definitions for the portable dialog template compiler.         *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+#ifndef _DLGTMPL_H
+#define _DLGTMPL_H
+
+/*
+ * Nothing in here depends on <windows.h>, so the template compiler can be
+ * built, tested and profiled on any host with a C99 compiler.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+// fuAlign flags.
+#define RESIZER_NONE    0x0000
+#define RESIZER_LEFT    0x0001
+#define RESIZER_RIGHT   0x0002
+#define RESIZER_TOP     0x0004
+#define RESIZER_BOTTOM  0x0008
+#define RESIZER_HORZ    (RESIZER_LEFT|RESIZER_RIGHT)
+#define RESIZER_VERT    (RESIZER_TOP|RESIZER_BOTTOM)
+
+#define EXTRA_MAGIC     0xC0DE
+#define EXTRA_VERSION   1
+#define EXTRA_VERSION2  2
+
+// Control creation data understood by the Resizer (all WORDs, no padding).
+typedef struct EXTRADATA {
+    uint16_t magic;         // Magic number (EXTRA_MAGIC).
+    uint16_t version;       // Version (EXTRA_VERSION).
+    uint16_t fuAlign;       // Alignment flags.
+} EXTRADATA, *PEXTRADATA;
+typedef const struct EXTRADATA *PCEXTRADATA;
+
+// Edges, for shares.
+#define EDGE_LEFT    0
+#define EDGE_TOP     1
+#define EDGE_RIGHT   2
+#define EDGE_BOTTOM  3
+
+// Version 2 creation data; edges may follow part of the size change (like 50 = centered, with left and right).
+typedef struct EXTRADATA2 {
+    uint16_t magic;         // Magic number (EXTRA_MAGIC).
+    uint16_t version;       // Version (EXTRA_VERSION2).
+    uint16_t fuAlign;       // Alignment flags; a flagged edge follows all of the size change.
+    uint16_t awShare[4];    // Share of the size change, in percent (0-100), for each edge (EDGE_*).
+} EXTRADATA2, *PEXTRADATA2;
+typedef const struct EXTRADATA2 *PCEXTRADATA2;
+
+// Anchor record, one for each control handled during resize (12 bytes, also in anchor tables).
+typedef struct DLGANCHOR {
+    uint32_t id;            // Control id.
+    uint16_t fuAlign;       // Alignment flags (RESIZER_*), for edges with a share.
+    uint16_t wReserved;     // Zero.
+    uint8_t abShare[4];     // Share of the size change, in percent (0-100), for each edge (EDGE_*).
+} DLGANCHOR, *PDLGANCHOR;
+typedef const struct DLGANCHOR *PCDLGANCHOR;
+
+// Anchor table version; version 1 tables have 8 byte records, without shares.
+#define ANCHORTABLE_VERSION   2
+#define ANCHORTABLE_VERSION1  1
+#define CB_ANCHOR_V1          8
+
+// Anchor table resource, as written by the resanchor tool; same name as the dialog.
+typedef struct ANCHORTABLE {
+    uint16_t magic;         // Magic number (EXTRA_MAGIC).
+    uint16_t version;       // Version (ANCHORTABLE_VERSION).
+    uint32_t cAnchors;      // Number of anchor records following.
+    DLGANCHOR aAnchors[];   // Anchor records.
+} ANCHORTABLE, *PANCHORTABLE;
+typedef const struct ANCHORTABLE *PCANCHORTABLE;
+
+// Information returned by DlgCompileTemplate().
+typedef struct DLGCOMPILEINFO {
+    size_t cbSource;        // Size of the source template, in bytes.
+    size_t cbTemplate;      // Size of the compiled template, in bytes.
+    size_t cAnchors;        // Number of anchor records.
+    uint16_t cDlgItems;     // Number of controls in the template.
+} DLGCOMPILEINFO, *PDLGCOMPILEINFO;
+
+// Return codes from DlgCompileTemplate().
+#define DLGT_OK              0  // Success.
+#define DLGT_E_NOTEXTENDED   1  // Not an extended dialog template (DLGTEMPLATEEX).
+#define DLGT_E_TRUNCATED     2  // Template runs past the end of the input.
+#define DLGT_E_NOSPACE       3  // Output buffer or anchor array too small; see DLGCOMPILEINFO.
+#define DLGT_E_BADTABLE      4  // Not a valid anchor table.
+
+/****** Function prototypes ************************************************/
+
+int DlgGetItemCount(const void * /*pvSrc*/, size_t /*cbSrc*/);
+int DlgCompileTemplate(const void * /*pvSrc*/, size_t /*cbSrc*/, void * /*pvDst*/, size_t /*cbDst*/, PDLGANCHOR /*pAnchors*/, size_t /*cAnchorsMax*/, PDLGCOMPILEINFO /*pInfo*/);
+int DlgCheckAnchorTable(const void * /*pvTable*/, size_t /*cbTable*/);
+void DlgReadAnchorTable(const void * /*pvTable*/, PDLGANCHOR /*pAnchors*/);
+uint64_t DlgHashBytes(const void * /*pv*/, size_t /*cb*/);
+uint64_t DlgHashMore(uint64_t /*hash*/, const void * /*pv*/, size_t /*cb*/);
+
+#endif /* _DLGTMPL_H */
@@ -0,0 +1,275 @@
+/****************************************************************************
+ *                                                                          *
+ * File    : layout.c                                                       *
+ *                                                                          *
+ * Purpose : Portable anchor layout engine.                                 *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+#include <string.h>
+#include "layout.h"
+
+// Number of int32_t arrays in the layout table.
+#define LAYOUT_ARRAYS  8
+
+// Number of uint32_t index arrays (LAYOUT_HORZ, LAYOUT_VERT, LAYOUT_BOTH).
+#define LAYOUT_SETS  3
+
+// Static function prototypes.
+static int32_t ScaleValue(int32_t, int32_t, int32_t);
+
+// Inline functions (one-liners).
+static inline int32_t ShareFromPercent(unsigned int uPercent) { return (int32_t)((uPercent * LAYOUT_ONE + 50) / 100); }
+static inline int32_t ApplyShare(int32_t d, int32_t share) { return (int32_t)(((int64_t)d * share + LAYOUT_ONE / 2) >> 16); }  /* 64-bit; d * LAYOUT_ONE overflows past 32767 */
+
+/****************************************************************************
+ *                                                                          *
+ * Function: LayoutGetSize                                                  *
+ *                                                                          *
+ * Purpose : Return number of bytes needed for a layout table.              *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+size_t LayoutGetSize(size_t cItems)
+{
+    return LAYOUT_ARRAYS * cItems * sizeof(int32_t) + LAYOUT_SETS * cItems * sizeof(uint32_t);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: LayoutInit                                                     *
+ *                                                                          *
+ * Purpose : Initialize layout table, using memory from the caller.         *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+void LayoutInit(PLAYOUT pLayout, void *pvMem, size_t cItems)
+{
+    int32_t *p = pvMem;
+
+    memset(pvMem, 0, LayoutGetSize(cItems));
+
+    pLayout->cItems = cItems;
+    pLayout->pLeft = p; p += cItems;
+    pLayout->pTop = p; p += cItems;
+    pLayout->pRight = p; p += cItems;
+    pLayout->pBottom = p; p += cItems;
+    pLayout->pShareLeft = p; p += cItems;
+    pLayout->pShareTop = p; p += cItems;
+    pLayout->pShareRight = p; p += cItems;
+    pLayout->pShareBottom = p; p += cItems;
+
+    // Dirty sets; empty until LayoutBuildDirtySets().
+    pLayout->apDirty[0] = NULL;
+    pLayout->apDirty[LAYOUT_HORZ] = (uint32_t *)p;
+    pLayout->apDirty[LAYOUT_VERT] = pLayout->apDirty[LAYOUT_HORZ] + cItems;
+    pLayout->apDirty[LAYOUT_BOTH] = pLayout->apDirty[LAYOUT_VERT] + cItems;
+    memset(pLayout->acDirty, 0, sizeof(pLayout->acDirty));
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: LayoutSetItem                                                  *
+ *                                                                          *
+ * Purpose : Set the anchors for a control.                                 *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+void LayoutSetItem(PLAYOUT pLayout, size_t i, PCDLGANCHOR pAnchor)
+{
+    pLayout->pShareLeft[i] = ShareFromPercent(pAnchor->abShare[EDGE_LEFT]);
+    pLayout->pShareTop[i] = ShareFromPercent(pAnchor->abShare[EDGE_TOP]);
+    pLayout->pShareRight[i] = ShareFromPercent(pAnchor->abShare[EDGE_RIGHT]);
+    pLayout->pShareBottom[i] = ShareFromPercent(pAnchor->abShare[EDGE_BOTTOM]);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: LayoutBuildDirtySets                                           *
+ *                                                                          *
+ * Purpose : Find the controls that move when the width changes, when the   *
+ *           height changes, and when both change. Call after all anchors   *
+ *           are set.                                                       *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+void LayoutBuildDirtySets(PLAYOUT pLayout)
+{
+    size_t cHorz = 0, cVert = 0, cBoth = 0;
+    size_t i;
+
+    for (i = 0; i < pLayout->cItems; i++)
+    {
+        int fHorz = (pLayout->pShareLeft[i] | pLayout->pShareRight[i]) != 0;
+        int fVert = (pLayout->pShareTop[i] | pLayout->pShareBottom[i]) != 0;
+
+        if (fHorz) pLayout->apDirty[LAYOUT_HORZ][cHorz++] = (uint32_t)i;
+        if (fVert) pLayout->apDirty[LAYOUT_VERT][cVert++] = (uint32_t)i;
+        if (fHorz || fVert) pLayout->apDirty[LAYOUT_BOTH][cBoth++] = (uint32_t)i;
+    }
+
+    pLayout->acDirty[LAYOUT_HORZ] = cHorz;
+    pLayout->acDirty[LAYOUT_VERT] = cVert;
+    pLayout->acDirty[LAYOUT_BOTH] = cBoth;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: LayoutGetDirtySet                                              *
+ *                                                                          *
+ * Purpose : Return the controls that move when the given axes change.      *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+size_t LayoutGetDirtySet(PCLAYOUT pLayout, unsigned int fAxes, const uint32_t **ppIndex)
+{
+    fAxes &= LAYOUT_BOTH;
+
+    *ppIndex = pLayout->apDirty[fAxes];
+    return pLayout->acDirty[fAxes];
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: LayoutSetBase                                                  *
+ *                                                                          *
+ * Purpose : Set the base rectangle for a control, from the current         *
+ *           rectangle and the total delta it was laid out for.             *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+void LayoutSetBase(PLAYOUT pLayout, size_t i, PCLAYOUTRECT prcCur, int32_t dx, int32_t dy)
+{
+    pLayout->pLeft[i] = prcCur->left - ApplyShare(dx, pLayout->pShareLeft[i]);
+    pLayout->pTop[i] = prcCur->top - ApplyShare(dy, pLayout->pShareTop[i]);
+    pLayout->pRight[i] = prcCur->right - ApplyShare(dx, pLayout->pShareRight[i]);
+    pLayout->pBottom[i] = prcCur->bottom - ApplyShare(dy, pLayout->pShareBottom[i]);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: LayoutScale                                                    *
+ *                                                                          *
+ * Purpose : Scale all base rectangles by num/den (like for a DPI change).  *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+void LayoutScale(PLAYOUT pLayout, int32_t num, int32_t den)
+{
+    size_t i;
+
+    if (den <= 0 || num == den)
+        return;
+
+    for (i = 0; i < pLayout->cItems; i++)
+    {
+        pLayout->pLeft[i] = ScaleValue(pLayout->pLeft[i], num, den);
+        pLayout->pTop[i] = ScaleValue(pLayout->pTop[i], num, den);
+        pLayout->pRight[i] = ScaleValue(pLayout->pRight[i], num, den);
+        pLayout->pBottom[i] = ScaleValue(pLayout->pBottom[i], num, den);
+    }
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: LayoutCompute                                                  *
+ *                                                                          *
+ * Purpose : Compute all control rectangles for the given total delta.      *
+ *           No branches in the loop, so it's easy to vectorize. The delta  *
+ *           is scaled in 64 bits, so any int32_t delta will do.            *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+void LayoutCompute(PCLAYOUT pLayout, int32_t dx, int32_t dy, PLAYOUTRECT prcOut)
+{
+    const int32_t * restrict pLeft = pLayout->pLeft;
+    const int32_t * restrict pTop = pLayout->pTop;
+    const int32_t * restrict pRight = pLayout->pRight;
+    const int32_t * restrict pBottom = pLayout->pBottom;
+    const int32_t * restrict pShareLeft = pLayout->pShareLeft;
+    const int32_t * restrict pShareTop = pLayout->pShareTop;
+    const int32_t * restrict pShareRight = pLayout->pShareRight;
+    const int32_t * restrict pShareBottom = pLayout->pShareBottom;
+    size_t i;
+
+    for (i = 0; i < pLayout->cItems; i++)
+    {
+        prcOut[i].left = pLeft[i] + ApplyShare(dx, pShareLeft[i]);
+        prcOut[i].top = pTop[i] + ApplyShare(dy, pShareTop[i]);
+        prcOut[i].right = pRight[i] + ApplyShare(dx, pShareRight[i]);
+        prcOut[i].bottom = pBottom[i] + ApplyShare(dy, pShareBottom[i]);
+    }
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: LayoutComputeSet                                               *
+ *                                                                          *
+ * Purpose : Compute rectangles for a set of controls, for the given total  *
+ *           delta. Rectangle k is for control pIndex[k].                   *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+void LayoutComputeSet(PCLAYOUT pLayout, int32_t dx, int32_t dy, const uint32_t *pIndex, size_t cIndex, PLAYOUTRECT prcOut)
+{
+    size_t k;
+
+    for (k = 0; k < cIndex; k++)
+    {
+        uint32_t i = pIndex[k];
+
+        prcOut[k].left = pLayout->pLeft[i] + ApplyShare(dx, pLayout->pShareLeft[i]);
+        prcOut[k].top = pLayout->pTop[i] + ApplyShare(dy, pLayout->pShareTop[i]);
+        prcOut[k].right = pLayout->pRight[i] + ApplyShare(dx, pLayout->pShareRight[i]);
+        prcOut[k].bottom = pLayout->pBottom[i] + ApplyShare(dy, pLayout->pShareBottom[i]);
+    }
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ScaleValue                                                     *
+ *                                                                          *
+ * Purpose : Return value * num / den, rounded like MulDiv() (den > 0).     *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int32_t ScaleValue(int32_t value, int32_t num, int32_t den)
+{
+    int64_t n = (int64_t)value * num;
+
+    // Round half away from zero.
+    return (int32_t)((n >= 0) ? (n + den / 2) / den : (n - den / 2) / den);
+}
@@ -0,0 +1,71 @@
+/****************************************************************************
+ *                                                                          *
+ * File    : layout.h                                                       *
+ *                                                                          *
+ * Purpose : Definitions for the portable anchor layout engine.             *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+#ifndef _LAYOUT_H
+#define _LAYOUT_H
+
+/*
+ * Like the template compiler, the layout engine doesn't depend on
+ * <windows.h>. A control rectangle is a pure function of the rectangle
+ * captured at the original dialog size, the anchor shares, and the total
+ * change of the client area size since then.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "dlgtmpl.h"
+
+// Rectangle, in dialog client coordinates (same layout as RECT).
+typedef struct LAYOUTRECT {
+    int32_t left;
+    int32_t top;
+    int32_t right;
+    int32_t bottom;
+} LAYOUTRECT, *PLAYOUTRECT;
+typedef const struct LAYOUTRECT *PCLAYOUTRECT;
+
+// Axes of change, for LayoutGetDirtySet().
+#define LAYOUT_HORZ  0x0001
+#define LAYOUT_VERT  0x0002
+#define LAYOUT_BOTH  (LAYOUT_HORZ|LAYOUT_VERT)
+
+// All of the delta, in 16.16 fixed point.
+#define LAYOUT_ONE  0x10000
+
+// Layout table; structure of arrays, one element for each control.
+typedef struct LAYOUT {
+    size_t cItems;          // Number of controls.
+    int32_t *pLeft;         // Base rectangles, at the original size...
+    int32_t *pTop;
+    int32_t *pRight;
+    int32_t *pBottom;
+    int32_t *pShareLeft;    // ...and share of the delta for each edge, 16.16 fixed point (LAYOUT_ONE = all).
+    int32_t *pShareTop;
+    int32_t *pShareRight;
+    int32_t *pShareBottom;
+    uint32_t *apDirty[4];   // Indexes of controls that move, for each LAYOUT_* combination...
+    size_t acDirty[4];      // ...and number of indexes.
+} LAYOUT, *PLAYOUT;
+typedef const struct LAYOUT *PCLAYOUT;
+
+/****** Function prototypes ************************************************/
+
+size_t LayoutGetSize(size_t /*cItems*/);
+void LayoutInit(PLAYOUT /*pLayout*/, void * /*pvMem*/, size_t /*cItems*/);
+void LayoutSetItem(PLAYOUT /*pLayout*/, size_t /*i*/, PCDLGANCHOR /*pAnchor*/);
+void LayoutBuildDirtySets(PLAYOUT /*pLayout*/);
+size_t LayoutGetDirtySet(PCLAYOUT /*pLayout*/, unsigned int /*fAxes*/, const uint32_t ** /*ppIndex*/);
+void LayoutSetBase(PLAYOUT /*pLayout*/, size_t /*i*/, PCLAYOUTRECT /*prcCur*/, int32_t /*dx*/, int32_t /*dy*/);
+void LayoutScale(PLAYOUT /*pLayout*/, int32_t /*num*/, int32_t /*den*/);
+void LayoutCompute(PCLAYOUT /*pLayout*/, int32_t /*dx*/, int32_t /*dy*/, PLAYOUTRECT /*prcOut*/);
+void LayoutComputeSet(PCLAYOUT /*pLayout*/, int32_t /*dx*/, int32_t /*dy*/, const uint32_t * /*pIndex*/, size_t /*cIndex*/, PLAYOUTRECT /*prcOut*/);
+
+#endif /* _LAYOUT_H */
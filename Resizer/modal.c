@@ -0,0 +1,85 @@
+/****************************************************************************
+ *                                                                          *
+ * File    : modal.c                                                        *
+ *                                                                          *
+ * Purpose : Portable modal dialog hand-over.                               *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+#include "modal.h"
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ModalPush                                                      *
+ *                                                                          *
+ * Purpose : Make a context pending on this thread; call right before       *
+ *           creating the dialog.                                           *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+void ModalPush(PCMODALSLOT pSlot, PMODALLINK pLink)
+{
+    pLink->pPrev = pSlot->pfnGet();
+    pSlot->pfnSet(pLink);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ModalClaim                                                     *
+ *                                                                          *
+ * Purpose : Take the newest pending context on this thread, for the first  *
+ *           message of a new dialog; NULL if there is none.                *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+PMODALLINK ModalClaim(PCMODALSLOT pSlot)
+{
+    PMODALLINK pLink;
+
+    if ((pLink = pSlot->pfnGet()) != NULL)
+        pSlot->pfnSet(pLink->pPrev);
+
+    return pLink;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ModalPop                                                       *
+ *                                                                          *
+ * Purpose : Forget a context that was never claimed (the dialog failed     *
+ *           before its first message); call after the dialog is gone.      *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+void ModalPop(PCMODALSLOT pSlot, PMODALLINK pLink)
+{
+    PMODALLINK p;
+
+    // Normally on top, if still there at all.
+    if ((p = pSlot->pfnGet()) == pLink)
+    {
+        pSlot->pfnSet(pLink->pPrev);
+        return;
+    }
+
+    for (; p != NULL; p = p->pPrev)
+    {
+        if (p->pPrev == pLink)
+        {
+            p->pPrev = pLink->pPrev;
+            break;
+        }
+    }
+}
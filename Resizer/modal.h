@@ -0,0 +1,44 @@
+/****************************************************************************
+ *                                                                          *
+ * File    : modal.h                                                        *
+ *                                                                          *
+ * Purpose : Definitions for the portable modal dialog hand-over.           *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+#ifndef _MODAL_H
+#define _MODAL_H
+
+/*
+ * Like the layout engine, this doesn't depend on <windows.h>. A modal
+ * dialog gets nothing from its creator before WM_INITDIALOG, and some
+ * messages (WM_SETFONT) come first. So the creator pushes a context on
+ * a stack for its own thread, and the first message for the new dialog
+ * claims the newest one. Dialogs created from WM_INITDIALOG nest. The
+ * host keeps the top of the stack in a per-thread slot (TLS, on Windows).
+ */
+
+#include <stddef.h>
+
+// Pending context; the first member of the host's context.
+typedef struct MODALLINK {
+    struct MODALLINK *pPrev;  // Next older pending context, on this thread.
+} MODALLINK, *PMODALLINK;
+
+// Per-thread slot, holding the newest pending context (or NULL).
+typedef struct MODALSLOT {
+    PMODALLINK (*pfnGet)(void);
+    void (*pfnSet)(PMODALLINK);
+} MODALSLOT, *PMODALSLOT;
+typedef const struct MODALSLOT *PCMODALSLOT;
+
+/****** Function prototypes ************************************************/
+
+void ModalPush(PCMODALSLOT /*pSlot*/, PMODALLINK /*pLink*/);
+PMODALLINK ModalClaim(PCMODALSLOT /*pSlot*/);
+void ModalPop(PCMODALSLOT /*pSlot*/, PMODALLINK /*pLink*/);
+
+#endif /* _MODAL_H */
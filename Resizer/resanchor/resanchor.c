@@ -0,0 +1,426 @@
+/****************************************************************************
+ *                                                                          *
+ * File    : resanchor.c                                                    *
+ *                                                                          *
+ * Purpose : Resizer anchor extraction tool.                                *
+ *                                                                          *
+ *           Reads a compiled resource (.res) file, and for every extended  *
+ *           dialog with Resizer creation data: strips the creation data,   *
+ *           makes the dialog resizable, and adds an anchor table resource  *
+ *           (type "RESIZER", same name and language as the dialog). The    *
+ *           Resizer runtime then uses the dialog template as-is.           *
+ *                                                                          *
+ *           Only uses the C99 standard library; builds on any host.        *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../dlgtmpl.h"
+
+#define ROUNDUP(n,m)  (((n)+((m)-1)) & (~((m)-1)))
+
+#define RT_DIALOG  5
+
+// Type name of the anchor table resource (UTF-16, with terminator).
+static const uint16_t awAnchorType[] = { 'R','E','S','I','Z','E','R',0 };
+
+// Output buffer.
+typedef struct OUTBUF {
+    uint8_t *pb;            // Data.
+    size_t cb;              // Bytes used.
+    size_t cbMax;           // Bytes allocated.
+} OUTBUF;
+
+// Resource entry, as found in the .res file.
+typedef struct RESENTRY {
+    const uint8_t *pbHeader;  // Resource header.
+    size_t cbHeader;        // Size of resource header.
+    const uint8_t *pbData;  // Resource data.
+    size_t cbData;          // Size of resource data.
+    const uint8_t *pbName;  // Resource name (name/ordinal, in header).
+    size_t cbName;          // Size of resource name.
+    int fDialog;            // Type is RT_DIALOG?
+} RESENTRY;
+
+// Static function prototypes.
+static uint8_t *ReadWholeFile(const char *, size_t *);
+static int WriteWholeFile(const char *, const void *, size_t);
+static int ParseEntry(const uint8_t *, size_t, RESENTRY *, size_t *);
+static size_t NameOrdSize(const uint8_t *, size_t);
+static int Append(OUTBUF *, const void *, size_t);
+static int AppendDWord(OUTBUF *, uint32_t);
+static int AppendAlign(OUTBUF *);
+static int AppendEntry(OUTBUF *, const RESENTRY *, const void *, size_t);
+static int AppendAnchorTable(OUTBUF *, const RESENTRY *, const DLGANCHOR *, size_t);
+
+// Inline functions (one-liners).
+static inline uint16_t ReadWord(const uint8_t *pb) { return (uint16_t)(pb[0] | (pb[1] << 8)); }
+static inline uint32_t ReadDWord(const uint8_t *pb) { return pb[0] | (pb[1] << 8) | ((uint32_t)pb[2] << 16) | ((uint32_t)pb[3] << 24); }
+
+/****************************************************************************
+ *                                                                          *
+ * Function: main                                                           *
+ *                                                                          *
+ * Purpose : Main entry point.                                              *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+int main(int argc, char *argv[])
+{
+    OUTBUF out = {0};
+    uint8_t *pbRes;
+    size_t cbRes;
+    size_t ib;
+    size_t cDialogs = 0, cAnchorsTotal = 0, cbStripped = 0;
+
+    if (argc != 3)
+    {
+        fprintf(stderr, "Usage: resanchor <input.res> <output.res>\n");
+        return 1;
+    }
+
+    if ((pbRes = ReadWholeFile(argv[1], &cbRes)) == NULL)
+    {
+        fprintf(stderr, "resanchor: can't read '%s'\n", argv[1]);
+        return 1;
+    }
+
+    for (ib = 0; ib < cbRes; )
+    {
+        RESENTRY entry;
+        size_t cbEntry;
+        int fDone = 0;
+
+        if (!ParseEntry(pbRes + ib, cbRes - ib, &entry, &cbEntry))
+        {
+            fprintf(stderr, "resanchor: '%s' is damaged at offset %zu\n", argv[1], ib);
+            return 1;
+        }
+
+        // Extended dialog template, with some controls?
+        if (entry.fDialog && DlgGetItemCount(entry.pbData, entry.cbData) > 0)
+        {
+            int cDlgItems = DlgGetItemCount(entry.pbData, entry.cbData);
+            DLGANCHOR *pAnchors = malloc(cDlgItems * sizeof(DLGANCHOR));
+            uint8_t *pbNew = malloc(entry.cbData);
+            DLGCOMPILEINFO info;
+
+            if (pAnchors == NULL || pbNew == NULL)
+            {
+                fprintf(stderr, "resanchor: out of memory\n");
+                return 1;
+            }
+
+            // The compiled template is never larger than the source.
+            if (DlgCompileTemplate(entry.pbData, entry.cbData, pbNew, entry.cbData, pAnchors, cDlgItems, &info) == DLGT_OK && info.cAnchors > 0)
+            {
+                if (!AppendEntry(&out, &entry, pbNew, info.cbTemplate) ||
+                    !AppendAnchorTable(&out, &entry, pAnchors, info.cAnchors))
+                {
+                    fprintf(stderr, "resanchor: out of memory\n");
+                    return 1;
+                }
+
+                cDialogs++;
+                cAnchorsTotal += info.cAnchors;
+                cbStripped += entry.cbData - info.cbTemplate;
+                fDone = 1;
+            }
+
+            free(pAnchors);
+            free(pbNew);
+        }
+
+        // Anything else is copied as-is (including tables from an earlier run).
+        if (!fDone && !AppendEntry(&out, &entry, entry.pbData, entry.cbData))
+        {
+            fprintf(stderr, "resanchor: out of memory\n");
+            return 1;
+        }
+
+        ib += cbEntry;
+    }
+
+    if (!WriteWholeFile(argv[2], out.pb, out.cb))
+    {
+        fprintf(stderr, "resanchor: can't write '%s'\n", argv[2]);
+        return 1;
+    }
+
+    printf("resanchor: %zu dialog(s), %zu anchor(s), %zu byte(s) of creation data stripped\n", cDialogs, cAnchorsTotal, cbStripped);
+
+    free(out.pb);
+    free(pbRes);
+    return 0;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ReadWholeFile                                                  *
+ *                                                                          *
+ * Purpose : Read file into memory.                                         *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static uint8_t *ReadWholeFile(const char *pszFile, size_t *pcb)
+{
+    uint8_t *pb = NULL;
+    FILE *pf;
+    long cb;
+
+    if ((pf = fopen(pszFile, "rb")) == NULL)
+        return NULL;
+
+    if (fseek(pf, 0, SEEK_END) == 0 && (cb = ftell(pf)) >= 0 && fseek(pf, 0, SEEK_SET) == 0 &&
+        (pb = malloc(cb + 1)) != NULL)
+    {
+        if (fread(pb, 1, cb, pf) == (size_t)cb)
+        {
+            *pcb = cb;
+        }
+        else
+        {
+            free(pb);
+            pb = NULL;
+        }
+    }
+
+    fclose(pf);
+    return pb;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: WriteWholeFile                                                 *
+ *                                                                          *
+ * Purpose : Write memory to file.                                          *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int WriteWholeFile(const char *pszFile, const void *pv, size_t cb)
+{
+    FILE *pf;
+    int fOk;
+
+    if ((pf = fopen(pszFile, "wb")) == NULL)
+        return 0;
+
+    fOk = fwrite(pv, 1, cb, pf) == cb;
+    fOk = (fclose(pf) == 0) && fOk;
+
+    return fOk;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ParseEntry                                                     *
+ *                                                                          *
+ * Purpose : Parse a resource entry; return zero if damaged.                *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int ParseEntry(const uint8_t *pb, size_t cb, RESENTRY *pEntry, size_t *pcbEntry)
+{
+    size_t cbType;
+
+    // DataSize, HeaderSize, and at least one WORD of type and name each.
+    if (cb < 4 * sizeof(uint32_t))
+        return 0;
+
+    pEntry->pbHeader = pb;
+    pEntry->cbData = ReadDWord(pb);
+    pEntry->cbHeader = ReadDWord(pb + 4);
+    if (pEntry->cbHeader < 2 * sizeof(uint32_t) || pEntry->cbHeader > cb || pEntry->cbData > cb - pEntry->cbHeader)
+        return 0;
+    pEntry->pbData = pb + pEntry->cbHeader;
+
+    // Type and name, inside the header.
+    if ((cbType = NameOrdSize(pb + 8, pEntry->cbHeader - 8)) == 0)
+        return 0;
+    pEntry->fDialog = ReadWord(pb + 8) == 0xFFFF && ReadWord(pb + 10) == RT_DIALOG;
+    pEntry->pbName = pb + 8 + cbType;
+    if ((pEntry->cbName = NameOrdSize(pEntry->pbName, pEntry->cbHeader - 8 - cbType)) == 0)
+        return 0;
+
+    // Entries are DWORD aligned; the last one may lack padding.
+    *pcbEntry = ROUNDUP(pEntry->cbHeader + pEntry->cbData, sizeof(uint32_t));
+    if (*pcbEntry > cb)
+        *pcbEntry = cb;
+
+    return 1;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: NameOrdSize                                                    *
+ *                                                                          *
+ * Purpose : Return size of name/ordinal value, or zero if damaged.         *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static size_t NameOrdSize(const uint8_t *pb, size_t cb)
+{
+    size_t ib;
+
+    if (cb >= 2 * sizeof(uint16_t) && ReadWord(pb) == 0xFFFF)
+        return 2 * sizeof(uint16_t);
+
+    for (ib = 0; ib + sizeof(uint16_t) <= cb; ib += sizeof(uint16_t))
+    {
+        if (ReadWord(pb + ib) == 0)
+            return ib + sizeof(uint16_t);
+    }
+
+    return 0;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Append                                                         *
+ *                                                                          *
+ * Purpose : Append bytes to output buffer; return zero if out of memory.   *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int Append(OUTBUF *pOut, const void *pv, size_t cb)
+{
+    if (cb > pOut->cbMax - pOut->cb)
+    {
+        size_t cbMax = (pOut->cbMax != 0) ? pOut->cbMax : 4096;
+        uint8_t *pb;
+
+        while (cb > cbMax - pOut->cb)
+            cbMax *= 2;
+
+        if ((pb = realloc(pOut->pb, cbMax)) == NULL)
+            return 0;
+
+        pOut->pb = pb;
+        pOut->cbMax = cbMax;
+    }
+
+    memcpy(pOut->pb + pOut->cb, pv, cb);
+    pOut->cb += cb;
+    return 1;
+}
+
+static int AppendDWord(OUTBUF *pOut, uint32_t dw)
+{
+    uint8_t ab[4] = { dw & 0xFF, (dw >> 8) & 0xFF, (dw >> 16) & 0xFF, (dw >> 24) & 0xFF };
+    return Append(pOut, ab, sizeof(ab));
+}
+
+static int AppendAlign(OUTBUF *pOut)
+{
+    static const uint8_t abZero[sizeof(uint32_t)] = {0};
+    return Append(pOut, abZero, ROUNDUP(pOut->cb, sizeof(uint32_t)) - pOut->cb);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: AppendEntry                                                    *
+ *                                                                          *
+ * Purpose : Append resource entry, with new data.                          *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int AppendEntry(OUTBUF *pOut, const RESENTRY *pEntry, const void *pvData, size_t cbData)
+{
+    return AppendDWord(pOut, (uint32_t)cbData) &&
+           Append(pOut, pEntry->pbHeader + 4, pEntry->cbHeader - 4) &&
+           Append(pOut, pvData, cbData) &&
+           AppendAlign(pOut);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: AppendAnchorTable                                              *
+ *                                                                          *
+ * Purpose : Append anchor table resource for the given dialog entry.       *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int AppendAnchorTable(OUTBUF *pOut, const RESENTRY *pDialog, const DLGANCHOR *pAnchors, size_t cAnchors)
+{
+    // The fixed part after the name: DataVersion, MemoryFlags + LanguageId, Version, Characteristics.
+    const uint8_t *pbTail = pDialog->pbHeader + pDialog->cbHeader - 4 * sizeof(uint32_t);
+    size_t cbHeader = 2 * sizeof(uint32_t) + sizeof(awAnchorType) + pDialog->cbName;
+    size_t ibHeader = pOut->cb;
+    uint8_t abHdr[4];
+    size_t i;
+
+    cbHeader = ROUNDUP(cbHeader, sizeof(uint32_t)) + 4 * sizeof(uint32_t);
+
+    // Header: same name, memory flags and language as the dialog.
+    if (!AppendDWord(pOut, (uint32_t)(offsetof(ANCHORTABLE, aAnchors) + cAnchors * sizeof(DLGANCHOR))) ||
+        !AppendDWord(pOut, (uint32_t)cbHeader))
+        return 0;
+    for (i = 0; i < sizeof(awAnchorType) / sizeof(awAnchorType[0]); i++)
+    {
+        uint8_t ab[2] = { awAnchorType[i] & 0xFF, awAnchorType[i] >> 8 };
+        if (!Append(pOut, ab, sizeof(ab)))
+            return 0;
+    }
+    if (!Append(pOut, pDialog->pbName, pDialog->cbName) || !AppendAlign(pOut) ||
+        !AppendDWord(pOut, 0) || !Append(pOut, pbTail + 4, 4) || !AppendDWord(pOut, 0) || !AppendDWord(pOut, 0))
+        return 0;
+
+    // Sanity check.
+    if (pOut->cb - ibHeader != cbHeader)
+        return 0;
+
+    // Table: magic, version, count; little-endian.
+    abHdr[0] = EXTRA_MAGIC & 0xFF;
+    abHdr[1] = EXTRA_MAGIC >> 8;
+    abHdr[2] = ANCHORTABLE_VERSION & 0xFF;
+    abHdr[3] = ANCHORTABLE_VERSION >> 8;
+    if (!Append(pOut, abHdr, sizeof(abHdr)) || !AppendDWord(pOut, (uint32_t)cAnchors))
+        return 0;
+
+    // Records: id, flags, reserved, shares.
+    for (i = 0; i < cAnchors; i++)
+    {
+        uint8_t abRec[sizeof(DLGANCHOR)] = { 0 };
+
+        abRec[0] = pAnchors[i].id & 0xFF;
+        abRec[1] = (pAnchors[i].id >> 8) & 0xFF;
+        abRec[2] = (pAnchors[i].id >> 16) & 0xFF;
+        abRec[3] = (pAnchors[i].id >> 24) & 0xFF;
+        abRec[4] = pAnchors[i].fuAlign & 0xFF;
+        abRec[5] = pAnchors[i].fuAlign >> 8;
+        memcpy(&abRec[offsetof(DLGANCHOR, abShare)], pAnchors[i].abShare, sizeof(pAnchors[i].abShare));
+        if (!Append(pOut, abRec, sizeof(abRec)))
+            return 0;
+    }
+
+    return AppendAlign(pOut);
+}
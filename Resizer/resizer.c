@@ -12,104 +12,137 @@
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 #include <windowsx.h>
+#include <commctrl.h>
 #include <stdlib.h>
+#include <string.h>
 #include <wchar.h>
 #include "xresizer.h"
 
-#define ROUNDUP(n,m)  (((n)+((m)-1)) & (~((m)-1)))
+#define NELEMS(a)  (sizeof(a) / sizeof((a)[0]))
 
 #define RT_DIALOGA  MAKEINTRESOURCEA(5)
 #define RT_DIALOGW  MAKEINTRESOURCEW(5)
 
-// Macros to set and retrieve the original window procedure in a subclassed window.
-#define SETPROP_WNDPROC(hwnd,pfn)  SetProp((hwnd), PROP_WNDPROC, (HANDLE)(pfn))
-#define GETPROP_WNDPROC(hwnd)  ((WNDPROC)GetProp((hwnd), PROP_WNDPROC))
-#define REMOVEPROP_WNDPROC(hwnd)  RemoveProp((hwnd), PROP_WNDPROC)
+// Anchor table resource type, from the resanchor tool.
+#define RT_ANCHORSA  "RESIZER"
+#define RT_ANCHORSW  L"RESIZER"
 
-// Macros to set and retrieve the RESIZER pointer in a subclassed window.
+// Macros to set and retrieve the RESIZER pointer in a resizable dialog (API calls, and parent dialogs).
 #define SETPROP_RESIZER(hwnd,pr)  SetProp((hwnd), PROP_RESIZER, (HANDLE)(pr))
 #define GETPROP_RESIZER(hwnd)  ((PRESIZER)GetProp((hwnd), PROP_RESIZER))
 #define REMOVEPROP_RESIZER(hwnd)  RemoveProp((hwnd), PROP_RESIZER)
 
+// Macros to set and retrieve the MODALCONTEXT pointer in a modal dialog.
+#define SETPROP_CONTEXT(hwnd,pc)  SetProp((hwnd), PROP_CONTEXT, (HANDLE)(pc))
+#define GETPROP_CONTEXT(hwnd)  ((PMODALCONTEXT)GetProp((hwnd), PROP_CONTEXT))
+#define REMOVEPROP_CONTEXT(hwnd)  RemoveProp((hwnd), PROP_CONTEXT)
+
 // Integer properties for above.
-#define PROP_WNDPROC  MAKEINTATOM(g_atPropWndProc)
 #define PROP_RESIZER  MAKEINTATOM(g_atPropResizer)
+#define PROP_CONTEXT  MAKEINTATOM(g_atPropContext)
+
+#ifndef WM_DPICHANGED
+#define WM_DPICHANGED  0x02E0
+#endif /* WM_DPICHANGED */
+
+#ifndef WM_DPICHANGED_AFTERPARENT
+#define WM_DPICHANGED_AFTERPARENT  0x02E3
+#endif /* WM_DPICHANGED_AFTERPARENT */
+
+// Macros to update dialog and process-wide statistics.
+#define ADD_STAT(pr,field,n)  ((pr)->stats.field += (n), InterlockedExchangeAdd((LONG volatile *)&g_stats.field, (LONG)(n)))
+#define ADD_STAT64(pr,field,n)  ((pr)->stats.field += (n), InterlockedExchangeAdd64((LONGLONG volatile *)&g_stats.field, (LONGLONG)(n)))
 
-#ifndef HANDLE_WM_SIZING
-/* BOOL onSizing(HWND hwnd, UINT fSize, PRECT prc) */
-#define HANDLE_WM_SIZING(hwnd,wParam,lParam,fn)  ((fn)((hwnd), (UINT)(wParam), (PRECT)(lParam)))
-#endif /* HANDLE_WM_SIZING */
-
-typedef struct DLGTEMPLATEEX {
-    WORD dlgVer;
-    WORD signature;
-    DWORD helpID;
-    DWORD exStyle;
-    DWORD style;
-    WORD cDlgItems;
-    short x;
-    short y;
-    short cx;
-    short cy;
-    WORD menu;
-    /* sz_Or_Ord menu; */
-    /* sz_Or_Ord windowClass; */
-    /* WCHAR title[titleLen]; */
-    /* WORD pointsize; */
-    /* WORD weight; */
-    /* BYTE italic; */
-    /* BYTE charset; */
-    /* WCHAR typeface[stringLen]; */
-} DLGTEMPLATEEX, *LPDLGTEMPLATEEX;
-typedef const struct DLGTEMPLATEEX *LPCDLGTEMPLATEEX;
-
-typedef struct DLGITEMTEMPLATEEX {
-    DWORD helpID;
-    DWORD exStyle;
-    DWORD style;
-    short x;
-    short y;
-    short cx;
-    short cy;
-    DWORD id;
-    WORD windowClass;
-    /* sz_Or_Ord windowClass; */
-    /* sz_Or_Ord title; */
-    /* WORD extraCount; */
-} DLGITEMTEMPLATEEX, *LPDLGITEMTEMPLATEEX;
-typedef const struct DLGITEMTEMPLATEEX *LPCDLGITEMTEMPLATEEX;
+// Timer for coalescing layouts during live resize (about one display frame); see GetCoalesceTimerId().
+#define MS_COALESCE    16
+
+// Subclass ids, for SetWindowSubclass().
+#define IDSC_DIALOG    1
+#define IDSC_CONTROL   2
+
+// Off-screen surface grows in steps, so a live resize doesn't reallocate all the time.
+#define CX_BUFFERSTEP  128
+#define CY_BUFFERSTEP  128
 
 // Global variables.
-static ATOM g_atPropWndProc;
 static ATOM g_atPropResizer;
-static PRESIZER g_pResizer;  /* for modal dialog */
-static DLGPROC g_pfnDialog;  /* original dialog proc, for modal dialog */
+static ATOM g_atPropContext;
+static LONG volatile g_cAllocs;  /* heap statistics */
+static LONG volatile g_cFrees;
+static LONG volatile g_cbCurrent;
+static LONG volatile g_cbPeak;
+static RESIZERSTATS g_stats;  /* all dialogs; times in performance counter ticks */
+static RESIZERTRACEPROC g_pfnTrace;  /* trace callback */
+static PVOID g_pvTrace;
+static PGEOMETRYSTORE g_pGeometry;  /* saved dialog sizes (NULL = off) */
+static DWORD g_dwTlsPending = TLS_OUT_OF_INDEXES;  /* modal dialogs being created, per thread; not __declspec(thread), see InitPendingSlot() */
+static LONG volatile g_lTlsInit;
+static PRESIZERTEMPLATE g_pTemplateCache;  /* compiled templates, shared by all threads */
+static CRITICAL_SECTION g_csCache;
+static LONG volatile g_lCacheInit;
 
 // Static function prototypes.
-static size_t NameOrdLenW(PCWSTR);
-static BOOL MakeResizableDialog(LPCDLGTEMPLATEW, LPDLGTEMPLATEW *, PRESIZER *);
-static SIZE_T SizeOfExtendedTemplate(LPCDLGTEMPLATEW);
+static HWND CreateResizableDialogWorker(HINSTANCE, PRESIZERTEMPLATE, HWND, DLGPROC, LPARAM, BOOL);
+static INT_PTR ResizableDialogBoxWorker(HINSTANCE, PRESIZERTEMPLATE, HWND, DLGPROC, LPARAM, BOOL);
+static PRESIZERTEMPLATE GetResizerTemplate(HINSTANCE, LPCVOID, BOOL, LPCDLGTEMPLATEW);
+static PRESIZERTEMPLATE FindResizerTemplate(HINSTANCE, LPCVOID, BOOL, LPCDLGTEMPLATEW);
+static PRESIZERTEMPLATE LoadResizerTemplate(HINSTANCE, LPCVOID, BOOL, LPCDLGTEMPLATEW, SIZE_T);
+static PRESIZERTEMPLATE CompileResizerTemplate(HINSTANCE, LPCVOID, BOOL, LPCDLGTEMPLATEW, SIZE_T);
+static PRESIZERTEMPLATE AllocResizerTemplate(HINSTANCE, LPCVOID, BOOL, LPCDLGTEMPLATEW, SIZE_T);
+static void SetTemplateKey(PRESIZERTEMPLATE, SIZE_T);
+static void ReleaseResizerTemplate(PRESIZERTEMPLATE);
+static void LockTemplateCache(void);
+static void UnlockTemplateCache(void);
+static BOOL InitPendingSlot(void);
+static PRESIZER MakeResizer(PRESIZERTEMPLATE);
+static PVOID MyAlloc(SIZE_T);
+static void MyFree(PVOID);
+static SIZE_T GetReadableSize(LPCVOID, PBOOL);
 static BOOL InstallResizableDialogHandler(HWND, PRESIZER);
 static INT_PTR CALLBACK ResizerDlgProc(HWND, UINT, WPARAM, LPARAM);
-static LRESULT CALLBACK ResizerWndProc(HWND, UINT, WPARAM, LPARAM);
-static void Resizer_OnGetMinMaxInfo(HWND, PMINMAXINFO);
-static UINT Resizer_OnNCHitTest(HWND, int, int);
-static BOOL Resizer_OnSizing(HWND, UINT, PRECT);
-static void Resizer_OnSize(HWND, UINT, int, int);
-static BOOL Resizer_OnEraseBkgnd(HWND, HDC);
-static void Resizer_OnDestroy(HWND);
-static void MoveDialogControls(HWND, int, int);
-static void GetAdjustedControlRect(PRECT, HWND, HWND, const RESIZERCTL *, int, int);
-static void GetGripperRect(HWND, PRECT);
+static LRESULT CALLBACK ResizerWndProc(HWND, UINT, WPARAM, LPARAM, UINT_PTR, DWORD_PTR);
+static void Resizer_OnGetMinMaxInfo(HWND, PRESIZER, PMINMAXINFO);
+static UINT Resizer_OnNCHitTest(HWND, PRESIZER, int, int);
+static BOOL Resizer_OnSizing(HWND, PRESIZER, UINT, PRECT);
+static void Resizer_OnSize(HWND, PRESIZER, UINT, int, int);
+static void Resizer_OnEnterSizeMove(HWND, PRESIZER);
+static void Resizer_OnExitSizeMove(HWND, PRESIZER);
+static BOOL Resizer_OnTimer(HWND, PRESIZER, UINT_PTR);
+static BOOL Resizer_OnEraseBkgnd(HWND, PRESIZER, HDC);
+static void Resizer_OnSettingChange(HWND, PRESIZER, UINT, LPCTSTR);
+static void Resizer_OnDpiChanged(HWND, PRESIZER, UINT, UINT, PRECT);
+static void Resizer_OnDpiChangedAfterParent(HWND, PRESIZER);
+static void Resizer_OnDestroy(HWND, PRESIZER);
+static void MoveDialogControls(HWND, PRESIZER, int, int);
+static void MoveChildDialogs(PRESIZER);
+static void FlushPendingLayout(HWND, PRESIZER);
+static void RescaleDialog(HWND, PRESIZER, UINT);
+static UINT GetWindowDpi(HWND);
+static void CaptureControlRects(HWND, PRESIZER);
+static void DeferHiddenControl(PRESIZER, int);
+static void UndeferHiddenControl(PRESIZER, int);
+static LRESULT CALLBACK ResizerControlProc(HWND, UINT, WPARAM, LPARAM, UINT_PTR, DWORD_PTR);
+static void GetGripperRect(HWND, PCRESIZER, PRECT);
+static int GetGripperSize(UINT);
+static HDC GetBufferDC(PRESIZER, HDC, const RECT *);
+static void FreeBufferDC(PRESIZER);
+static void RestoreDialogGeometry(HWND, PCRESIZER);
+static void SaveDialogGeometry(HWND, PCRESIZER);
+static PGEOMETRYSLOT FindGeometrySlot(ULONGLONG, BOOL);
+static void TraceEvent(HWND, PCRESIZER, UINT, DWORD, LONGLONG);
+static ULONGLONG TicksToMicroseconds(ULONGLONG);
 
 // Inline functions (one-liners).
 static inline int RectHeight(const RECT *prc) { return prc->bottom - prc->top; }
 static inline int RectWidth(const RECT *prc) { return prc->right - prc->left; }
-static inline BOOL IsOrdinalW(PCWSTR pwch) { return (pwch[0] == (WCHAR)-1) ? TRUE : FALSE; }
-static inline PVOID DWordAlign(const void *pv) { return (PVOID)ROUNDUP((DWORD_PTR)pv, sizeof(DWORD)); }
-static inline PVOID AppendBlock(void *pvDst, const void *pvSrc, size_t cbSrc) { return (PBYTE)memcpy(pvDst, pvSrc, cbSrc) + cbSrc; }
-static inline PVOID MyAlloc(SIZE_T cb) { return HeapAlloc(GetProcessHeap(), 0, cb); }
-static inline void MyFree(PVOID pv) { if (pv) HeapFree(GetProcessHeap(), 0, pv); }
+static inline UINT_PTR GetCoalesceTimerId(PCRESIZER pResizer) { return (UINT_PTR)pResizer; }  /* can't collide with the dialog's own timers */
+static inline PRESIZER GetNestedResizer(HWND hwndCtl) { return GETPROP_RESIZER(hwndCtl); }
+static inline PMODALLINK GetPendingSlot(void) { return (PMODALLINK)TlsGetValue(g_dwTlsPending); }
+static inline void SetPendingSlot(PMODALLINK pLink) { TlsSetValue(g_dwTlsPending, pLink); }
+static inline LONGLONG GetTicks(void) { LARGE_INTEGER li; QueryPerformanceCounter(&li); return li.QuadPart; }
+
+// Pending modal dialogs, for ModalPush() and friends.
+static const MODALSLOT g_slotPending = { GetPendingSlot, SetPendingSlot };
 
 /****************************************************************************
  *                                                                          *
@@ -129,12 +162,21 @@ BOOL WINAPI AdjustResizableDialog(HWND hwndDlg, int dx, int dy)
     pResizer = GETPROP_RESIZER(hwndDlg);
     if (pResizer != NULL)
     {
+        UINT fuFlags = SWP_NOMOVE|SWP_NOZORDER|SWP_NOCOPYBITS;
         RECT rc;
 
         pResizer->fEnabled = FALSE;  /* sorry, on vacation */
 
+        // Keep what's on screen; only the old gripper, and whatever gets exposed, needs painting.
+        if (pResizer->fOptions & RDO_DOUBLEBUFFER)
+        {
+            GetGripperRect(hwndDlg, pResizer, &rc);
+            InvalidateRect(hwndDlg, &rc, TRUE);
+            fuFlags &= ~SWP_NOCOPYBITS;
+        }
+
         GetWindowRect(hwndDlg, &rc);
-        SetWindowPos(hwndDlg, NULL, 0, 0, RectWidth(&rc) + dx, RectHeight(&rc) + dy, SWP_NOMOVE|SWP_NOZORDER|SWP_NOCOPYBITS);
+        SetWindowPos(hwndDlg, NULL, 0, 0, RectWidth(&rc) + dx, RectHeight(&rc) + dy, fuFlags);
 
         pResizer->sizeMinTrack.cx += dx;
         pResizer->sizeMinTrack.cy += dy;
@@ -143,6 +185,9 @@ BOOL WINAPI AdjustResizableDialog(HWND hwndDlg, int dx, int dy)
         pResizer->sizeCurClient.cx += dx;
         pResizer->sizeCurClient.cy += dy;
 
+        // The caller may have moved controls; don't trust the base rectangles.
+        pResizer->fRebase = TRUE;
+
         pResizer->fEnabled = TRUE;  /* OK, I'm back */
 
         return TRUE;
@@ -153,134 +198,307 @@ BOOL WINAPI AdjustResizableDialog(HWND hwndDlg, int dx, int dy)
 
 /****************************************************************************
  *                                                                          *
- * Function: CreateResizableDialogParamA                                    *
+ * Function: SetResizableDialogOptions                                      *
  *                                                                          *
- * Purpose : Like CreateDialogParamA(), but for a resizable dialog.         *
+ * Purpose : Set options (RDO_*) for a resizable dialog.                    *
  *                                                                          *
  * History : Date      Reason                                               *
  *           09-02-22  Created                                              *
  *                                                                          *
  ****************************************************************************/
 
-HWND WINAPI CreateResizableDialogParamA(HINSTANCE hInst, PCSTR pTemplate, HWND hwndParent, DLGPROC pfnDialog, LPARAM lParam)
+BOOL WINAPI SetResizableDialogOptions(HWND hwndDlg, DWORD fOptions)
 {
-    HRSRC hrsrc;
-    HGLOBAL hgRes;
-    PVOID pvRes;
+    PRESIZER pResizer;
 
-    if ((hrsrc = FindResourceA(hInst, pTemplate, RT_DIALOGA)) != NULL &&
-        (hgRes = LoadResource(hInst, hrsrc)) != NULL &&
-        (pvRes = LockResource(hgRes)) != NULL)
-    {
-        return CreateResizableDialogIndirectParamA(hInst, pvRes, hwndParent, pfnDialog, lParam);
-    }
-    else
+    pResizer = GETPROP_RESIZER(hwndDlg);
+    if (pResizer != NULL)
     {
-        return CreateDialogParamA(hInst, pTemplate, hwndParent, pfnDialog, lParam);
+        pResizer->fOptions = fOptions;
+
+        // Don't leave anything behind when coalescing is turned off.
+        if ((fOptions & RDO_COALESCE) == 0)
+            FlushPendingLayout(hwndDlg, pResizer);
+        if ((fOptions & RDO_DOUBLEBUFFER) == 0)
+            FreeBufferDC(pResizer);
+
+        return TRUE;
     }
+
+    return FALSE;
 }
 
 /****************************************************************************
  *                                                                          *
- * Function: CreateResizableDialogParamW                                    *
+ * Function: GetResizableDialogStats                                        *
  *                                                                          *
- * Purpose : Like CreateDialogParamW(), but for a resizable dialog.         *
+ * Purpose : Get layout statistics for a resizable dialog, or for all       *
+ *           resizable dialogs in the process (hwndDlg == NULL).            *
  *                                                                          *
  * History : Date      Reason                                               *
  *           09-02-22  Created                                              *
  *                                                                          *
  ****************************************************************************/
 
-HWND WINAPI CreateResizableDialogParamW(HINSTANCE hInst, PCWSTR pTemplate, HWND hwndParent, DLGPROC pfnDialog, LPARAM lParam)
+BOOL WINAPI GetResizableDialogStats(HWND hwndDlg, PRESIZERSTATS pStats)
 {
-    HRSRC hrsrc;
-    HGLOBAL hgRes;
-    PVOID pvRes;
+    RESIZERSTATS stats;
+
+    if (pStats == NULL || pStats->cbSize < RESIZERSTATS_V1_SIZE)
+        return FALSE;
 
-    if ((hrsrc = FindResourceW(hInst, pTemplate, RT_DIALOGW)) != NULL &&
-        (hgRes = LoadResource(hInst, hrsrc)) != NULL &&
-        (pvRes = LockResource(hgRes)) != NULL)
+    if (hwndDlg != NULL)
     {
-        return CreateResizableDialogIndirectParamW(hInst, pvRes, hwndParent, pfnDialog, lParam);
+        PRESIZER pResizer;
+
+        if ((pResizer = GETPROP_RESIZER(hwndDlg)) == NULL)
+            return FALSE;
+        stats = pResizer->stats;
     }
     else
     {
-        return CreateDialogParamW(hInst, pTemplate, hwndParent, pfnDialog, lParam);
+        // A snapshot; other threads may be busy updating it.
+        stats = g_stats;
     }
+
+    stats.ullLayoutTime = TicksToMicroseconds(stats.ullLayoutTime);
+    stats.ullEraseTime = TicksToMicroseconds(stats.ullEraseTime);
+    stats.ullMaxEraseTime = TicksToMicroseconds(stats.ullMaxEraseTime);
+
+    // Callers built with an older header get what they asked for.
+    stats.cbSize = min(pStats->cbSize, sizeof(stats));
+    memcpy(pStats, &stats, stats.cbSize);
+
+    return TRUE;
 }
 
 /****************************************************************************
  *                                                                          *
- * Function: CreateResizableDialogIndirectParamA                            *
+ * Function: SetResizerTraceProc                                            *
  *                                                                          *
- * Purpose : Like CreateDialogIndirectParamA(), but for a resizable dialog. *
+ * Purpose : Set callback for layout and erase events, in all resizable     *
+ *           dialogs (NULL = none). Meant to be set once, at startup; the   *
+ *           callback can forward events to a file, ETW, or whatever.       *
  *                                                                          *
  * History : Date      Reason                                               *
  *           09-02-22  Created                                              *
  *                                                                          *
  ****************************************************************************/
 
-HWND WINAPI CreateResizableDialogIndirectParamA(HINSTANCE hInst, LPCDLGTEMPLATEW pTemplate, HWND hwndParent, DLGPROC pfnDialog, LPARAM lParam)
+void WINAPI SetResizerTraceProc(RESIZERTRACEPROC pfnTrace, PVOID pvData)
 {
-    LPDLGTEMPLATE pNewTemplate;
-    PRESIZER pResizer;
-    HWND hwndDlg;
+    g_pvTrace = pvData;
+    g_pfnTrace = pfnTrace;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: SetResizableDialogGeometryStore                                *
+ *                                                                          *
+ * Purpose : Remember the size of each top-level resizable dialog in the    *
+ *           given file, and create dialogs at the remembered size (NULL =  *
+ *           off). Call before creating dialogs, and after destroying them. *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+BOOL WINAPI SetResizableDialogGeometryStore(PCWSTR pszFile)
+{
+    PGEOMETRYSTORE pStore;
+    HANDLE hFile, hMap;
 
-    if (MakeResizableDialog(pTemplate, &pNewTemplate, &pResizer))
+    // Forget the current store, if any.
+    if (g_pGeometry != NULL)
     {
-        hwndDlg = CreateDialogIndirectParamA(hInst, pNewTemplate, hwndParent, pfnDialog, lParam);
-        if (hwndDlg != NULL)
-        {
-            InstallResizableDialogHandler(hwndDlg, pResizer);
-            InvalidateRect(hwndDlg, NULL, TRUE);  /* makes Vista happier than expected... */
-        }
+        UnmapViewOfFile(g_pGeometry);
+        g_pGeometry = NULL;
+    }
 
-        MyFree(pNewTemplate);
-        // pResizer free'd elsewhere.
+    if (pszFile == NULL)
+        return TRUE;
+
+    hFile = CreateFileW(pszFile, GENERIC_READ|GENERIC_WRITE, FILE_SHARE_READ|FILE_SHARE_WRITE, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return FALSE;
+
+    // Grows a new file to the right size (zero-filled).
+    hMap = CreateFileMappingW(hFile, NULL, PAGE_READWRITE, 0, sizeof(GEOMETRYSTORE), NULL);
+    CloseHandle(hFile);
+    if (hMap == NULL)
+        return FALSE;
+
+    // The view keeps the mapping alive.
+    pStore = MapViewOfFile(hMap, FILE_MAP_WRITE, 0, 0, sizeof(GEOMETRYSTORE));
+    CloseHandle(hMap);
+    if (pStore == NULL)
+        return FALSE;
+
+    // New file, or something else? Start over.
+    if (pStore->magic != GEOMETRY_MAGIC || pStore->cSlots != GEOMETRY_SLOTS)
+    {
+        memset(pStore, 0, sizeof(*pStore));
+        pStore->magic = GEOMETRY_MAGIC;
+        pStore->cSlots = GEOMETRY_SLOTS;
     }
-    else
+
+    g_pGeometry = pStore;
+    return TRUE;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: GetResizerHeapStats                                            *
+ *                                                                          *
+ * Purpose : Get heap statistics for the Resizer (debugging aid).           *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+BOOL WINAPI GetResizerHeapStats(PRESIZERHEAPSTATS pStats)
+{
+    if (pStats != NULL && pStats->cbSize >= sizeof(*pStats))
     {
-        hwndDlg = CreateDialogIndirectParamA(hInst, pTemplate, hwndParent, pfnDialog, lParam);
+        pStats->cbSize = sizeof(*pStats);
+        pStats->cAllocs = (DWORD)g_cAllocs;
+        pStats->cFrees = (DWORD)g_cFrees;
+        pStats->cbCurrent = (DWORD)g_cbCurrent;
+        pStats->cbPeak = (DWORD)g_cbPeak;
+        return TRUE;
     }
 
-    return hwndDlg;
+    return FALSE;
 }
 
 /****************************************************************************
  *                                                                          *
- * Function: CreateResizableDialogIndirectParamW                            *
+ * Function: FlushResizableDialogCache                                      *
  *                                                                          *
- * Purpose : Like CreateDialogIndirectParamW(), but for a resizable dialog. *
+ * Purpose : Forget cached templates for the given module (NULL = all).     *
  *                                                                          *
  * History : Date      Reason                                               *
  *           09-02-22  Created                                              *
  *                                                                          *
  ****************************************************************************/
 
-HWND WINAPI CreateResizableDialogIndirectParamW(HINSTANCE hInst, LPCDLGTEMPLATEW pTemplate, HWND hwndParent, DLGPROC pfnDialog, LPARAM lParam)
+void WINAPI FlushResizableDialogCache(HINSTANCE hInst)
 {
-    LPDLGTEMPLATE pNewTemplate;
-    PRESIZER pResizer;
-    HWND hwndDlg;
+    PRESIZERTEMPLATE pFlushed = NULL;
+    PRESIZERTEMPLATE *ppt;
 
-    if (MakeResizableDialog(pTemplate, &pNewTemplate, &pResizer))
+    // Unlink, under lock...
+    LockTemplateCache();
+    for (ppt = &g_pTemplateCache; *ppt != NULL; )
     {
-        hwndDlg = CreateDialogIndirectParamW(hInst, pNewTemplate, hwndParent, pfnDialog, lParam);
-        if (hwndDlg != NULL)
+        PRESIZERTEMPLATE pt = *ppt;
+
+        if (hInst == NULL || pt->hInst == hInst)
         {
-            InstallResizableDialogHandler(hwndDlg, pResizer);
-            InvalidateRect(hwndDlg, NULL, TRUE);  /* makes Vista happier than expected... */
+            *ppt = pt->pNext;
+            pt->pNext = pFlushed;
+            pFlushed = pt;
+        }
+        else
+        {
+            ppt = &pt->pNext;
         }
-
-        MyFree(pNewTemplate);
-        // pResizer free'd elsewhere.
     }
-    else
+    UnlockTemplateCache();
+
+    // ...then drop the cache reference. Templates still used by a dialog live on.
+    while (pFlushed != NULL)
     {
-        hwndDlg = CreateDialogIndirectParamW(hInst, pTemplate, hwndParent, pfnDialog, lParam);
+        PRESIZERTEMPLATE pt = pFlushed;
+        pFlushed = pt->pNext;
+        ReleaseResizerTemplate(pt);
     }
+}
 
-    return hwndDlg;
+/****************************************************************************
+ *                                                                          *
+ * Function: CreateResizableDialogParamA                                    *
+ *                                                                          *
+ * Purpose : Like CreateDialogParamA(), but for a resizable dialog.         *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+HWND WINAPI CreateResizableDialogParamA(HINSTANCE hInst, PCSTR pTemplate, HWND hwndParent, DLGPROC pfnDialog, LPARAM lParam)
+{
+    PRESIZERTEMPLATE pt;
+
+    if ((pt = GetResizerTemplate(hInst, pTemplate, TRUE, NULL)) != NULL)
+        return CreateResizableDialogWorker(hInst, pt, hwndParent, pfnDialog, lParam, TRUE);
+    else
+        return CreateDialogParamA(hInst, pTemplate, hwndParent, pfnDialog, lParam);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: CreateResizableDialogParamW                                    *
+ *                                                                          *
+ * Purpose : Like CreateDialogParamW(), but for a resizable dialog.         *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+HWND WINAPI CreateResizableDialogParamW(HINSTANCE hInst, PCWSTR pTemplate, HWND hwndParent, DLGPROC pfnDialog, LPARAM lParam)
+{
+    PRESIZERTEMPLATE pt;
+
+    if ((pt = GetResizerTemplate(hInst, pTemplate, FALSE, NULL)) != NULL)
+        return CreateResizableDialogWorker(hInst, pt, hwndParent, pfnDialog, lParam, FALSE);
+    else
+        return CreateDialogParamW(hInst, pTemplate, hwndParent, pfnDialog, lParam);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: CreateResizableDialogIndirectParamA                            *
+ *                                                                          *
+ * Purpose : Like CreateDialogIndirectParamA(), but for a resizable dialog. *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+HWND WINAPI CreateResizableDialogIndirectParamA(HINSTANCE hInst, LPCDLGTEMPLATEW pTemplate, HWND hwndParent, DLGPROC pfnDialog, LPARAM lParam)
+{
+    PRESIZERTEMPLATE pt;
+
+    if ((pt = GetResizerTemplate(hInst, NULL, TRUE, pTemplate)) != NULL)
+        return CreateResizableDialogWorker(hInst, pt, hwndParent, pfnDialog, lParam, TRUE);
+    else
+        return CreateDialogIndirectParamA(hInst, pTemplate, hwndParent, pfnDialog, lParam);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: CreateResizableDialogIndirectParamW                            *
+ *                                                                          *
+ * Purpose : Like CreateDialogIndirectParamW(), but for a resizable dialog. *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+HWND WINAPI CreateResizableDialogIndirectParamW(HINSTANCE hInst, LPCDLGTEMPLATEW pTemplate, HWND hwndParent, DLGPROC pfnDialog, LPARAM lParam)
+{
+    PRESIZERTEMPLATE pt;
+
+    if ((pt = GetResizerTemplate(hInst, NULL, FALSE, pTemplate)) != NULL)
+        return CreateResizableDialogWorker(hInst, pt, hwndParent, pfnDialog, lParam, FALSE);
+    else
+        return CreateDialogIndirectParamW(hInst, pTemplate, hwndParent, pfnDialog, lParam);
 }
 
 /****************************************************************************
@@ -296,20 +514,12 @@ HWND WINAPI CreateResizableDialogIndirectParamW(HINSTANCE hInst, LPCDLGTEMPLATEW
 
 INT_PTR WINAPI ResizableDialogBoxParamA(HINSTANCE hInst, PCSTR pTemplate, HWND hwndParent, DLGPROC pfnDialog, LPARAM lParam)
 {
-    HRSRC hrsrc;
-    HGLOBAL hgRes;
-    PVOID pvRes;
+    PRESIZERTEMPLATE pt;
 
-    if ((hrsrc = FindResourceA(hInst, pTemplate, RT_DIALOGA)) != NULL &&
-        (hgRes = LoadResource(hInst, hrsrc)) != NULL &&
-        (pvRes = LockResource(hgRes)) != NULL)
-    {
-        return ResizableDialogBoxIndirectParamA(hInst, pvRes, hwndParent, pfnDialog, lParam);
-    }
+    if ((pt = GetResizerTemplate(hInst, pTemplate, TRUE, NULL)) != NULL)
+        return ResizableDialogBoxWorker(hInst, pt, hwndParent, pfnDialog, lParam, TRUE);
     else
-    {
         return DialogBoxParamA(hInst, pTemplate, hwndParent, pfnDialog, lParam);
-    }
 }
 
 /****************************************************************************
@@ -325,678 +535,1904 @@ INT_PTR WINAPI ResizableDialogBoxParamA(HINSTANCE hInst, PCSTR pTemplate, HWND h
 
 INT_PTR WINAPI ResizableDialogBoxParamW(HINSTANCE hInst, PCWSTR pTemplate, HWND hwndParent, DLGPROC pfnDialog, LPARAM lParam)
 {
-    HRSRC hrsrc;
-    HGLOBAL hgRes;
-    PVOID pvRes;
+    PRESIZERTEMPLATE pt;
+
+    if ((pt = GetResizerTemplate(hInst, pTemplate, FALSE, NULL)) != NULL)
+        return ResizableDialogBoxWorker(hInst, pt, hwndParent, pfnDialog, lParam, FALSE);
+    else
+        return DialogBoxParamW(hInst, pTemplate, hwndParent, pfnDialog, lParam);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ResizableDialogBoxIndirectParamA                               *
+ *                                                                          *
+ * Purpose : Like DialogBoxIndirectParamA(), but for a resizable dialog.    *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+INT_PTR WINAPI ResizableDialogBoxIndirectParamA(HINSTANCE hInst, LPCDLGTEMPLATEA pTemplate, HWND hwndParent, DLGPROC pfnDialog, LPARAM lParam)
+{
+    PRESIZERTEMPLATE pt;
+
+    if ((pt = GetResizerTemplate(hInst, NULL, TRUE, pTemplate)) != NULL)
+        return ResizableDialogBoxWorker(hInst, pt, hwndParent, pfnDialog, lParam, TRUE);
+    else
+        return DialogBoxIndirectParamA(hInst, pTemplate, hwndParent, pfnDialog, lParam);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ResizableDialogBoxIndirectParamW                               *
+ *                                                                          *
+ * Purpose : Like DialogBoxIndirectParamW(), but for a resizable dialog.    *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+INT_PTR WINAPI ResizableDialogBoxIndirectParamW(HINSTANCE hInst, LPCDLGTEMPLATEW pTemplate, HWND hwndParent, DLGPROC pfnDialog, LPARAM lParam)
+{
+    PRESIZERTEMPLATE pt;
+
+    if ((pt = GetResizerTemplate(hInst, NULL, FALSE, pTemplate)) != NULL)
+        return ResizableDialogBoxWorker(hInst, pt, hwndParent, pfnDialog, lParam, FALSE);
+    else
+        return DialogBoxIndirectParamW(hInst, pTemplate, hwndParent, pfnDialog, lParam);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: CreateResizableDialogWorker                                    *
+ *                                                                          *
+ * Purpose : Create modeless dialog from (compiled) template.               *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static HWND CreateResizableDialogWorker(HINSTANCE hInst, PRESIZERTEMPLATE pt, HWND hwndParent, DLGPROC pfnDialog, LPARAM lParam, BOOL fAnsi)
+{
+    PRESIZER pResizer;
+    HWND hwndDlg;
 
-    if ((hrsrc = FindResourceW(hInst, pTemplate, RT_DIALOGW)) != NULL &&
-        (hgRes = LoadResource(hInst, hrsrc)) != NULL &&
-        (pvRes = LockResource(hgRes)) != NULL)
+    if (pt->pDlg != NULL && (pResizer = MakeResizer(pt)) != NULL)
     {
-        return ResizableDialogBoxIndirectParamW(hInst, pvRes, hwndParent, pfnDialog, lParam);
+        hwndDlg = (fAnsi) ? CreateDialogIndirectParamA(hInst, pt->pDlg, hwndParent, pfnDialog, lParam)
+                          : CreateDialogIndirectParamW(hInst, pt->pDlg, hwndParent, pfnDialog, lParam);
+
+        // Template not needed anymore.
+        ReleaseResizerTemplate(pt);
+
+        if (hwndDlg != NULL)
+        {
+            InstallResizableDialogHandler(hwndDlg, pResizer);
+            InvalidateRect(hwndDlg, NULL, TRUE);  /* makes Vista happier than expected... */
+            // pResizer free'd elsewhere.
+        }
+        else
+        {
+            MyFree(pResizer);
+        }
     }
     else
     {
-        return DialogBoxParamW(hInst, pTemplate, hwndParent, pfnDialog, lParam);
+        LPCVOID pvSource = pt->pvSource;
+
+        // Not resizable, or out of memory.
+        ReleaseResizerTemplate(pt);
+        hwndDlg = (fAnsi) ? CreateDialogIndirectParamA(hInst, pvSource, hwndParent, pfnDialog, lParam)
+                          : CreateDialogIndirectParamW(hInst, pvSource, hwndParent, pfnDialog, lParam);
     }
+
+    return hwndDlg;
 }
 
 /****************************************************************************
  *                                                                          *
- * Function: ResizableDialogBoxIndirectParamA                               *
+ * Function: ResizableDialogBoxWorker                                       *
  *                                                                          *
- * Purpose : Like DialogBoxIndirectParamA(), but for a resizable dialog.    *
+ * Purpose : Create modal dialog from (compiled) template.                  *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static INT_PTR ResizableDialogBoxWorker(HINSTANCE hInst, PRESIZERTEMPLATE pt, HWND hwndParent, DLGPROC pfnDialog, LPARAM lParam, BOOL fAnsi)
+{
+    PRESIZER pResizer;
+    INT_PTR result;
+
+    if (pt->pDlg != NULL && InitPendingSlot() && (pResizer = MakeResizer(pt)) != NULL)
+    {
+        MODALCONTEXT ctx;
+
+        // Something to hang our hat on...
+        g_atPropContext = GlobalAddAtomW(L"ResizerModalContext");
+
+        // Hand over to ResizerDlgProc(), through this thread only.
+        ctx.pResizer = pResizer;
+        ctx.pTemplate = pt;
+        ctx.pfnDialog = pfnDialog;
+        ModalPush(&g_slotPending, &ctx.link);
+
+        result = (fAnsi) ? DialogBoxIndirectParamA(hInst, pt->pDlg, hwndParent, ResizerDlgProc, lParam)
+                         : DialogBoxIndirectParamW(hInst, pt->pDlg, hwndParent, ResizerDlgProc, lParam);
+
+        // Dialog never got as far as the first message?
+        ModalPop(&g_slotPending, &ctx.link);
+
+        // Dialog never got far enough to take ownership?
+        ReleaseResizerTemplate(ctx.pTemplate);
+        MyFree(ctx.pResizer);
+        // pResizer free'd elsewhere.
+
+        GlobalDeleteAtom(g_atPropContext);
+    }
+    else
+    {
+        LPCVOID pvSource = pt->pvSource;
+
+        // Not resizable, or out of memory.
+        ReleaseResizerTemplate(pt);
+        result = (fAnsi) ? DialogBoxIndirectParamA(hInst, pvSource, hwndParent, pfnDialog, lParam)
+                         : DialogBoxIndirectParamW(hInst, pvSource, hwndParent, pfnDialog, lParam);
+    }
+
+    return result;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: GetResizerTemplate                                             *
+ *                                                                          *
+ * Purpose : Return a referenced, compiled template for a dialog resource   *
+ *           (pvName) or in-memory template (pTemplate). Resources, and     *
+ *           templates in read-only module data, can't change; they are     *
+ *           cached for the next caller.                                    *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static PRESIZERTEMPLATE GetResizerTemplate(HINSTANCE hInst, LPCVOID pvName, BOOL fAnsi, LPCDLGTEMPLATEW pTemplate)
+{
+    PRESIZERTEMPLATE pt, ptCached;
+    SIZE_T cbTemplate;
+    BOOL fReadOnly;
+
+    // Seen it before?
+    LockTemplateCache();
+    if ((pt = FindResizerTemplate(hInst, pvName, fAnsi, pTemplate)) != NULL)
+        InterlockedIncrement(&pt->cRefs);
+    UnlockTemplateCache();
+    if (pt != NULL)
+        return pt;
+
+    if (pvName != NULL)
+    {
+        HRSRC hrsrc;
+        HGLOBAL hgRes;
+
+        // Locate the dialog resource.
+        if ((hrsrc = (fAnsi) ? FindResourceA(hInst, pvName, RT_DIALOGA) : FindResourceW(hInst, pvName, RT_DIALOGW)) == NULL ||
+            (hgRes = LoadResource(hInst, hrsrc)) == NULL ||
+            (pTemplate = LockResource(hgRes)) == NULL)
+            return NULL;
+
+        cbTemplate = SizeofResource(hInst, hrsrc);
+        fReadOnly = TRUE;
+    }
+    else
+    {
+        // Size unknown; never read beyond the memory region holding the template.
+        cbTemplate = GetReadableSize(pTemplate, &fReadOnly);
+    }
+
+    // Use the anchor table from the resanchor tool, or compile the template.
+    if ((pvName == NULL || (pt = LoadResizerTemplate(hInst, pvName, fAnsi, pTemplate, cbTemplate)) == NULL) &&
+        (pt = CompileResizerTemplate(hInst, pvName, fAnsi, pTemplate, cbTemplate)) == NULL)
+        return NULL;
+
+    // Heap, stack, and static buffers may change behind our back (same address, new
+    // template), so only cache templates nobody can write to.
+    if (fReadOnly)
+    {
+        LockTemplateCache();
+        if ((ptCached = FindResizerTemplate(hInst, pvName, fAnsi, pTemplate)) != NULL)
+        {
+            // Lost the race to another thread; use the cached one.
+            InterlockedIncrement(&ptCached->cRefs);
+        }
+        else
+        {
+            // One reference for the cache.
+            InterlockedIncrement(&pt->cRefs);
+            pt->pNext = g_pTemplateCache;
+            g_pTemplateCache = pt;
+        }
+        UnlockTemplateCache();
+
+        if (ptCached != NULL)
+        {
+            ReleaseResizerTemplate(pt);
+            pt = ptCached;
+        }
+    }
+
+    return pt;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: FindResizerTemplate                                            *
+ *                                                                          *
+ * Purpose : Search template cache by resource name, or template address.   *
+ *           The cache must be locked.                                      *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static PRESIZERTEMPLATE FindResizerTemplate(HINSTANCE hInst, LPCVOID pvName, BOOL fAnsi, LPCDLGTEMPLATEW pTemplate)
+{
+    PRESIZERTEMPLATE pt;
+
+    for (pt = g_pTemplateCache; pt != NULL; pt = pt->pNext)
+    {
+        if (pt->hInst != hInst)
+            continue;
+
+        if (pvName == NULL)
+        {
+            // Match by address.
+            if (pt->pvSource == pTemplate)
+                return pt;
+        }
+        else if (pt->pvName != NULL && pt->fAnsiName == fAnsi)
+        {
+            // Match by name or ordinal.
+            if (IS_INTRESOURCE(pvName) || IS_INTRESOURCE(pt->pvName))
+            {
+                if (pt->pvName == pvName)
+                    return pt;
+            }
+            else if ((fAnsi) ? lstrcmpiA(pt->pvName, pvName) == 0 : lstrcmpiW(pt->pvName, pvName) == 0)
+            {
+                return pt;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: CompileResizerTemplate                                         *
+ *                                                                          *
+ * Purpose : Process dialog template for a resizable dialog. The result     *
+ *           has one reference, for the caller.                             *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+#define CB_GUESS(n)  (1024 + (SIZE_T)(n) * 128)  /* typical template size, for unknown sizes */
+
+static PRESIZERTEMPLATE CompileResizerTemplate(HINSTANCE hInst, LPCVOID pvName, BOOL fAnsi, LPCDLGTEMPLATEW pTemplate, SIZE_T cbTemplate)
+{
+    PRESIZERTEMPLATE pt;
+    SIZE_T cbNewTemplate;
+    int cDlgItems;
+
+    // The compiled template is never larger than the source; don't
+    // allocate a huge block just because the memory region is big.
+    cDlgItems = DlgGetItemCount(pTemplate, cbTemplate);
+    cbNewTemplate = (cDlgItems > 0) ? min(cbTemplate, CB_GUESS(cDlgItems)) : 0;
+
+    for (;;)
+    {
+        DLGCOMPILEINFO info;
+        SIZE_T cbControls = max(cDlgItems, 0) * sizeof(RESIZERCTL);
+        int rc;
+
+        // Template info, control array (worst case), and compiled template; in one block.
+        if ((pt = AllocResizerTemplate(hInst, pvName, fAnsi, pTemplate, cbControls + cbNewTemplate)) == NULL)
+            return NULL;
+
+        // Must have an extended dialog, with some controls.
+        if (cDlgItems <= 0)
+            return pt;
+
+        // Single pass over the template.
+        pt->pControls = (PRESIZERCTL)(pt + 1);
+        rc = DlgCompileTemplate(pTemplate, cbTemplate, (PBYTE)(pt + 1) + cbControls, cbNewTemplate, pt->pControls, cDlgItems, &info);
+        if (rc == DLGT_E_NOSPACE && info.cbTemplate > cbNewTemplate)
+        {
+            // Bad guess; now we know the exact size.
+            cbNewTemplate = info.cbTemplate;
+            MyFree(pt);
+            continue;
+        }
+
+        if (rc == DLGT_OK && info.cAnchors > 0)
+        {
+            // Found controls to handle during resize.
+            pt->pDlg = (LPDLGTEMPLATE)((PBYTE)(pt + 1) + cbControls);
+            pt->cControls = (int)info.cAnchors;
+            pt->cbUncharged = (LONG)info.cbTemplate;
+            SetTemplateKey(pt, info.cbSource);
+        }
+
+        return pt;
+    }
+}
+
+#undef CB_GUESS
+
+/****************************************************************************
+ *                                                                          *
+ * Function: LoadResizerTemplate                                            *
+ *                                                                          *
+ * Purpose : Use the anchor table written by the resanchor tool, if any.    *
+ *           The dialog resource is then used as-is; nothing is copied.     *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static PRESIZERTEMPLATE LoadResizerTemplate(HINSTANCE hInst, LPCVOID pvName, BOOL fAnsi, LPCDLGTEMPLATEW pTemplate, SIZE_T cbTemplate)
+{
+    PRESIZERTEMPLATE pt;
+    PCANCHORTABLE pTable;
+    SIZE_T cbControls = 0;
+    HGLOBAL hgRes;
+    HRSRC hrsrc;
+
+    // Locate the anchor table, with the same name as the dialog.
+    if ((hrsrc = (fAnsi) ? FindResourceA(hInst, pvName, RT_ANCHORSA) : FindResourceW(hInst, pvName, RT_ANCHORSW)) == NULL ||
+        (hgRes = LoadResource(hInst, hrsrc)) == NULL ||
+        (pTable = LockResource(hgRes)) == NULL ||
+        DlgCheckAnchorTable(pTable, SizeofResource(hInst, hrsrc)) != DLGT_OK)
+        return NULL;
+
+    // Tables from an older tool need converting; current ones are used in place.
+    if (pTable->version != ANCHORTABLE_VERSION)
+        cbControls = pTable->cAnchors * sizeof(RESIZERCTL);
+
+    if ((pt = AllocResizerTemplate(hInst, pvName, fAnsi, pTemplate, cbControls)) == NULL)
+        return NULL;
+
+    // The tool already stripped the creation data, and made the dialog resizable.
+    if (pTable->cAnchors > 0)
+    {
+        pt->pDlg = (LPDLGTEMPLATE)pTemplate;
+        pt->pControls = (PRESIZERCTL)pTable->aAnchors;
+        pt->cControls = (int)pTable->cAnchors;
+        if (cbControls != 0)
+        {
+            pt->pControls = (PRESIZERCTL)(pt + 1);
+            DlgReadAnchorTable(pTable, pt->pControls);
+        }
+        SetTemplateKey(pt, cbTemplate);
+    }
+
+    return pt;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: AllocResizerTemplate                                           *
+ *                                                                          *
+ * Purpose : Allocate template info, with cbExtra bytes following it (and   *
+ *           a copy of the resource name after that). The result has one    *
+ *           reference, for the caller.                                     *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static PRESIZERTEMPLATE AllocResizerTemplate(HINSTANCE hInst, LPCVOID pvName, BOOL fAnsi, LPCDLGTEMPLATEW pTemplate, SIZE_T cbExtra)
+{
+    PRESIZERTEMPLATE pt;
+    SIZE_T cbName = 0;
+
+    // Room for a copy of the resource name.
+    if (pvName != NULL && !IS_INTRESOURCE(pvName))
+        cbName = (fAnsi) ? (lstrlenA(pvName) + 1) * sizeof(CHAR) : (lstrlenW(pvName) + 1) * sizeof(WCHAR);
+
+    if ((pt = MyAlloc(sizeof(*pt) + cbExtra + cbName)) != NULL)
+    {
+        pt->pNext = NULL;
+        pt->hInst = hInst;
+        pt->pvSource = pTemplate;
+        pt->pvName = pvName;
+        pt->fAnsiName = fAnsi;
+        pt->cRefs = 1;
+        pt->pDlg = NULL;
+        pt->pControls = NULL;
+        pt->cControls = 0;
+        pt->cbUncharged = 0;
+        pt->ullKey = 0;
+
+        if (cbName != 0)
+            pt->pvName = memcpy((PBYTE)(pt + 1) + cbExtra, pvName, cbName);
+    }
+
+    return pt;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: SetTemplateKey                                                 *
+ *                                                                          *
+ * Purpose : Set the template identity, for the geometry store: the module  *
+ *           file name, the resource name (if any), and the template bytes. *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static void SetTemplateKey(PRESIZERTEMPLATE pt, SIZE_T cbSource)
+{
+    WCHAR szName[MAX_PATH];
+    ULONGLONG ullKey;
+    DWORD cch;
+
+    // The module, by name; the handle moves from run to run, the store doesn't.
+    cch = (pt->hInst != NULL) ? GetModuleFileNameW(pt->hInst, szName, NELEMS(szName)) : 0;
+    ullKey = DlgHashBytes(szName, CharLowerBuffW(szName, cch) * sizeof(WCHAR));
+
+    // The resource name, as FindResource sees it: ANSI or not, any case.
+    if (IS_INTRESOURCE(pt->pvName))
+    {
+        WORD wOrdinal = LOWORD(pt->pvName);  /* zero for an in-memory template */
+        ullKey = DlgHashMore(ullKey, &wOrdinal, sizeof(wOrdinal));
+    }
+    else
+    {
+        if (pt->fAnsiName)
+            cch = max(MultiByteToWideChar(CP_ACP, 0, pt->pvName, -1, szName, NELEMS(szName)), 1) - 1;
+        else
+            cch = lstrlenW(lstrcpynW(szName, pt->pvName, NELEMS(szName)));
+        ullKey = DlgHashMore(ullKey, szName, CharUpperBuffW(szName, cch) * sizeof(WCHAR));
+    }
+
+    // Same template under the same name; zero means a free slot.
+    ullKey = DlgHashMore(ullKey, pt->pvSource, cbSource);
+    pt->ullKey = (ullKey != 0) ? ullKey : 1;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ReleaseResizerTemplate                                         *
+ *                                                                          *
+ * Purpose : Drop a reference to a compiled template.                       *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static void ReleaseResizerTemplate(PRESIZERTEMPLATE pt)
+{
+    if (pt != NULL && InterlockedDecrement(&pt->cRefs) == 0)
+        MyFree(pt);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: LockTemplateCache                                              *
+ *                                                                          *
+ * Purpose : Lock the template cache; initialize the lock on first use.     *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static void LockTemplateCache(void)
+{
+    // 0 = not initialized, 1 = initializing, 2 = ready.
+    if (g_lCacheInit != 2)
+    {
+        if (InterlockedCompareExchange(&g_lCacheInit, 1, 0) == 0)
+        {
+            InitializeCriticalSection(&g_csCache);
+            InterlockedExchange(&g_lCacheInit, 2);
+        }
+        else
+        {
+            while (g_lCacheInit != 2)
+                Sleep(0);
+        }
+    }
+
+    EnterCriticalSection(&g_csCache);
+}
+
+static void UnlockTemplateCache(void)
+{
+    LeaveCriticalSection(&g_csCache);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: InitPendingSlot                                                *
+ *                                                                          *
+ * Purpose : Allocate the TLS slot for pending modal dialogs, on first use. *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static BOOL InitPendingSlot(void)
+{
+    // Dynamic TLS: a __declspec(thread) variable gets no slot when the
+    // hosting DLL is loaded with LoadLibrary() on Windows XP/2003.
+    // 0 = not initialized, 1 = initializing, 2 = ready (or failed).
+    if (g_lTlsInit != 2)
+    {
+        if (InterlockedCompareExchange(&g_lTlsInit, 1, 0) == 0)
+        {
+            g_dwTlsPending = TlsAlloc();
+            InterlockedExchange(&g_lTlsInit, 2);
+        }
+        else
+        {
+            while (g_lTlsInit != 2)
+                Sleep(0);
+        }
+    }
+
+    return g_dwTlsPending != TLS_OUT_OF_INDEXES;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: MakeResizer                                                    *
+ *                                                                          *
+ * Purpose : Allocate resizer info for a new dialog instance.               *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static PRESIZER MakeResizer(PRESIZERTEMPLATE pt)
+{
+    SIZE_T cbLayout = LayoutGetSize(pt->cControls);
+    PRESIZER pResizer;
+    PBYTE pb;
+    int i;
+
+    // Resizer info, control windows, computed rectangles, layout table, control info, and flags; in one block.
+    pb = MyAlloc(sizeof(*pResizer) + pt->cControls * (sizeof(HWND) + sizeof(LAYOUTRECT)) + cbLayout + pt->cControls * (sizeof(RESIZERCTL) + 2 * sizeof(BOOLEAN)));
+    if (pb == NULL)
+        return NULL;
+
+    pResizer = (PRESIZER)pb; pb += sizeof(*pResizer);
+    pResizer->phwndCtl = (HWND *)pb; pb += pt->cControls * sizeof(HWND);
+    pResizer->prcCtl = (LAYOUTRECT *)pb; pb += pt->cControls * sizeof(LAYOUTRECT);
+    LayoutInit(&pResizer->layout, pb, pt->cControls); pb += cbLayout;
+
+    // Private copy of the control info, exactly sized; the template can go away.
+    pResizer->pControls = memcpy(pb, pt->pControls, pt->cControls * sizeof(RESIZERCTL)); pb += pt->cControls * sizeof(RESIZERCTL);
+    pResizer->cControls = pt->cControls;
+    pResizer->pfStale = memset(pb, FALSE, pt->cControls * sizeof(BOOLEAN)); pb += pt->cControls * sizeof(BOOLEAN);
+    pResizer->pfNested = memset(pb, FALSE, pt->cControls * sizeof(BOOLEAN));
+
+    for (i = 0; i < pResizer->cControls; i++)
+        LayoutSetItem(&pResizer->layout, i, &pResizer->pControls[i]);
+    LayoutBuildDirtySets(&pResizer->layout);
+
+    pResizer->ullKey = pt->ullKey;
+    pResizer->fRebase = FALSE;
+    pResizer->fRelayout = FALSE;
+    pResizer->fOptions = 0;
+    pResizer->fInSizeMove = FALSE;
+    pResizer->fPending = FALSE;
+    pResizer->fTimer = FALSE;
+    pResizer->fParentLayout = FALSE;
+    pResizer->hwndDlg = NULL;
+    pResizer->pParent = NULL;
+    pResizer->pChildren = NULL;
+    pResizer->pNextChild = NULL;
+    pResizer->uDpi = 0;
+    pResizer->hdcBuffer = NULL;
+    pResizer->hbmBuffer = NULL;
+    pResizer->hbmOld = NULL;
+    pResizer->sizeBuffer.cx = pResizer->sizeBuffer.cy = 0;
+    memset(&pResizer->stats, 0, sizeof(pResizer->stats));
+    pResizer->stats.cbSize = sizeof(pResizer->stats);
+
+    // Compiled template (if this dialog was first), and our copy of the control info.
+    ADD_STAT(pResizer, cbTemplateCopied, InterlockedExchange(&pt->cbUncharged, 0) + pt->cControls * sizeof(RESIZERCTL));
+    pResizer->fEnabled = FALSE;
+
+    return pResizer;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: GetReadableSize                                                *
+ *                                                                          *
+ * Purpose : Return number of readable bytes from given address and up,     *
+ *           and whether they are read-only module data (like .rdata).      *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static SIZE_T GetReadableSize(LPCVOID pv, PBOOL pfReadOnly)
+{
+    MEMORY_BASIC_INFORMATION mbi;
+
+    *pfReadOnly = FALSE;
+    if (VirtualQuery(pv, &mbi, sizeof(mbi)) != sizeof(mbi) || mbi.State != MEM_COMMIT || (mbi.Protect & (PAGE_NOACCESS|PAGE_GUARD)) != 0)
+        return 0;
+
+    // Constant data in a loaded module? Not .data (PAGE_READWRITE, or PAGE_WRITECOPY
+    // until first written), not PAGE_EXECUTE_READWRITE. The region has the same
+    // protection throughout, and we never read beyond it.
+    *pfReadOnly = (mbi.Type == MEM_IMAGE && (mbi.Protect & (PAGE_READONLY|PAGE_EXECUTE_READ)) != 0);
+
+    return (SIZE_T)((PBYTE)mbi.BaseAddress + mbi.RegionSize - (PBYTE)pv);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: InstallResizableDialogHandler                                  *
+ *                                                                          *
+ * Purpose : Make the given dialog resizable; call after WM_INITDIALOG.     *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static BOOL InstallResizableDialogHandler(HWND hwndDlg, PRESIZER pResizer)
+{
+    RECT rc;
+    PRESIZER pParent;
+    BOOL fSubclassed;
+
+    // Something to hang our hat on...
+    g_atPropResizer = GlobalAddAtomW(L"ResizerPointer");
+
+    // The minimum dialog size is the original size.
+    GetWindowRect(hwndDlg, &rc);
+    pResizer->sizeMinTrack.cx = RectWidth(&rc);
+    pResizer->sizeMinTrack.cy = RectHeight(&rc);
+    GetClientRect(hwndDlg, &rc);
+    pResizer->sizeMinClient.cx = RectWidth(&rc);
+    pResizer->sizeMinClient.cy = RectHeight(&rc);
+    pResizer->sizeCurClient.cx = RectWidth(&rc);
+    pResizer->sizeCurClient.cy = RectHeight(&rc);
+    pResizer->uDpi = GetWindowDpi(hwndDlg);
+    pResizer->cxGripper = GetGripperSize(pResizer->uDpi);
+    pResizer->fEnabled = TRUE;
+
+    // Original control rectangles, once.
+    CaptureControlRects(hwndDlg, pResizer);
+
+    // Subclass the dialog; the RESIZER comes with every message, no property lookups.
+    fSubclassed = SetWindowSubclass(hwndDlg, ResizerWndProc, IDSC_DIALOG, (DWORD_PTR)pResizer);
+    SETPROP_RESIZER(hwndDlg, pResizer);
+
+    // Nested in a resizable dialog? It lays us out, whether it has us in its template
+    // (captured as a plain control, so far) or we were created later (a tab page).
+    pResizer->hwndDlg = hwndDlg;
+    if ((GetWindowStyle(hwndDlg) & WS_CHILD) && (pParent = GETPROP_RESIZER(GetParent(hwndDlg))) != NULL)
+    {
+        pParent->fRebase = TRUE;
+        pResizer->pParent = pParent;
+        pResizer->pNextChild = pParent->pChildren;
+        pParent->pChildren = pResizer;
+    }
+
+    // Go straight to the size the user picked last time; one layout, before the first paint.
+    RestoreDialogGeometry(hwndDlg, pResizer);
+
+    // Happy? Really?!
+    return fSubclassed && GETPROP_RESIZER(hwndDlg) != NULL;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ResizerDlgProc                                                 *
+ *                                                                          *
+ * Purpose : Handle messages for modal resizable dialog.                    *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static INT_PTR CALLBACK ResizerDlgProc(HWND hwndDlg, UINT msg, WPARAM wParam, LPARAM lParam)
+{
+    PMODALCONTEXT pCtx;
+    INT_PTR result;
+
+    pCtx = GETPROP_CONTEXT(hwndDlg);
+    if (pCtx == NULL)
+    {
+        // First message for a new dialog; claim the latest pending context on this thread.
+        if ((pCtx = (PMODALCONTEXT)ModalClaim(&g_slotPending)) == NULL)
+            return FALSE;
+        SETPROP_CONTEXT(hwndDlg, pCtx);
+    }
+
+    result = (*pCtx->pfnDialog)(hwndDlg, msg, wParam, lParam);
+
+    if (msg == WM_INITDIALOG && pCtx->pTemplate != NULL)
+    {
+        // Dialog created; template not needed anymore.
+        ReleaseResizerTemplate(pCtx->pTemplate);
+        pCtx->pTemplate = NULL;
+    }
+
+    if (msg == WM_INITDIALOG && pCtx->pResizer != NULL)
+    {
+        // Install handler after processing WM_INIDIALOG;
+        // not optimal, but consistent with modeless dialogs.
+        InstallResizableDialogHandler(hwndDlg, pCtx->pResizer);
+        pCtx->pResizer = NULL;
+    }
+    else if (msg == WM_NCDESTROY)
+    {
+        // Last message; the context goes away with DialogBoxIndirectParam().
+        REMOVEPROP_CONTEXT(hwndDlg);
+    }
+
+    return result;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ResizerWndProc                                                 *
+ *                                                                          *
+ * Purpose : Handle messages for subclassed resizable dialog.               *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static LRESULT CALLBACK ResizerWndProc(HWND hwndDlg, UINT msg, WPARAM wParam, LPARAM lParam, UINT_PTR uIdSubclass, DWORD_PTR dwRefData)
+{
+    PRESIZER pResizer = (PRESIZER)dwRefData;  /* from SetWindowSubclass() */
+
+    // Like HANDLE_MSG(), but the handlers get the RESIZER too.
+    switch (msg)
+    {
+        case WM_GETMINMAXINFO:
+            Resizer_OnGetMinMaxInfo(hwndDlg, pResizer, (PMINMAXINFO)lParam);
+            return 0;
+        case WM_NCHITTEST:
+            return (LRESULT)Resizer_OnNCHitTest(hwndDlg, pResizer, (int)(short)LOWORD(lParam), (int)(short)HIWORD(lParam));
+        case WM_SIZING:
+            return (LRESULT)Resizer_OnSizing(hwndDlg, pResizer, (UINT)wParam, (PRECT)lParam);
+        case WM_SIZE:
+            Resizer_OnSize(hwndDlg, pResizer, (UINT)wParam, (int)(short)LOWORD(lParam), (int)(short)HIWORD(lParam));
+            return 0;
+        case WM_ENTERSIZEMOVE:
+            Resizer_OnEnterSizeMove(hwndDlg, pResizer);
+            return 0;
+        case WM_EXITSIZEMOVE:
+            Resizer_OnExitSizeMove(hwndDlg, pResizer);
+            return 0;
+        case WM_TIMER:
+            if (Resizer_OnTimer(hwndDlg, pResizer, (UINT_PTR)wParam))
+                return 0;
+            break;
+        case WM_ERASEBKGND:
+            return (LRESULT)Resizer_OnEraseBkgnd(hwndDlg, pResizer, (HDC)wParam);
+        case WM_SETTINGCHANGE:
+            Resizer_OnSettingChange(hwndDlg, pResizer, (UINT)wParam, (LPCTSTR)lParam);
+            return 0;
+        case WM_DPICHANGED:
+            Resizer_OnDpiChanged(hwndDlg, pResizer, LOWORD(wParam), HIWORD(wParam), (PRECT)lParam);
+            return 0;
+        case WM_DPICHANGED_AFTERPARENT:
+            Resizer_OnDpiChangedAfterParent(hwndDlg, pResizer);
+            return 0;
+        case WM_DESTROY:
+            Resizer_OnDestroy(hwndDlg, pResizer);
+            return 0;
+    }
+
+    // Send to the original procedure.
+    return DefSubclassProc(hwndDlg, msg, wParam, lParam);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Resizer_OnGetMinMaxInfo                                        *
+ *                                                                          *
+ * Purpose : Handle WM_GETMINMAXINFO message.                               *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static void Resizer_OnGetMinMaxInfo(HWND hwndDlg, PRESIZER pResizer, PMINMAXINFO pmmi)
+{
+    if (pResizer->fEnabled)
+    {
+        // Set the minimum tracking size.
+        pmmi->ptMinTrackSize.x = pResizer->sizeMinTrack.cx;
+        pmmi->ptMinTrackSize.y = pResizer->sizeMinTrack.cy;
+    }
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Resizer_OnNCHitTest                                            *
+ *                                                                          *
+ * Purpose : Handle WM_NCHITTEST message.                                   *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static UINT Resizer_OnNCHitTest(HWND hwndDlg, PRESIZER pResizer, int x, int y)
+{
+    int cx, cy;
+    RECT rc;
+
+    GetGripperRect(hwndDlg, pResizer, &rc);
+    MapWindowRect(hwndDlg, NULL, &rc);
+    cx = x - rc.left;
+    cy = y - rc.top;
+    if (cx > 0 && cy > 0 && RectWidth(&rc) < cx + cy)
+        return HTBOTTOMRIGHT;
+
+    return (UINT)DefSubclassProc(hwndDlg, WM_NCHITTEST, 0, MAKELPARAM(x,y));
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Resizer_OnSizing                                               *
+ *                                                                          *
+ * Purpose : Handle WM_SIZING message.                                      *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static BOOL Resizer_OnSizing(HWND hwndDlg, PRESIZER pResizer, UINT fSize, PRECT prc)
+{
+    BOOL fResult;
+    RECT rc;
+
+    fResult = (BOOL)DefSubclassProc(hwndDlg, WM_SIZING, (WPARAM)fSize, (LPARAM)prc);
+
+    GetGripperRect(hwndDlg, pResizer, &rc);
+    InvalidateRect(hwndDlg, &rc, FALSE);
+
+    return fResult;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Resizer_OnSize                                                 *
+ *                                                                          *
+ * Purpose : Handle WM_SIZE message.                                        *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static void Resizer_OnSize(HWND hwndDlg, PRESIZER pResizer, UINT state, int cx, int cy)
+{
+    PRESIZER pChild;
+
+    // The dialog procedure may resize child dialogs too (tab pages); they wait for our pass.
+    if (state != SIZE_MINIMIZED)
+    {
+        for (pChild = pResizer->pChildren; pChild != NULL; pChild = pChild->pNextChild)
+            pChild->fParentLayout = TRUE;
+    }
+
+    (void)DefSubclassProc(hwndDlg, WM_SIZE, (WPARAM)state, MAKELPARAM(cx, cy));
+
+    if (state != SIZE_MINIMIZED)
+    {
+        RECT rc;
+
+        if (pResizer->fParentLayout)
+        {
+            // Resized by a resizable parent; it lays us out once it's done.
+        }
+        else if ((pResizer->fOptions & RDO_COALESCE) && pResizer->fInSizeMove)
+        {
+            // Replace a layout nobody got to see.
+            if (pResizer->fPending)
+                ADD_STAT(pResizer, cSkippedPasses, 1);
+
+            pResizer->sizePending.cx = cx;
+            pResizer->sizePending.cy = cy;
+            pResizer->fPending = TRUE;
+
+            // First change in a while? Lay out now, and hold the rest for the timer.
+            if (!pResizer->fTimer)
+            {
+                FlushPendingLayout(hwndDlg, pResizer);
+                pResizer->fTimer = SetTimer(hwndDlg, GetCoalesceTimerId(pResizer), MS_COALESCE, NULL) != 0;
+            }
+        }
+        else
+        {
+            MoveDialogControls(hwndDlg, pResizer, cx, cy);
+        }
+
+        GetGripperRect(hwndDlg, pResizer, &rc);
+        InvalidateRect(hwndDlg, &rc, TRUE);
+    }
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Resizer_OnEnterSizeMove                                        *
+ *                                                                          *
+ * Purpose : Handle WM_ENTERSIZEMOVE message.                               *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static void Resizer_OnEnterSizeMove(HWND hwndDlg, PRESIZER pResizer)
+{
+    pResizer->fInSizeMove = TRUE;
+
+    (void)DefSubclassProc(hwndDlg, WM_ENTERSIZEMOVE, 0, 0);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Resizer_OnExitSizeMove                                         *
+ *                                                                          *
+ * Purpose : Handle WM_EXITSIZEMOVE message.                                *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static void Resizer_OnExitSizeMove(HWND hwndDlg, PRESIZER pResizer)
+{
+    // One exact layout for the final size.
+    pResizer->fInSizeMove = FALSE;
+    FlushPendingLayout(hwndDlg, pResizer);
+
+    (void)DefSubclassProc(hwndDlg, WM_EXITSIZEMOVE, 0, 0);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Resizer_OnTimer                                                *
+ *                                                                          *
+ * Purpose : Handle WM_TIMER message; FALSE if the timer isn't ours.        *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static BOOL Resizer_OnTimer(HWND hwndDlg, PRESIZER pResizer, UINT_PTR id)
+{
+    // Not ours? Let the dialog have it, with the original lParam (TIMERPROC).
+    if (id != GetCoalesceTimerId(pResizer))
+        return FALSE;
+
+    if (pResizer->fPending)
+    {
+        // Catch up with the latest size.
+        MoveDialogControls(hwndDlg, pResizer, pResizer->sizePending.cx, pResizer->sizePending.cy);
+        pResizer->fPending = FALSE;
+    }
+    else
+    {
+        // Nothing happened for a whole tick; stop until the next change.
+        KillTimer(hwndDlg, GetCoalesceTimerId(pResizer));
+        pResizer->fTimer = FALSE;
+    }
+
+    return TRUE;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Resizer_OnEraseBkgnd                                           *
+ *                                                                          *
+ * Purpose : Handle WM_ERASEBKGND message.                                  *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static BOOL Resizer_OnEraseBkgnd(HWND hwndDlg, PRESIZER pResizer, HDC hdc)
+{
+    LONGLONG llStart;
+    LONGLONG llTicks;
+    LONGLONG llPeak;
+    HDC hdcPaint = hdc;
+    BOOL fResult;
+    RECT rc, rcClip;
+
+    llStart = GetTicks();
+
+    // Paint background and gripper off-screen, and copy it in one go?
+    if ((pResizer->fOptions & RDO_DOUBLEBUFFER) && GetClipBox(hdc, &rcClip) != ERROR)
+    {
+        GetClientRect(hwndDlg, &rc);
+        if ((hdcPaint = GetBufferDC(pResizer, hdc, &rc)) != NULL)
+        {
+            // Same clipping, so the dialog doesn't erase more than it has to.
+            SelectClipRgn(hdcPaint, NULL);
+            IntersectClipRect(hdcPaint, rcClip.left, rcClip.top, rcClip.right, rcClip.bottom);
+        }
+        else
+        {
+            hdcPaint = hdc;
+        }
+    }
+
+    fResult = (BOOL)DefSubclassProc(hwndDlg, WM_ERASEBKGND, (WPARAM)hdcPaint, 0);
+
+    GetGripperRect(hwndDlg, pResizer, &rc);
+    DrawFrameControl(hdcPaint, &rc, DFC_SCROLL, DFCS_SCROLLSIZEGRIP);
+
+    if (hdcPaint != hdc)
+        BitBlt(hdc, rcClip.left, rcClip.top, RectWidth(&rcClip), RectHeight(&rcClip), hdcPaint, rcClip.left, rcClip.top, SRCCOPY);
+
+    llTicks = GetTicks() - llStart;
+    ADD_STAT(pResizer, cEraseBkgnd, 1);
+    ADD_STAT64(pResizer, ullEraseTime, llTicks);
+    TraceEvent(hwndDlg, pResizer, RTE_ERASEBKGND, 0, llTicks);
+
+    // New worst frame?
+    if ((ULONGLONG)llTicks > pResizer->stats.ullMaxEraseTime)
+        pResizer->stats.ullMaxEraseTime = llTicks;
+    while ((llPeak = g_stats.ullMaxEraseTime) < llTicks &&
+        InterlockedCompareExchange64((LONGLONG volatile *)&g_stats.ullMaxEraseTime, llTicks, llPeak) != llPeak)
+        ;
+
+    return fResult;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Resizer_OnSettingChange                                        *
+ *                                                                          *
+ * Purpose : Handle WM_SETTINGCHANGE message.                               *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static void Resizer_OnSettingChange(HWND hwndDlg, PRESIZER pResizer, UINT uiAction, LPCTSTR pszSection)
+{
+    RECT rc;
+
+    (void)DefSubclassProc(hwndDlg, WM_SETTINGCHANGE, (WPARAM)uiAction, (LPARAM)pszSection);
+
+    // Scroll bar size may have changed (SPI_SETNONCLIENTMETRICS, and friends); repaint old and new gripper.
+    GetGripperRect(hwndDlg, pResizer, &rc);
+    InvalidateRect(hwndDlg, &rc, TRUE);
+    pResizer->cxGripper = GetGripperSize(pResizer->uDpi);
+    GetGripperRect(hwndDlg, pResizer, &rc);
+    InvalidateRect(hwndDlg, &rc, TRUE);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Resizer_OnDpiChanged                                           *
+ *                                                                          *
+ * Purpose : Handle WM_DPICHANGED message.                                  *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static void Resizer_OnDpiChanged(HWND hwndDlg, PRESIZER pResizer, UINT dpiX, UINT dpiY, PRECT prcSuggested)
+{
+    RECT rcOld, rcNew;
+
+    // Let the system (or the dialog) rescale first; our numbers are stale until we're done.
+    pResizer->fEnabled = FALSE;
+
+    GetWindowRect(hwndDlg, &rcOld);
+    (void)DefSubclassProc(hwndDlg, WM_DPICHANGED, MAKEWPARAM(dpiX, dpiY), (LPARAM)prcSuggested);
+    GetWindowRect(hwndDlg, &rcNew);
+
+    // Nobody took the hint? Use the suggested rectangle.
+    if (EqualRect(&rcOld, &rcNew) && prcSuggested != NULL)
+    {
+        SetWindowPos(hwndDlg, NULL, prcSuggested->left, prcSuggested->top,
+            RectWidth(prcSuggested), RectHeight(prcSuggested), SWP_NOZORDER|SWP_NOACTIVATE);
+    }
+
+    RescaleDialog(hwndDlg, pResizer, dpiY);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Resizer_OnDpiChangedAfterParent                                *
+ *                                                                          *
+ * Purpose : Handle WM_DPICHANGED_AFTERPARENT message (child dialogs).      *
  *                                                                          *
  * History : Date      Reason                                               *
  *           09-02-22  Created                                              *
  *                                                                          *
  ****************************************************************************/
 
-INT_PTR WINAPI ResizableDialogBoxIndirectParamA(HINSTANCE hInst, LPCDLGTEMPLATEA pTemplate, HWND hwndParent, DLGPROC pfnDialog, LPARAM lParam)
+static void Resizer_OnDpiChangedAfterParent(HWND hwndDlg, PRESIZER pResizer)
 {
-    LPDLGTEMPLATE pNewTemplate;
-    PRESIZER pResizer;
-    INT_PTR result;
-
-    if (MakeResizableDialog(pTemplate, &pNewTemplate, &pResizer))
-    {
-        // Warning! Global variables.
-        g_pResizer = pResizer;
-        g_pfnDialog = pfnDialog;
-
-        result = DialogBoxIndirectParamA(hInst, pNewTemplate, hwndParent, ResizerDlgProc, lParam);
+    pResizer->fEnabled = FALSE;
 
-        MyFree(pNewTemplate);
-        // pResizer free'd elsewhere.
-    }
-    else
-    {
-        result = DialogBoxIndirectParamA(hInst, pTemplate, hwndParent, pfnDialog, lParam);
-    }
+    (void)DefSubclassProc(hwndDlg, WM_DPICHANGED_AFTERPARENT, 0, 0);
 
-    return result;
+    RescaleDialog(hwndDlg, pResizer, GetWindowDpi(hwndDlg));
 }
 
 /****************************************************************************
  *                                                                          *
- * Function: ResizableDialogBoxIndirectParamW                               *
+ * Function: Resizer_OnDestroy                                              *
  *                                                                          *
- * Purpose : Like DialogBoxIndirectParamW(), but for a resizable dialog.    *
+ * Purpose : Handle WM_DESTROY message.                                     *
  *                                                                          *
  * History : Date      Reason                                               *
  *           09-02-22  Created                                              *
  *                                                                          *
  ****************************************************************************/
 
-INT_PTR WINAPI ResizableDialogBoxIndirectParamW(HINSTANCE hInst, LPCDLGTEMPLATEW pTemplate, HWND hwndParent, DLGPROC pfnDialog, LPARAM lParam)
+static void Resizer_OnDestroy(HWND hwndDlg, PRESIZER pResizer)
 {
-    LPDLGTEMPLATE pNewTemplate;
-    PRESIZER pResizer;
-    INT_PTR result;
-
-    if (MakeResizableDialog(pTemplate, &pNewTemplate, &pResizer))
+    // Clean up.
+    PRESIZER *ppChild;
+    int i;
+    SaveDialogGeometry(hwndDlg, pResizer);
+
+    // Child dialogs are destroyed after us; leave the parent's list.
+    for (; pResizer->pChildren != NULL; pResizer->pChildren = pResizer->pChildren->pNextChild)
+        pResizer->pChildren->pParent = NULL;
+    if (pResizer->pParent != NULL)
     {
-        // Warning! Global variables.
-        g_pResizer = pResizer;
-        g_pfnDialog = pfnDialog;
-
-        result = DialogBoxIndirectParamW(hInst, pNewTemplate, hwndParent, ResizerDlgProc, lParam);
-
-        MyFree(pNewTemplate);
-        // pResizer free'd elsewhere.
+        for (ppChild = &pResizer->pParent->pChildren; *ppChild != NULL; ppChild = &(*ppChild)->pNextChild)
+        {
+            if (*ppChild == pResizer)
+            {
+                *ppChild = pResizer->pNextChild;
+                break;
+            }
+        }
     }
-    else
+
+    if (pResizer->fTimer)
+        KillTimer(hwndDlg, GetCoalesceTimerId(pResizer));
+    for (i = 0; i < pResizer->cControls; i++)
     {
-        result = DialogBoxIndirectParamW(hInst, pTemplate, hwndParent, pfnDialog, lParam);
+        if (pResizer->pfStale[i])
+            UndeferHiddenControl(pResizer, i);
     }
+    FreeBufferDC(pResizer);
+    RemoveWindowSubclass(hwndDlg, ResizerWndProc, IDSC_DIALOG);
+    REMOVEPROP_RESIZER(hwndDlg);
+    MyFree(pResizer);
+    pResizer = NULL;
 
-    return result;
+    DefSubclassProc(hwndDlg, WM_DESTROY, 0, 0);
+
+    GlobalDeleteAtom(g_atPropResizer);
 }
 
 /****************************************************************************
  *                                                                          *
- * Function: MakeResizableDialog                                            *
+ * Function: MoveDialogControls                                             *
  *                                                                          *
- * Purpose : Process dialog template for a resizable dialog.                *
+ * Purpose : Move dialog controls to new locations.                         *
  *                                                                          *
  * History : Date      Reason                                               *
  *           09-02-22  Created                                              *
  *                                                                          *
  ****************************************************************************/
 
-static BOOL MakeResizableDialog(LPCDLGTEMPLATEW pTemplate, LPDLGTEMPLATE *ppNewTemplate, PRESIZER *ppResizer)
+static void MoveDialogControls(HWND hwndDlg, PRESIZER pResizer, int cx, int cy)
 {
-    LPCDLGTEMPLATEEX pDlg = (LPCDLGTEMPLATEEX)pTemplate;
-    SIZE_T cbTemplate;
-
-    // Calculate size of (extended) dialog template.
-    if ((cbTemplate = SizeOfExtendedTemplate(pTemplate)) != 0)
+    if (pResizer->fEnabled)
     {
-        LPDLGTEMPLATEEX pNewTemplate = NULL;
-        PRESIZER pResizer = NULL;
-
-        // Allocate memory (worst case for template and control array).
-        if ((pNewTemplate = MyAlloc(cbTemplate)) != NULL &&
-            (pResizer = MyAlloc(sizeof(*pResizer))) != NULL &&
-            (pResizer->pControls = MyAlloc(pDlg->cDlgItems * sizeof(*pResizer->pControls))) != NULL)
-        {
-            PVOID pvNew = pNewTemplate;
-            const VOID *pv = &pDlg->menu;
-            WORD i;
-
-            // Skip menu.
-            pv = (PBYTE)pv + NameOrdLenW(pv);
-
-            // Skip class.
-            pv = (PBYTE)pv + NameOrdLenW(pv);
-
-            // Skip window title.
-            pv = (PBYTE)pv + NameOrdLenW(pv);
-
-            // Font specification present?
-            if ((pDlg->style & DS_SETFONT) != 0)
-            {
-                // Skip point size.
-                pv = (PBYTE)pv + sizeof(WORD);
+        const uint32_t *pIndex;
+        unsigned int fAxes = 0;
+        size_t cIndex;
+        LONGLONG llStart, llTicks;
+        HDWP hdwp;
 
-                // Skip weight.
-                pv = (PBYTE)pv + sizeof(WORD);
+        llStart = GetTicks();
 
-                // Skip italic.
-                pv = (PBYTE)pv + sizeof(BYTE);
+        // Controls moved behind our back?
+        if (pResizer->fRebase)
+            CaptureControlRects(hwndDlg, pResizer);
 
-                // Skip charset.
-                pv = (PBYTE)pv + sizeof(BYTE);
+        // Make sure we don't go below the minimum dialog size.
+        cx = max(cx, pResizer->sizeMinClient.cx);
+        cy = max(cy, pResizer->sizeMinClient.cy);
 
-                // Skip typeface.
-                pv = (PBYTE)pv + NameOrdLenW(pv);
-            }
+        // Only controls anchored to a changed axis will move.
+        if (cx != pResizer->sizeCurClient.cx || pResizer->fRelayout) fAxes |= LAYOUT_HORZ;
+        if (cy != pResizer->sizeCurClient.cy || pResizer->fRelayout) fAxes |= LAYOUT_VERT;
+        pResizer->fRelayout = FALSE;
+        if ((cIndex = LayoutGetDirtySet(&pResizer->layout, fAxes, &pIndex)) == 0)
+        {
+            // Nothing anchored to the changed axes; still the new size, and still a pass.
+            pResizer->sizeCurClient.cx = cx;
+            pResizer->sizeCurClient.cy = cy;
+            llTicks = GetTicks() - llStart;
+            ADD_STAT(pResizer, cLayoutPasses, 1);
+            ADD_STAT64(pResizer, ullLayoutTime, llTicks);
+            TraceEvent(hwndDlg, pResizer, RTE_LAYOUT, 0, llTicks);
+        }
+        else if ((hdwp = BeginDeferWindowPos((int)cIndex)) != NULL)
+        {
+            DWORD cMoved = 0;
+            DWORD cNested = 0;
+            PRESIZER pChild;
+            size_t k;
 
-            // Align.
-            pv = DWordAlign(pv);
+            // Remember for next time.
+            pResizer->sizeCurClient.cx = cx;
+            pResizer->sizeCurClient.cy = cy;
 
-            // Append part to new template.
-            pvNew = AppendBlock(pvNew, pDlg, (PBYTE)pv - (PBYTE)pDlg);
+            // Calculate the rectangles from the total delta; no drift, no system calls.
+            LayoutComputeSet(&pResizer->layout, cx - pResizer->sizeMinClient.cx, cy - pResizer->sizeMinClient.cy, pIndex, cIndex, pResizer->prcCtl);
 
-            // Process the controls.
-            pResizer->cControls = 0;
-            for (i = 0; i < pDlg->cDlgItems; i++)
+            // Move the controls.
+            for (k = 0; k < cIndex; k++)
             {
-                LPCDLGITEMTEMPLATEEX pCtl = pv;
-                PCEXTRADATA pExtraData;
-                WORD cbExtraData;
-
-                pv = &pCtl->windowClass;
-
-                // Skip window class.
-                pv = (PBYTE)pv + NameOrdLenW(pv);
-
-                // Skip window title.
-                pv = (PBYTE)pv + NameOrdLenW(pv);
+                HWND hwndCtl = pResizer->phwndCtl[pIndex[k]];
+                PCLAYOUTRECT prc;
 
-                // Append part to new template.
-                pvNew = AppendBlock(pvNew, pCtl, (PBYTE)pv - (PBYTE)pCtl);
+                if (hwndCtl == NULL || pResizer->pfStale[pIndex[k]])
+                    continue;
 
-                // Process control creation data.
-                cbExtraData = *(PWORD)pv;
-                pv = (PBYTE)pv + sizeof(WORD);
-                pExtraData = pv;
-                pv = (PBYTE)pv + cbExtraData;
-
-                // Look for our version of "creation data".
-                if (cbExtraData == sizeof(*pExtraData) && pExtraData->magic == EXTRA_MAGIC && pExtraData->version == EXTRA_VERSION)
+                // Nested resizable dialog? Laid out by us, after this batch; never subclassed.
+                if (pResizer->pfNested[pIndex[k]] && (pChild = GetNestedResizer(hwndCtl)) != NULL)
                 {
-                    // Avoid "nameless" controls.
-                    if (pCtl->id != -1U)
-                    {
-                        // Found a control to handle during resize.
-                        int k = pResizer->cControls++;
-                        pResizer->pControls[k].id = pCtl->id;
-                        pResizer->pControls[k].fuAlign = (BYTE)pExtraData->fuAlign;
-                    }
-
-                    // Strip away creation data.
-                    *(PWORD)pvNew = 0;
-                    pvNew = (PBYTE)pvNew + sizeof(WORD);
+                    pChild->fParentLayout = TRUE;
+                    cNested++;
                 }
-                else
+                // Hidden controls (like on inactive tab pages) are moved when shown.
+                else if ((GetWindowStyle(hwndCtl) & WS_VISIBLE) == 0)
                 {
-                    // Append user-defined creation data.
-                    *(PWORD)pvNew = cbExtraData;
-                    pvNew = (PBYTE)pvNew + sizeof(WORD);
-                    pvNew = AppendBlock(pvNew, pExtraData, cbExtraData);
+                    DeferHiddenControl(pResizer, pIndex[k]);
+                    continue;
                 }
 
-                // Align.
-                pvNew = DWordAlign(pvNew);
-                pv = DWordAlign(pv);
+                prc = &pResizer->prcCtl[k];
+
+                // Move or resize the dialog control window.
+                hdwp = DeferWindowPos(hdwp, hwndCtl, NULL, prc->left, prc->top,
+                    prc->right - prc->left, prc->bottom - prc->top, SWP_NOZORDER);
+                cMoved++;
             }
 
-            if (pResizer->cControls > 0)
+            EndDeferWindowPos(hdwp);
+
+            llTicks = GetTicks() - llStart;
+            ADD_STAT(pResizer, cLayoutPasses, 1);
+            ADD_STAT(pResizer, cControlsMoved, cMoved);
+            ADD_STAT64(pResizer, ullLayoutTime, llTicks);
+            TraceEvent(hwndDlg, pResizer, RTE_LAYOUT, cMoved, llTicks);
+
+            // Now the nested dialogs, top-down; one batch for each.
+            for (k = 0; k < cIndex && cNested != 0; k++)
             {
-                // Make the dialog resizable.
-                pNewTemplate->style |= WS_THICKFRAME;
+                HWND hwndCtl = pResizer->phwndCtl[pIndex[k]];
 
-                // Return to the happy caller.
-                *ppNewTemplate = (DLGTEMPLATE *)pNewTemplate;
-                *ppResizer = pResizer;
-                return TRUE;
-            }
+                if (hwndCtl != NULL && pResizer->pfNested[pIndex[k]] && (pChild = GetNestedResizer(hwndCtl)) != NULL && pChild->fParentLayout)
+                {
+                    RECT rc;
 
-            // Clean up.
-            MyFree(pResizer->pControls);
-            MyFree(pResizer);
+                    pChild->fParentLayout = FALSE;
+                    pChild->fPending = FALSE;
+                    GetClientRect(hwndCtl, &rc);
+                    MoveDialogControls(hwndCtl, pChild, RectWidth(&rc), RectHeight(&rc));
+                    cNested--;
+                }
+            }
         }
-
-        // Clean up.
-        MyFree(pNewTemplate);
     }
 
-    // Return to the (soon to be) unhappy caller.
-    *ppNewTemplate = NULL;
-    *ppResizer = NULL;
-    return FALSE;
+    // Child dialogs we don't anchor, resized by the dialog procedure.
+    if (pResizer->pChildren != NULL)
+        MoveChildDialogs(pResizer);
 }
 
 /****************************************************************************
  *                                                                          *
- * Function: SizeOfExtendedTemplate                                         *
+ * Function: MoveChildDialogs                                               *
  *                                                                          *
- * Purpose : Return length of extended dialog template, else zero.          *
+ * Purpose : Lay out the resizable child dialogs that waited for our pass,  *
+ *           and changed size.                                              *
  *                                                                          *
  * History : Date      Reason                                               *
  *           09-02-22  Created                                              *
  *                                                                          *
  ****************************************************************************/
 
-static SIZE_T SizeOfExtendedTemplate(LPCDLGTEMPLATEW pTemplate)
+static void MoveChildDialogs(PRESIZER pResizer)
 {
-    LPCDLGTEMPLATEEX pDlg = (LPCDLGTEMPLATEEX)pTemplate;
+    PRESIZER pChild;
 
-    // Must have an extended dialog.
-    if (pDlg->signature == 0xFFFF && pDlg->dlgVer == 1)
+    for (pChild = pResizer->pChildren; pChild != NULL; pChild = pChild->pNextChild)
     {
-        const VOID *pv = &pDlg->menu;
-        WORD i;
-
-        // Skip menu.
-        pv = (PBYTE)pv + NameOrdLenW(pv);
+        if (pChild->fParentLayout)
+        {
+            RECT rc;
 
-        // Skip class.
-        pv = (PBYTE)pv + NameOrdLenW(pv);
+            pChild->fParentLayout = FALSE;
+            pChild->fPending = FALSE;
+            GetClientRect(pChild->hwndDlg, &rc);
+            if (RectWidth(&rc) != pChild->sizeCurClient.cx || RectHeight(&rc) != pChild->sizeCurClient.cy || pChild->fRelayout)
+                MoveDialogControls(pChild->hwndDlg, pChild, RectWidth(&rc), RectHeight(&rc));
+        }
+    }
+}
 
-        // Skip window title.
-        pv = (PBYTE)pv + NameOrdLenW(pv);
+/****************************************************************************
+ *                                                                          *
+ * Function: CaptureControlRects                                            *
+ *                                                                          *
+ * Purpose : Look up the control windows, and remember their rectangles     *
+ *           at the original dialog size.                                   *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
 
-        // Font specification present?
-        if ((pDlg->style & DS_SETFONT) != 0)
-        {
-            // Skip point size.
-            pv = (PBYTE)pv + sizeof(WORD);
+static void CaptureControlRects(HWND hwndDlg, PRESIZER pResizer)
+{
+    int dx, dy;
+    int i;
 
-            // Skip weight.
-            pv = (PBYTE)pv + sizeof(WORD);
+    // The current rectangles were laid out for this delta.
+    dx = pResizer->sizeCurClient.cx - pResizer->sizeMinClient.cx;
+    dy = pResizer->sizeCurClient.cy - pResizer->sizeMinClient.cy;
 
-            // Skip italic.
-            pv = (PBYTE)pv + sizeof(BYTE);
+    for (i = 0; i < pResizer->cControls; i++)
+    {
+        HWND hwndCtl;
 
-            // Skip charset.
-            pv = (PBYTE)pv + sizeof(BYTE);
+        hwndCtl = GetDlgItem(hwndDlg, pResizer->pControls[i].id);
 
-            // Skip typeface.
-            pv = (PBYTE)pv + NameOrdLenW(pv);
+        // Still waiting to be shown? Then the base rectangle is already right.
+        if (pResizer->pfStale[i])
+        {
+            if (hwndCtl == pResizer->phwndCtl[i])
+                continue;
+            UndeferHiddenControl(pResizer, i);
         }
 
-        // Align.
-        pv = DWordAlign(pv);
-
-        // Process the controls.
-        for (i = 0; i < pDlg->cDlgItems; i++)
+        if (hwndCtl != NULL)
         {
-            LPCDLGITEMTEMPLATEEX pCtl = pv;
-
-            pv = &pCtl->windowClass;
-
-            // Skip window class.
-            pv = (PBYTE)pv + NameOrdLenW(pv);
+            RECT rc;
 
-            // Skip window title.
-            pv = (PBYTE)pv + NameOrdLenW(pv);
+            // Get the current window rectangle, in client coordinates.
+            GetWindowRect(hwndCtl, &rc);
+            MapWindowRect(NULL, hwndDlg, &rc);
 
-            // Skip control creation data.
-            pv = (PBYTE)pv + sizeof(WORD) + *(PWORD)pv;
-
-            // Align.
-            pv = DWordAlign(pv);
+            // RECT and LAYOUTRECT share layout.
+            LayoutSetBase(&pResizer->layout, i, (PCLAYOUTRECT)&rc, dx, dy);
         }
 
-        // Return the size, in bytes.
-        return (PBYTE)pv - (PBYTE)pTemplate;
+        // Once here, not one property lookup for each control in every layout pass.
+        pResizer->pfNested[i] = (hwndCtl != NULL && GetNestedResizer(hwndCtl) != NULL);
+        pResizer->phwndCtl[i] = hwndCtl;
     }
 
-    // Very, very, small.
-    return 0;
+    pResizer->fRebase = FALSE;
 }
 
 /****************************************************************************
  *                                                                          *
- * Function: NameOrdLenW                                                    *
+ * Function: DeferHiddenControl                                             *
  *                                                                          *
- * Purpose : Return length of name/ordinal value.                           *
+ * Purpose : Don't move a hidden control now; subclass it, and move it      *
+ *           when it's about to be shown.                                   *
  *                                                                          *
  * History : Date      Reason                                               *
  *           09-02-22  Created                                              *
  *                                                                          *
  ****************************************************************************/
 
-static size_t NameOrdLenW(PCWSTR pwchNameOrd)
+static void DeferHiddenControl(PRESIZER pResizer, int i)
 {
-    if (IsOrdinalW(pwchNameOrd))
-        return 2 * sizeof(WCHAR);
-    else
-        return (wcslen(pwchNameOrd)+1) * sizeof(WCHAR);
+    HWND hwndCtl = pResizer->phwndCtl[i];
+
+    SetWindowSubclass(hwndCtl, ResizerControlProc, IDSC_CONTROL, (DWORD_PTR)pResizer);
+    pResizer->pfStale[i] = TRUE;
+    ADD_STAT(pResizer, cControlsDeferred, 1);
+}
+
+static void UndeferHiddenControl(PRESIZER pResizer, int i)
+{
+    HWND hwndCtl = pResizer->phwndCtl[i];
+
+    RemoveWindowSubclass(hwndCtl, ResizerControlProc, IDSC_CONTROL);
+    pResizer->pfStale[i] = FALSE;
 }
 
 /****************************************************************************
  *                                                                          *
- * Function: MakeDialogResizable                                            *
+ * Function: ResizerControlProc                                             *
  *                                                                          *
- * Purpose : Make the given dialog resizable; Call from WM_INITDIALOG.      *
+ * Purpose : Handle messages for subclassed hidden control. The control     *
+ *           is moved into place in WM_WINDOWPOSCHANGING, so it appears at  *
+ *           the right location right away.                                 *
  *                                                                          *
  * History : Date      Reason                                               *
  *           09-02-22  Created                                              *
  *                                                                          *
  ****************************************************************************/
 
-static BOOL InstallResizableDialogHandler(HWND hwndDlg, PRESIZER pResizer)
+static LRESULT CALLBACK ResizerControlProc(HWND hwndCtl, UINT msg, WPARAM wParam, LPARAM lParam, UINT_PTR uIdSubclass, DWORD_PTR dwRefData)
 {
-    RECT rc;
+    PRESIZER pResizer = (PRESIZER)dwRefData;  /* from SetWindowSubclass() */
 
-    // Something to hang our hat on...
-    g_atPropWndProc = GlobalAddAtomW(L"ResizerWindowProc");
-    g_atPropResizer = GlobalAddAtomW(L"ResizerPointer");
+    if ((msg == WM_WINDOWPOSCHANGING && (((LPWINDOWPOS)lParam)->flags & SWP_SHOWWINDOW)) || msg == WM_NCDESTROY)
+    {
+        int i;
 
-    // The minimum dialog size is the original size.
-    GetWindowRect(hwndDlg, &rc);
-    pResizer->sizeMinTrack.cx = RectWidth(&rc);
-    pResizer->sizeMinTrack.cy = RectHeight(&rc);
-    GetClientRect(hwndDlg, &rc);
-    pResizer->sizeMinClient.cx = RectWidth(&rc);
-    pResizer->sizeMinClient.cy = RectHeight(&rc);
-    pResizer->sizeCurClient.cx = RectWidth(&rc);
-    pResizer->sizeCurClient.cy = RectHeight(&rc);
-    pResizer->fEnabled = TRUE;
+        for (i = 0; i < pResizer->cControls; i++)
+        {
+            if (pResizer->phwndCtl[i] == hwndCtl && pResizer->pfStale[i])
+            {
+                if (msg == WM_WINDOWPOSCHANGING)
+                {
+                    LPWINDOWPOS pwp = (LPWINDOWPOS)lParam;
+                    uint32_t index = (uint32_t)i;
+                    LAYOUTRECT rc;
+
+                    // Catch up with the current dialog size (unless the caller knows better).
+                    LayoutComputeSet(&pResizer->layout, pResizer->sizeCurClient.cx - pResizer->sizeMinClient.cx,
+                        pResizer->sizeCurClient.cy - pResizer->sizeMinClient.cy, &index, 1, &rc);
+                    if (pwp->flags & SWP_NOMOVE)
+                    {
+                        pwp->x = rc.left;
+                        pwp->y = rc.top;
+                        pwp->flags &= ~SWP_NOMOVE;
+                    }
+                    if (pwp->flags & SWP_NOSIZE)
+                    {
+                        pwp->cx = rc.right - rc.left;
+                        pwp->cy = rc.bottom - rc.top;
+                        pwp->flags &= ~SWP_NOSIZE;
+                    }
+                }
 
-    // Subclass the dialog.
-    SETPROP_WNDPROC(hwndDlg, SubclassWindow(hwndDlg, ResizerWndProc));
-    SETPROP_RESIZER(hwndDlg, pResizer);
+                UndeferHiddenControl(pResizer, i);
+                if (msg == WM_NCDESTROY)
+                    pResizer->phwndCtl[i] = NULL;  /* going away; forget about it */
+                break;
+            }
+        }
+    }
 
-    // Happy? Really?!
-    return GETPROP_WNDPROC(hwndDlg) != NULL && GETPROP_RESIZER(hwndDlg) != NULL;
+    return DefSubclassProc(hwndCtl, msg, wParam, lParam);
 }
 
 /****************************************************************************
  *                                                                          *
- * Function: ResizerDlgProc                                                 *
+ * Function: FlushPendingLayout                                             *
  *                                                                          *
- * Purpose : Handle messages for modal resizable dialog.                    *
+ * Purpose : Stop coalescing; run any pending layout now.                   *
  *                                                                          *
  * History : Date      Reason                                               *
  *           09-02-22  Created                                              *
  *                                                                          *
  ****************************************************************************/
 
-static INT_PTR CALLBACK ResizerDlgProc(HWND hwndDlg, UINT msg, WPARAM wParam, LPARAM lParam)
+static void FlushPendingLayout(HWND hwndDlg, PRESIZER pResizer)
 {
-    if (msg == WM_INITDIALOG && g_pResizer != NULL)
+    if (pResizer->fTimer)
     {
-        // Install handler after processing WM_INIDIALOG;
-        // not optimal, but consistent with modeless dialogs.
-        INT_PTR result = (*g_pfnDialog)(hwndDlg, msg, wParam, lParam);
-        InstallResizableDialogHandler(hwndDlg, g_pResizer);
-        g_pResizer = NULL;
-        return result;
+        KillTimer(hwndDlg, GetCoalesceTimerId(pResizer));
+        pResizer->fTimer = FALSE;
+    }
+
+    if (pResizer->fPending)
+    {
+        pResizer->fPending = FALSE;
+        MoveDialogControls(hwndDlg, pResizer, pResizer->sizePending.cx, pResizer->sizePending.cy);
     }
-    return (*g_pfnDialog)(hwndDlg, msg, wParam, lParam);
 }
 
 /****************************************************************************
  *                                                                          *
- * Function: ResizerWndProc                                                 *
+ * Function: RescaleDialog                                                  *
  *                                                                          *
- * Purpose : Handle messages for subclassed resizable dialog.               *
+ * Purpose : Rescale base rectangles and sizes for a new DPI, in one go,    *
+ *           without asking the controls; then lay out once.                *
  *                                                                          *
  * History : Date      Reason                                               *
  *           09-02-22  Created                                              *
  *                                                                          *
  ****************************************************************************/
 
-static LRESULT CALLBACK ResizerWndProc(HWND hwndDlg, UINT msg, WPARAM wParam, LPARAM lParam)
+static void RescaleDialog(HWND hwndDlg, PRESIZER pResizer, UINT uDpi)
 {
-    switch (msg)
+    RECT rcWindow, rcClient;
+
+    GetWindowRect(hwndDlg, &rcWindow);
+    GetClientRect(hwndDlg, &rcClient);
+
+    if (uDpi != 0 && pResizer->uDpi != 0 && uDpi != pResizer->uDpi)
     {
-        HANDLE_MSG(hwndDlg, WM_GETMINMAXINFO, Resizer_OnGetMinMaxInfo);
-        HANDLE_MSG(hwndDlg, WM_NCHITTEST, Resizer_OnNCHitTest);
-        HANDLE_MSG(hwndDlg, WM_SIZING, Resizer_OnSizing);
-        HANDLE_MSG(hwndDlg, WM_SIZE, Resizer_OnSize);
-        HANDLE_MSG(hwndDlg, WM_ERASEBKGND, Resizer_OnEraseBkgnd);
-        HANDLE_MSG(hwndDlg, WM_DESTROY, Resizer_OnDestroy);
+        LayoutScale(&pResizer->layout, (int32_t)uDpi, (int32_t)pResizer->uDpi);
+        pResizer->sizeMinClient.cx = MulDiv(pResizer->sizeMinClient.cx, uDpi, pResizer->uDpi);
+        pResizer->sizeMinClient.cy = MulDiv(pResizer->sizeMinClient.cy, uDpi, pResizer->uDpi);
+
+        // Frame and caption don't scale linearly; measure them.
+        pResizer->sizeMinTrack.cx = pResizer->sizeMinClient.cx + RectWidth(&rcWindow) - RectWidth(&rcClient);
+        pResizer->sizeMinTrack.cy = pResizer->sizeMinClient.cy + RectHeight(&rcWindow) - RectHeight(&rcClient);
+
+        // Where the controls are now, more or less; make the next pass move all of them.
+        pResizer->sizeCurClient.cx = MulDiv(pResizer->sizeCurClient.cx, uDpi, pResizer->uDpi);
+        pResizer->sizeCurClient.cy = MulDiv(pResizer->sizeCurClient.cy, uDpi, pResizer->uDpi);
+        pResizer->fRelayout = TRUE;
+        pResizer->uDpi = uDpi;
+        pResizer->cxGripper = GetGripperSize(uDpi);
     }
 
-    // Send to the original procedure.
-    return CallWindowProc(GETPROP_WNDPROC(hwndDlg), hwndDlg, msg, wParam, lParam);
+    // One layout, for the size we ended up with.
+    pResizer->fPending = FALSE;
+    pResizer->fEnabled = TRUE;
+    MoveDialogControls(hwndDlg, pResizer, RectWidth(&rcClient), RectHeight(&rcClient));
 }
 
 /****************************************************************************
  *                                                                          *
- * Function: Resizer_OnGetMinMaxInfo                                        *
+ * Function: GetWindowDpi                                                   *
  *                                                                          *
- * Purpose : Handle WM_GETMINMAXINFO message.                               *
+ * Purpose : Return DPI for a window (or the system DPI, before Windows 10  *
+ *           version 1607).                                                 *
  *                                                                          *
  * History : Date      Reason                                               *
  *           09-02-22  Created                                              *
  *                                                                          *
  ****************************************************************************/
 
-static void Resizer_OnGetMinMaxInfo(HWND hwndDlg, PMINMAXINFO pmmi)
+static UINT GetWindowDpi(HWND hwnd)
 {
-    PRESIZER pResizer;
+    UINT (WINAPI *pfnGetDpiForWindow)(HWND);
+    UINT uDpi = 0;
+    HDC hdc;
 
-    pResizer = GETPROP_RESIZER(hwndDlg);
-    if (pResizer != NULL && pResizer->fEnabled)
+    // Not in older user32.dll.
+    pfnGetDpiForWindow = (UINT (WINAPI *)(HWND))GetProcAddress(GetModuleHandleW(L"user32.dll"), "GetDpiForWindow");
+    if (pfnGetDpiForWindow != NULL && (uDpi = pfnGetDpiForWindow(hwnd)) != 0)
+        return uDpi;
+
+    if ((hdc = GetDC(NULL)) != NULL)
     {
-        // Set the minimum tracking size.
-        pmmi->ptMinTrackSize.x = pResizer->sizeMinTrack.cx;
-        pmmi->ptMinTrackSize.y = pResizer->sizeMinTrack.cy;
+        uDpi = GetDeviceCaps(hdc, LOGPIXELSY);
+        ReleaseDC(NULL, hdc);
     }
+
+    return uDpi;
 }
 
 /****************************************************************************
  *                                                                          *
- * Function: Resizer_OnNCHitTest                                            *
+ * Function: GetGripperRect                                                 *
  *                                                                          *
- * Purpose : Handle WM_NCHITTEST message.                                   *
+ * Purpose : Get gripper rectangle, in client coords.                       *
  *                                                                          *
  * History : Date      Reason                                               *
  *           09-02-22  Created                                              *
  *                                                                          *
  ****************************************************************************/
 
-static UINT Resizer_OnNCHitTest(HWND hwndDlg, int x, int y)
+static void GetGripperRect(HWND hwndDlg, PCRESIZER pResizer, PRECT prc)
 {
-    int cx, cy;
-    RECT rc;
-
-    GetGripperRect(hwndDlg, &rc);
-    MapWindowRect(hwndDlg, NULL, &rc);
-    cx = x - rc.left;
-    cy = y - rc.top;
-    if (cx > 0 && cy > 0 && RectWidth(&rc) < cx + cy)
-        return HTBOTTOMRIGHT;
-
-    return (UINT)CallWindowProc(GETPROP_WNDPROC(hwndDlg), hwndDlg, WM_NCHITTEST, 0, MAKELPARAM(x,y));
+    GetClientRect(hwndDlg, prc);
+    prc->left = prc->right - pResizer->cxGripper;
+    prc->top = prc->bottom - pResizer->cxGripper;
 }
 
 /****************************************************************************
  *                                                                          *
- * Function: Resizer_OnSizing                                               *
+ * Function: GetGripperSize                                                 *
  *                                                                          *
- * Purpose : Handle WM_SIZING message.                                      *
+ * Purpose : Return gripper size (scroll bar width) for the given DPI, or   *
+ *           for the system DPI, before Windows 10 version 1607.            *
  *                                                                          *
  * History : Date      Reason                                               *
  *           09-02-22  Created                                              *
  *                                                                          *
  ****************************************************************************/
 
-static BOOL Resizer_OnSizing(HWND hwndDlg, UINT fSize, PRECT prc)
+static int GetGripperSize(UINT uDpi)
 {
-    BOOL fResult;
-    RECT rc;
-
-    fResult = (BOOL)CallWindowProc(GETPROP_WNDPROC(hwndDlg), hwndDlg, WM_SIZING, (WPARAM)fSize, (LPARAM)prc);
+    int (WINAPI *pfnGetSystemMetricsForDpi)(int, UINT);
 
-    GetGripperRect(hwndDlg, &rc);
-    InvalidateRect(hwndDlg, &rc, FALSE);
+    // Not in older user32.dll.
+    pfnGetSystemMetricsForDpi = (int (WINAPI *)(int, UINT))GetProcAddress(GetModuleHandleW(L"user32.dll"), "GetSystemMetricsForDpi");
+    if (pfnGetSystemMetricsForDpi != NULL && uDpi != 0)
+        return pfnGetSystemMetricsForDpi(SM_CXVSCROLL, uDpi);
 
-    return fResult;
+    return GetSystemMetrics(SM_CXVSCROLL);
 }
 
 /****************************************************************************
  *                                                                          *
- * Function: Resizer_OnSize                                                 *
+ * Function: GetBufferDC                                                    *
  *                                                                          *
- * Purpose : Handle WM_SIZE message.                                        *
+ * Purpose : Return off-screen surface at least as big as the client area,  *
+ *           or NULL.                                                       *
  *                                                                          *
  * History : Date      Reason                                               *
  *           09-02-22  Created                                              *
  *                                                                          *
  ****************************************************************************/
 
-static void Resizer_OnSize(HWND hwndDlg, UINT state, int cx, int cy)
+static HDC GetBufferDC(PRESIZER pResizer, HDC hdc, const RECT *prcClient)
 {
-    (void)CallWindowProc(GETPROP_WNDPROC(hwndDlg), hwndDlg, WM_SIZE, (WPARAM)state, MAKELPARAM(cx, cy));
+    int cx, cy;
 
-    if (state != SIZE_MINIMIZED)
+    // Still big enough?
+    if (pResizer->hdcBuffer != NULL && RectWidth(prcClient) <= pResizer->sizeBuffer.cx && RectHeight(prcClient) <= pResizer->sizeBuffer.cy)
+        return pResizer->hdcBuffer;
+
+    FreeBufferDC(pResizer);
+
+    // Round up to the next step.
+    cx = (max(RectWidth(prcClient), 1) + CX_BUFFERSTEP - 1) / CX_BUFFERSTEP * CX_BUFFERSTEP;
+    cy = (max(RectHeight(prcClient), 1) + CY_BUFFERSTEP - 1) / CY_BUFFERSTEP * CY_BUFFERSTEP;
+
+    if ((pResizer->hdcBuffer = CreateCompatibleDC(hdc)) == NULL)
+        return NULL;
+
+    if ((pResizer->hbmBuffer = CreateCompatibleBitmap(hdc, cx, cy)) == NULL)
     {
-        RECT rc;
+        DeleteDC(pResizer->hdcBuffer);
+        pResizer->hdcBuffer = NULL;
+        return NULL;
+    }
 
-        MoveDialogControls(hwndDlg, cx, cy);
+    pResizer->hbmOld = SelectBitmap(pResizer->hdcBuffer, pResizer->hbmBuffer);
+    pResizer->sizeBuffer.cx = cx;
+    pResizer->sizeBuffer.cy = cy;
 
-        GetGripperRect(hwndDlg, &rc);
-        InvalidateRect(hwndDlg, &rc, TRUE);
+    return pResizer->hdcBuffer;
+}
+
+static void FreeBufferDC(PRESIZER pResizer)
+{
+    if (pResizer->hdcBuffer != NULL)
+    {
+        SelectBitmap(pResizer->hdcBuffer, pResizer->hbmOld);
+        DeleteBitmap(pResizer->hbmBuffer);
+        DeleteDC(pResizer->hdcBuffer);
+        pResizer->hdcBuffer = NULL;
+        pResizer->hbmBuffer = NULL;
+        pResizer->sizeBuffer.cx = pResizer->sizeBuffer.cy = 0;
     }
 }
 
 /****************************************************************************
  *                                                                          *
- * Function: Resizer_OnEraseBkgnd                                           *
+ * Function: RestoreDialogGeometry                                          *
  *                                                                          *
- * Purpose : Handle WM_ERASEBKGND message.                                  *
+ * Purpose : Resize dialog to the size saved in the geometry store.         *
  *                                                                          *
  * History : Date      Reason                                               *
  *           09-02-22  Created                                              *
  *                                                                          *
  ****************************************************************************/
 
-static BOOL Resizer_OnEraseBkgnd(HWND hwndDlg, HDC hdc)
+static void RestoreDialogGeometry(HWND hwndDlg, PCRESIZER pResizer)
 {
-    BOOL fResult;
-    RECT rc;
+    PGEOMETRYSLOT pSlot;
 
-    fResult = (BOOL)CallWindowProc(GETPROP_WNDPROC(hwndDlg), hwndDlg, WM_ERASEBKGND, (WPARAM)hdc, 0);
+    // Nested dialogs are sized by their parent.
+    if (GetWindowStyle(hwndDlg) & WS_CHILD)
+        return;
 
-    GetGripperRect(hwndDlg, &rc);
-    DrawFrameControl(hdc, &rc, DFC_SCROLL, DFCS_SCROLLSIZEGRIP);
+    if ((pSlot = FindGeometrySlot(pResizer->ullKey, FALSE)) != NULL)
+    {
+        LONG cx = pSlot->cx, cy = pSlot->cy;
 
-    return fResult;
+        // Never below the template size; WM_SIZE does the layout.
+        if (cx > 0 && cx < 0x8000 && cy > 0 && cy < 0x8000 && (cx != pResizer->sizeMinTrack.cx || cy != pResizer->sizeMinTrack.cy))
+        {
+            SetWindowPos(hwndDlg, NULL, 0, 0, max(cx, pResizer->sizeMinTrack.cx), max(cy, pResizer->sizeMinTrack.cy),
+                SWP_NOMOVE|SWP_NOZORDER|SWP_NOACTIVATE);
+        }
+    }
 }
 
 /****************************************************************************
  *                                                                          *
- * Function: Resizer_OnDestroy                                              *
+ * Function: SaveDialogGeometry                                             *
  *                                                                          *
- * Purpose : Handle WM_DESTROY message.                                     *
+ * Purpose : Save dialog size in the geometry store.                        *
  *                                                                          *
  * History : Date      Reason                                               *
  *           09-02-22  Created                                              *
  *                                                                          *
  ****************************************************************************/
 
-static void Resizer_OnDestroy(HWND hwndDlg)
+static void SaveDialogGeometry(HWND hwndDlg, PCRESIZER pResizer)
 {
-    // Clean up.
-    PRESIZER pResizer = GETPROP_RESIZER(hwndDlg);
-    MyFree(pResizer->pControls);
-    MyFree(pResizer);
-    REMOVEPROP_RESIZER(hwndDlg);
-    pResizer = NULL;
+    WINDOWPLACEMENT wp;
+    PGEOMETRYSLOT pSlot;
 
-    CallWindowProc(GETPROP_WNDPROC(hwndDlg), hwndDlg, WM_DESTROY, 0, 0);
-    SubclassWindow(hwndDlg, GETPROP_WNDPROC(hwndDlg));
-    REMOVEPROP_WNDPROC(hwndDlg);
+    // Nested dialogs are sized by their parent.
+    if (GetWindowStyle(hwndDlg) & WS_CHILD)
+        return;
 
-    GlobalDeleteAtom(g_atPropWndProc);
-    GlobalDeleteAtom(g_atPropResizer);
+    // The restored size, even if the dialog is minimized or maximized.
+    wp.length = sizeof(wp);
+    if (GetWindowPlacement(hwndDlg, &wp) && (pSlot = FindGeometrySlot(pResizer->ullKey, TRUE)) != NULL)
+    {
+        // Other processes may be looking; the key goes last.
+        pSlot->ullKey = 0;
+        pSlot->cx = RectWidth(&wp.rcNormalPosition);
+        pSlot->cy = RectHeight(&wp.rcNormalPosition);
+        pSlot->ullKey = pResizer->ullKey;
+    }
 }
 
 /****************************************************************************
  *                                                                          *
- * Function: MoveDialogControls                                             *
+ * Function: FindGeometrySlot                                               *
  *                                                                          *
- * Purpose : Move dialog controls to new locations.                         *
+ * Purpose : Search the geometry store for a key. If fCreate is TRUE,       *
+ *           return a free slot (or one to reuse) when not found.           *
  *                                                                          *
  * History : Date      Reason                                               *
  *           09-02-22  Created                                              *
  *                                                                          *
  ****************************************************************************/
 
-static void MoveDialogControls(HWND hwndDlg, int cx, int cy)
+static PGEOMETRYSLOT FindGeometrySlot(ULONGLONG ullKey, BOOL fCreate)
 {
-    PRESIZER pResizer;
-
-    pResizer = GETPROP_RESIZER(hwndDlg);
-    if (pResizer != NULL && pResizer->fEnabled)
-    {
-        HDWP hdwp;
+    PGEOMETRYSTORE pStore = g_pGeometry;
+    UINT iFirst, i;
 
-        hdwp = BeginDeferWindowPos(pResizer->cControls);
-        if (hdwp != NULL)
-        {
-            int dx, dy;
-            int i;
-
-            // Make sure we don't go below the minimum dialog size.
-            cx = max(cx, pResizer->sizeMinClient.cx);
-            cy = max(cy, pResizer->sizeMinClient.cy);
+    if (pStore == NULL || ullKey == 0)
+        return NULL;
 
-            // Calculate deltas.
-            dx = cx - pResizer->sizeCurClient.cx;
-            dy = cy - pResizer->sizeCurClient.cy;
+    // Linear probing, within a small neighbourhood.
+    iFirst = (UINT)(ullKey % GEOMETRY_SLOTS);
+    for (i = 0; i < GEOMETRY_PROBES; i++)
+    {
+        PGEOMETRYSLOT pSlot = &pStore->aSlots[(iFirst + i) % GEOMETRY_SLOTS];
 
-            // Remember for next time.
-            pResizer->sizeCurClient.cx = cx;
-            pResizer->sizeCurClient.cy = cy;
+        if (pSlot->ullKey == ullKey)
+            return pSlot;
+        if (pSlot->ullKey == 0)
+            return (fCreate) ? pSlot : NULL;
+    }
 
-            // Move all controls.
-            for (i = 0; i < pResizer->cControls; i++)
-            {
-                PCRESIZERCTL pCtl = &pResizer->pControls[i];
-                HWND hwndCtl;
+    // Neighbourhood full; the first one has to go.
+    return (fCreate) ? &pStore->aSlots[iFirst] : NULL;
+}
 
-                hwndCtl = GetDlgItem(hwndDlg, pCtl->id);
-                if (hwndCtl != NULL)
-                {
-                    RECT rc;
+/****************************************************************************
+ *                                                                          *
+ * Function: TraceEvent                                                     *
+ *                                                                          *
+ * Purpose : Send an event to the trace callback, if any.                   *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           09-02-22  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
 
-                    // Get adjusted rectangle, then move or resize the dialog control window.
-                    GetAdjustedControlRect(&rc, hwndDlg, hwndCtl, pCtl, dx, dy);
-                    hdwp = DeferWindowPos(hdwp, hwndCtl, NULL, rc.left, rc.top, RectWidth(&rc), RectHeight(&rc), SWP_NOZORDER);
-                }
-            }
+static void TraceEvent(HWND hwndDlg, PCRESIZER pResizer, UINT uEvent, DWORD cControls, LONGLONG llTicks)
+{
+    RESIZERTRACEPROC pfnTrace = g_pfnTrace;
 
-            EndDeferWindowPos(hdwp);
-        }
+    if (pfnTrace != NULL)
+    {
+        RESIZERTRACE trace;
+
+        trace.cbSize = sizeof(trace);
+        trace.uEvent = uEvent;
+        trace.sizeClient = pResizer->sizeCurClient;
+        trace.cControls = cControls;
+        trace.dwTime = (DWORD)TicksToMicroseconds(llTicks);
+        (*pfnTrace)(hwndDlg, &trace, g_pvTrace);
     }
 }
 
 /****************************************************************************
  *                                                                          *
- * Function: GetAdjustedControlRect                                         *
+ * Function: TicksToMicroseconds                                            *
  *                                                                          *
- * Purpose : Get adjusted dialog control rectangle, in screen coordinates.  *
+ * Purpose : Convert performance counter ticks to microseconds.             *
  *                                                                          *
  * History : Date      Reason                                               *
  *           09-02-22  Created                                              *
  *                                                                          *
  ****************************************************************************/
 
-static void GetAdjustedControlRect(PRECT prc, HWND hwndDlg, HWND hwndCtl, PCRESIZERCTL pCtl, int dx, int dy)
+static ULONGLONG TicksToMicroseconds(ULONGLONG ullTicks)
 {
-    // Get the current window rectangle.
-    GetWindowRect(hwndCtl, prc);
-    MapWindowRect(NULL, hwndDlg, prc);
+    LARGE_INTEGER liFreq;
+    ULONGLONG ullFreq;
+
+    if (!QueryPerformanceFrequency(&liFreq) || liFreq.QuadPart <= 0)
+        return 0;
 
-    // Apply previously calculated deltas.
-    if (pCtl->fuAlign & RESIZER_LEFT) prc->left += dx;
-    if (pCtl->fuAlign & RESIZER_RIGHT) prc->right += dx;
-    if (pCtl->fuAlign & RESIZER_TOP) prc->top += dy;
-    if (pCtl->fuAlign & RESIZER_BOTTOM) prc->bottom += dy;
+    // Whole seconds first, so a long running process can't overflow.
+    ullFreq = (ULONGLONG)liFreq.QuadPart;
+    return ullTicks / ullFreq * 1000000 + ullTicks % ullFreq * 1000000 / ullFreq;
 }
 
 /****************************************************************************
  *                                                                          *
- * Function: GetGripperRect                                                 *
+ * Function: MyAlloc                                                        *
  *                                                                          *
- * Purpose : Get gripper rectangle, in client coords.                       *
+ * Purpose : Allocate memory, and keep track of it.                         *
  *                                                                          *
  * History : Date      Reason                                               *
  *           09-02-22  Created                                              *
  *                                                                          *
  ****************************************************************************/
 
-static void GetGripperRect(HWND hwndDlg, PRECT prc)
+static PVOID MyAlloc(SIZE_T cb)
 {
-    GetClientRect(hwndDlg, prc);
-    prc->left = prc->right - GetSystemMetrics(SM_CXVSCROLL);
-    prc->top = prc->bottom - GetSystemMetrics(SM_CXVSCROLL);
+    PVOID pv;
+
+    if ((pv = HeapAlloc(GetProcessHeap(), 0, cb)) != NULL)
+    {
+        LONG cbCurrent, cbPeak;
+
+        InterlockedIncrement(&g_cAllocs);
+        cbCurrent = InterlockedExchangeAdd(&g_cbCurrent, (LONG)cb) + (LONG)cb;
+
+        // New high-water mark?
+        while ((cbPeak = g_cbPeak) < cbCurrent && InterlockedCompareExchange(&g_cbPeak, cbCurrent, cbPeak) != cbPeak)
+            ;
+    }
+
+    return pv;
+}
+
+static void MyFree(PVOID pv)
+{
+    if (pv)
+    {
+        InterlockedIncrement(&g_cFrees);
+        InterlockedExchangeAdd(&g_cbCurrent, -(LONG)HeapSize(GetProcessHeap(), 0, pv));
+        HeapFree(GetProcessHeap(), 0, pv);
+    }
 }
@@ -17,6 +17,52 @@
 #else /* !_WIN64 */
 #pragma comment(lib, "resizer.lib")
 #endif /* !_WIN64 */
+#pragma comment(lib, "comctl32.lib")  /* SetWindowSubclass() */
+
+/* Options for SetResizableDialogOptions() */
+#define RDO_COALESCE      0x00000001  /* At most one layout per timer tick during live resize */
+#define RDO_DOUBLEBUFFER  0x00000002  /* Erase background off-screen; keep valid bits on resize */
+
+/* Statistics for GetResizableDialogStats(); times in microseconds */
+typedef struct RESIZERSTATS {
+    DWORD cbSize;           /* sizeof(RESIZERSTATS), or RESIZERSTATS_V1_SIZE */
+    DWORD cLayoutPasses;    /* Number of layout passes */
+    DWORD cSkippedPasses;   /* Number of size changes folded into a later pass */
+    DWORD cControlsMoved;   /* Number of controls moved, in all layout passes */
+    DWORD cControlsDeferred;  /* Number of hidden controls left until shown */
+    DWORD cEraseBkgnd;      /* Number of WM_ERASEBKGND messages */
+    DWORD cbTemplateCopied; /* Number of template bytes copied, when creating the dialog */
+    ULONGLONG ullLayoutTime;  /* Time spent laying out controls */
+    ULONGLONG ullEraseTime; /* Time spent in WM_ERASEBKGND */
+    ULONGLONG ullMaxEraseTime;  /* Longest WM_ERASEBKGND (one frame) */
+} RESIZERSTATS, *PRESIZERSTATS;
+
+#define RESIZERSTATS_V1_SIZE  (3 * sizeof(DWORD))
+
+/* Events for the trace callback */
+#define RTE_LAYOUT     1    /* Layout pass */
+#define RTE_ERASEBKGND 2    /* WM_ERASEBKGND */
+
+/* Trace record for RESIZERTRACEPROC */
+typedef struct RESIZERTRACE {
+    DWORD cbSize;           /* sizeof(RESIZERTRACE) */
+    UINT uEvent;            /* Event (RTE_*) */
+    SIZE sizeClient;        /* Client area size */
+    DWORD cControls;        /* Number of controls moved (RTE_LAYOUT) */
+    DWORD dwTime;           /* Time spent, in microseconds */
+} RESIZERTRACE, *PRESIZERTRACE;
+typedef const struct RESIZERTRACE *PCRESIZERTRACE;
+
+typedef void (CALLBACK *RESIZERTRACEPROC)(HWND, PCRESIZERTRACE, PVOID);
+
+/* Statistics for GetResizerHeapStats() */
+typedef struct RESIZERHEAPSTATS {
+    DWORD cbSize;           /* sizeof(RESIZERHEAPSTATS) */
+    DWORD cAllocs;          /* Number of allocations */
+    DWORD cFrees;           /* Number of frees */
+    DWORD cbCurrent;        /* Bytes currently allocated */
+    DWORD cbPeak;           /* Peak bytes allocated */
+} RESIZERHEAPSTATS, *PRESIZERHEAPSTATS;
 
 /****** Function prototypes ************************************************/
 
@@ -29,6 +75,12 @@ INT_PTR WINAPI ResizableDialogBoxParamW(HINSTANCE, PCWSTR, HWND, DLGPROC, LPARAM
 INT_PTR WINAPI ResizableDialogBoxIndirectParamA(HINSTANCE, LPCDLGTEMPLATEA, HWND, DLGPROC, LPARAM);     /* Like DialogBoxIndirectParamA() */
 INT_PTR WINAPI ResizableDialogBoxIndirectParamW(HINSTANCE, LPCDLGTEMPLATEW, HWND, DLGPROC, LPARAM);     /* Like DialogBoxIndirectParamW() */
 BOOL WINAPI AdjustResizableDialog(HWND, int /*delta x*/, int /*delta y*/);                              /* Resize dialog without moving controls */
+void WINAPI FlushResizableDialogCache(HINSTANCE);                                                       /* Forget compiled templates (NULL = all modules) */
+BOOL WINAPI SetResizableDialogOptions(HWND, DWORD);                                                     /* Set RDO_* options */
+BOOL WINAPI GetResizableDialogStats(HWND, PRESIZERSTATS);                                               /* Get layout statistics (NULL = whole process) */
+void WINAPI SetResizerTraceProc(RESIZERTRACEPROC, PVOID);                                               /* Set trace callback (NULL = none) */
+BOOL WINAPI SetResizableDialogGeometryStore(PCWSTR);                                                    /* Remember dialog sizes in this file (NULL = off) */
+BOOL WINAPI GetResizerHeapStats(PRESIZERHEAPSTATS);                                                     /* Get heap statistics (debugging aid) */
 
 #define CreateResizableDialogA(hInst,pName,hwndParent,pfnDialog)  CreateResizableDialogParamA(hInst,pName,hwndParent,pfnDialog,0L)
 #define CreateResizableDialogW(hInst,pName,hwndParent,pfnDialog)  CreateResizableDialogParamW(hInst,pName,hwndParent,pfnDialog,0L)
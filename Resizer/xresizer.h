@@ -13,42 +13,88 @@
 #define _XRESIZER_H
 
 #include "resizer.h"
+#include "dlgtmpl.h"
+#include "layout.h"
+#include "modal.h"
 
-// fuAlign flags.
-#define RESIZER_NONE    0x0000
-#define RESIZER_LEFT    0x0001
-#define RESIZER_RIGHT   0x0002
-#define RESIZER_TOP     0x0004
-#define RESIZER_BOTTOM  0x0008
-#define RESIZER_HORZ    (RESIZER_LEFT|RESIZER_RIGHT)
-#define RESIZER_VERT    (RESIZER_TOP|RESIZER_BOTTOM)
-
-typedef struct RESIZERCTL {
-    int id;                 // Control id.
-    BYTE fuAlign;           // Alignment flags (RESIZER_*).
-} RESIZERCTL, *PRESIZERCTL;
-typedef const struct RESIZERCTL *PCRESIZERCTL;
+// Control info, as produced by the template compiler.
+typedef DLGANCHOR RESIZERCTL, *PRESIZERCTL;
+typedef PCDLGANCHOR PCRESIZERCTL;
 
-typedef struct RESIZER {
+// Compiled dialog template, shared by all instances of a dialog.
+typedef struct RESIZERTEMPLATE {
+    struct RESIZERTEMPLATE *pNext;  // Next template in cache.
+    HINSTANCE hInst;        // Module handle.
+    LPCVOID pvSource;       // Source template.
+    LPCVOID pvName;         // Resource name or ordinal (NULL for in-memory template).
+    BOOL fAnsiName;         // Resource name is ANSI.
+    LONG volatile cRefs;    // References from the cache, and from dialogs.
+    LPDLGTEMPLATE pDlg;     // Compiled template (NULL if not resizable).
     RESIZERCTL *pControls;  // Pointer to array with control info.
     int cControls;          // Number of controls.
+    LONG volatile cbUncharged;  // Bytes copied by the compiler, not yet charged to a dialog.
+    ULONGLONG ullKey;       // Template identity (hash of module, name and source template; never zero).
+} RESIZERTEMPLATE, *PRESIZERTEMPLATE;
+
+typedef struct RESIZER {
+    RESIZERCTL *pControls;  // Pointer to array with control info (same block).
+    int cControls;          // Number of controls.
     SIZE sizeCurClient;     // Current client area size.
     SIZE sizeMinClient;     // Minimum client area size.
     SIZE sizeMinTrack;      // Minimum window size.
+    LAYOUT layout;          // Base rectangles and anchors, for each control.
+    HWND *phwndCtl;         // Control windows (NULL if not found).
+    LAYOUTRECT *prcCtl;     // Computed control rectangles.
+    BOOLEAN *pfStale;       // Control is hidden, and not moved yet (subclassed).
+    BOOLEAN *pfNested;      // Control is a nested resizable dialog (at last capture).
+    BOOL fRebase;           // Recapture base rectangles before next layout.
+    BOOL fRelayout;         // Move all anchored controls in the next layout.
+    DWORD fOptions;         // Options (RDO_*).
+    BOOL fInSizeMove;       // Inside the modal size/move loop.
+    BOOL fPending;          // Layout pending, for sizePending.
+    SIZE sizePending;       // Client area size for pending layout.
+    BOOL fTimer;            // Coalescing timer is running.
+    BOOL fParentLayout;     // Nested in a resizable dialog, which will lay us out.
+    HWND hwndDlg;           // Dialog window.
+    struct RESIZER *pParent;    // Resizable parent dialog, for WS_CHILD dialogs (or NULL).
+    struct RESIZER *pChildren;  // Resizable child dialogs (tab pages and such), anchored or not.
+    struct RESIZER *pNextChild; // Next child dialog of pParent.
+    UINT uDpi;              // DPI the base rectangles and sizes are for.
+    int cxGripper;          // Gripper size, at uDpi (until WM_SETTINGCHANGE).
+    HDC hdcBuffer;          // Off-screen surface for RDO_DOUBLEBUFFER (or NULL).
+    HBITMAP hbmBuffer;      // Bitmap selected into hdcBuffer.
+    HBITMAP hbmOld;         // Original bitmap in hdcBuffer.
+    SIZE sizeBuffer;        // Size of hbmBuffer.
+    RESIZERSTATS stats;     // Statistics (times in performance counter ticks).
+    ULONGLONG ullKey;       // Template identity, for the geometry store.
     BOOL fEnabled;
 } RESIZER, *PRESIZER;
 typedef const struct RESIZER *PCRESIZER;
 
-#define EXTRA_MAGIC    0xC0DE
-#define EXTRA_VERSION  1
-
-#include <pshpack2.h>
-typedef struct EXTRADATA {
-    WORD magic;             // Magic number (EXTRA_MAGIC).
-    WORD version;           // Version (EXTRA_VERSION).
-    WORD fuAlign;           // Alignment flags.
-} EXTRADATA, *PEXTRADATA;
-typedef const struct EXTRADATA *PCEXTRADATA;
-#include <poppack.h>
+#define GEOMETRY_MAGIC   0x4F454752  /* "RGEO" */
+#define GEOMETRY_SLOTS   256
+#define GEOMETRY_PROBES  8
+
+// Saved dialog size, in the geometry store.
+typedef struct GEOMETRYSLOT {
+    ULONGLONG ullKey;       // Template identity (zero = free).
+    LONG cx;                // Window width.
+    LONG cy;                // Window height.
+} GEOMETRYSLOT, *PGEOMETRYSLOT;
+
+// Geometry store; a small hash table, in a memory-mapped file.
+typedef struct GEOMETRYSTORE {
+    DWORD magic;            // Magic number (GEOMETRY_MAGIC).
+    DWORD cSlots;           // Number of slots (GEOMETRY_SLOTS).
+    GEOMETRYSLOT aSlots[GEOMETRY_SLOTS];  // Slots, indexed by key.
+} GEOMETRYSTORE, *PGEOMETRYSTORE;
+
+// Modal dialog in the making; lives on the stack of ResizableDialogBoxWorker().
+typedef struct MODALCONTEXT {
+    MODALLINK link;         // Pending context, on this thread (first member).
+    PRESIZER pResizer;      // Resizer info (NULL once installed).
+    PRESIZERTEMPLATE pTemplate;  // Compiled template (NULL once the dialog exists).
+    DLGPROC pfnDialog;      // Original dialog procedure.
+} MODALCONTEXT, *PMODALCONTEXT;
 
 #endif /* _XRESIZER_H */
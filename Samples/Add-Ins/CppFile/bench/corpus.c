@@ -0,0 +1,221 @@
+﻿/****************************************************************************
+ *                                                                          *
+ * File    : corpus.c                                                       *
+ *                                                                          *
+ * Purpose : Benchmark corpus reader.                                       *
+ *                                                                          *
+ *           Reads UTF-8 files into UTF-16 lines, like the IDE gives them   *
+ *           to a parser: one line at a time, ending with '\n'.             *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "corpus.h"
+
+// Static function prototypes.
+static int AddText(CORPUS *, const unsigned char *, size_t);
+static int AddChar(CORPUS *, WCHAR);
+static int AddLine(CORPUS *);
+
+/****************************************************************************
+ *                                                                          *
+ * Function: CorpusAddFile                                                  *
+ *                                                                          *
+ * Purpose : Add the lines of a file to the corpus.                         *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+int CorpusAddFile(CORPUS *pCorpus, const char *pszName)
+{
+    unsigned char *pb = NULL;
+    size_t cb = 0, cbMax = 0, cbRead;
+    FILE *pf;
+    int fOK;
+
+    if ((pf = fopen(pszName, "rb")) == NULL)
+    {
+        fprintf(stderr, "corpus: can't open '%s'\n", pszName);
+        return 0;
+    }
+
+    do
+    {
+        if (cb == cbMax)
+        {
+            unsigned char *pbNew = realloc(pb, cbMax = cbMax ? cbMax * 2 : 65536);
+            if (pbNew == NULL)
+            {
+                fclose(pf);
+                free(pb);
+                fprintf(stderr, "corpus: out of memory\n");
+                return 0;
+            }
+            pb = pbNew;
+        }
+        cbRead = fread(pb + cb, 1, cbMax - cb, pf);
+        cb += cbRead;
+    } while (cbRead != 0);
+    fclose(pf);
+
+    // Remember the name, for -verify.
+    if (pCorpus->cFiles == pCorpus->cFilesMax)
+    {
+        size_t cFilesMax = pCorpus->cFilesMax ? pCorpus->cFilesMax * 2 : 256;
+        char **ppszFiles = realloc(pCorpus->ppszFiles, cFilesMax * sizeof(char *));
+        if (ppszFiles != NULL)
+            pCorpus->ppszFiles = ppszFiles, pCorpus->cFilesMax = cFilesMax;
+    }
+
+    fOK = pCorpus->cFiles < pCorpus->cFilesMax &&
+        (pCorpus->ppszFiles[pCorpus->cFiles] = malloc(strlen(pszName) + 1)) != NULL;
+    if (fOK)
+    {
+        strcpy(pCorpus->ppszFiles[pCorpus->cFiles++], pszName);
+        fOK = AddText(pCorpus, pb, cb);
+    }
+    free(pb);
+
+    if (!fOK)
+    {
+        fprintf(stderr, "corpus: out of memory\n");
+        return 0;
+    }
+
+    return 1;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: AddText                                                        *
+ *                                                                          *
+ * Purpose : Decode UTF-8 text into lines, ending with '\n' (like the IDE). *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int AddText(CORPUS *pCorpus, const unsigned char *pb, size_t cb)
+{
+    const unsigned char *pbEnd = pb + cb;
+    size_t cwchStart = pCorpus->cwch;
+
+    // Skip byte-order mark.
+    if (cb >= 3 && pb[0] == 0xEF && pb[1] == 0xBB && pb[2] == 0xBF)
+        pb += 3;
+
+    while (pb < pbEnd)
+    {
+        uint32_t ch = *pb++;
+        int cbMore = 0;
+
+        if (ch >= 0xF0 && ch < 0xF8) ch &= 0x07, cbMore = 3;
+        else if (ch >= 0xE0) ch &= 0x0F, cbMore = 2;
+        else if (ch >= 0xC0) ch &= 0x1F, cbMore = 1;
+        else if (ch >= 0x80) ch = 0xFFFD;  /* stray continuation byte */
+
+        for (; cbMore > 0 && pb < pbEnd && (*pb & 0xC0) == 0x80; cbMore--)
+            ch = (ch << 6) | (*pb++ & 0x3F);
+        if (cbMore != 0 || ch > 0x10FFFF)
+            ch = 0xFFFD;
+
+        if (ch == '\r' && pb < pbEnd && *pb == '\n')
+            continue;
+
+        if (ch >= 0x10000)
+        {
+            if (!AddChar(pCorpus, (WCHAR)(0xD800 + ((ch - 0x10000) >> 10))) ||
+                !AddChar(pCorpus, (WCHAR)(0xDC00 + (ch & 0x3FF))))
+                return 0;
+        }
+        else if (!AddChar(pCorpus, (WCHAR)ch))
+            return 0;
+
+        if (ch == '\n' && !AddLine(pCorpus))
+            return 0;
+    }
+
+    // Last line, without '\n'.
+    if (pCorpus->cwch != cwchStart && pCorpus->pwch[pCorpus->cwch - 1] != '\n')
+        return AddLine(pCorpus);
+
+    return 1;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: AddChar, AddLine                                               *
+ *                                                                          *
+ * Purpose : Append a character, or end the current line.                   *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int AddChar(CORPUS *pCorpus, WCHAR ch)
+{
+    if (pCorpus->cwch == pCorpus->cwchMax)
+    {
+        size_t cwchMax = pCorpus->cwchMax ? pCorpus->cwchMax * 2 : 1 << 20;
+        WCHAR *pwch = realloc(pCorpus->pwch, cwchMax * sizeof(WCHAR));
+        if (pwch == NULL)
+            return 0;
+        pCorpus->pwch = pwch;
+        pCorpus->cwchMax = cwchMax;
+    }
+    pCorpus->pwch[pCorpus->cwch++] = ch;
+    return 1;
+}
+
+static int AddLine(CORPUS *pCorpus)
+{
+    size_t iStart;
+
+    // piLine[] has one more element than there are lines.
+    if (pCorpus->cLines + 1 >= pCorpus->cLinesMax)
+    {
+        size_t cLinesMax = pCorpus->cLinesMax ? pCorpus->cLinesMax * 2 : 65536;
+        size_t *piLine = realloc(pCorpus->piLine, cLinesMax * sizeof(size_t));
+        size_t *piFile = realloc(pCorpus->piFile, cLinesMax * sizeof(size_t));
+        if (piLine != NULL) pCorpus->piLine = piLine;
+        if (piFile != NULL) pCorpus->piFile = piFile;
+        if (piLine == NULL || piFile == NULL)
+            return 0;
+        if (pCorpus->cLinesMax == 0)
+            pCorpus->piLine[0] = 0;
+        pCorpus->cLinesMax = cLinesMax;
+    }
+
+    iStart = pCorpus->piLine[pCorpus->cLines];
+    if (pCorpus->cwch - iStart > pCorpus->cchLongest)
+        pCorpus->cchLongest = pCorpus->cwch - iStart;
+
+    pCorpus->piFile[pCorpus->cLines] = pCorpus->cFiles - 1;
+    pCorpus->piLine[++pCorpus->cLines] = pCorpus->cwch;
+    return 1;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: CorpusIsFirstLine                                              *
+ *                                                                          *
+ * Purpose : Is this the first line of a file (starting with cookie 0)?     *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+int CorpusIsFirstLine(const CORPUS *pCorpus, size_t iLine)
+{
+    return iLine == 0 || pCorpus->piFile[iLine] != pCorpus->piFile[iLine - 1];
+}
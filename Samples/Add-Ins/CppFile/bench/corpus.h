@@ -0,0 +1,35 @@
+﻿/****************************************************************************
+ *                                                                          *
+ * File    : corpus.h                                                       *
+ *                                                                          *
+ * Purpose : Definitions for the benchmark corpus reader.                   *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+#ifndef _CORPUS_H
+#define _CORPUS_H
+
+#include <stddef.h>
+#include "../cpplex.h"
+
+// Corpus: all lines of all files, as UTF-16.
+typedef struct CORPUS {
+    WCHAR *pwch;            // Text of all lines (with '\n').
+    size_t cwch, cwchMax;   // Characters used and allocated.
+    size_t *piLine;         // Start of each line, and end of the last.
+    size_t cLines, cLinesMax;  // Lines used and allocated.
+    size_t *piFile;         // File of each line.
+    size_t cchLongest;      // Longest line.
+    char **ppszFiles;       // File names.
+    size_t cFiles, cFilesMax;  // Files used and allocated.
+} CORPUS;
+
+/****** Function prototypes ************************************************/
+
+int CorpusAddFile(CORPUS * /*pCorpus*/, const char * /*pszName*/);
+int CorpusIsFirstLine(const CORPUS * /*pCorpus*/, size_t /*iLine*/);
+
+#endif /* _CORPUS_H */
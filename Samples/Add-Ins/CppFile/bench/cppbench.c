@@ -0,0 +1,549 @@
+﻿/****************************************************************************
+ *                                                                          *
+ * File    : cppbench.c                                                     *
+ *                                                                          *
+ * Purpose : C++ syntax color lexer benchmark.                              *
+ *                                                                          *
+ *           Reads a corpus of C++ files (UTF-8), and runs every line       *
+ *           through the lexer, the same way the IDE does: one call per     *
+ *           line, with the cookie from the previous line. Prints lines per *
+ *           second for the lexer and for the original parser (cppref.c),   *
+ *           and a checksum of all parse points. With -verify, every line   *
+ *           is compared, and the first difference is reported. Lines with  *
+ *           keywords the original parser misses are expected to differ,    *
+ *           and are left out. Also times the keyword lookup                *
+ *           alone (binary search vs hash), for every identifier.           *
+ *                                                                          *
+ *           Only uses the C11 standard library; builds on any host:        *
+ *           cc -O2 cppbench.c corpus.c cppref.c ../cpplex.c -o cppbench    *
+ *           find /usr/include/c++ -type f | ./cppbench -verify -           *
+ *           (add -DCPPLEX_NO_SIMD to measure the lexer without SSE2).      *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <locale.h>
+#include <time.h>
+#include "../cpplex.h"
+#include "../cpptab.h"
+#include "corpus.h"
+
+// Default number of passes over the corpus.
+#define C_PASSES  5
+
+// Identifiers in the corpus.
+typedef struct IDENTS {
+    size_t *piIdent;        // Start of each identifier.
+    unsigned char *pcch;    // Length of each identifier (at most 255).
+    size_t cIdents;         // Number of identifiers.
+} IDENTS;
+
+// Parser, as given to the IDE, and keyword lookup.
+typedef USHORT (CALLBACK *PARSEPROC)(USHORT, PCWSTR, int, ADDIN_PARSE_POINT [], PINT);
+typedef size_t (*KEYWORDPROC)(PCWSTR, size_t);
+
+// The original parser (cppref.c).
+USHORT RefParseLine(USHORT, PCWSTR, int, ADDIN_PARSE_POINT [], PINT);
+
+// Keywords the original parser misses: new in C++20, or out of order in its
+// list (so its binary search doesn't always find them).
+static const char *apszMissedKeywords[] = {
+    "char8_t",
+    "co_await",
+    "co_return",
+    "co_yield",
+    "const_cast",
+    "consteval",
+    "constinit",
+};
+
+// Static function prototypes.
+static void Usage(void);
+static int Verify(const CORPUS *, const unsigned char *);
+static unsigned char *FindMissedKeywordLines(const CORPUS *);
+static double Measure(const CORPUS *, const unsigned char *, PARSEPROC, int, uint64_t *);
+static int FindIdents(const CORPUS *, IDENTS *);
+static double MeasureKeywords(const CORPUS *, const IDENTS *, KEYWORDPROC, int, size_t *);
+static size_t SearchIsKeyword(PCWSTR, size_t);
+static int Compare(const char *, PCWSTR, size_t);
+static uint64_t HashLine(uint64_t, USHORT, const ADDIN_PARSE_POINT *, int);
+static double Now(void);
+
+/****************************************************************************
+ *                                                                          *
+ * Function: main                                                           *
+ *                                                                          *
+ * Purpose : Main entry point.                                              *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+int main(int argc, char *argv[])
+{
+    CORPUS corpus = {0};
+    IDENTS idents = {0};
+    unsigned char *pfMissed;
+    size_t cKeywordsRef, cKeywordsLex;
+    int cPasses = C_PASSES;
+    int fVerify = 0;
+    uint64_t hashRef, hashLex;
+    double tRef, tLex;
+    int i;
+
+    // Non-ASCII letters and digits, as far as the C library knows them.
+    setlocale(LC_CTYPE, "");
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-verify") == 0)
+            fVerify = 1;
+        else if (strcmp(argv[i], "-passes") == 0 && i + 1 < argc)
+            cPasses = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-") == 0)
+        {
+            char szName[4096];
+
+            // File names from standard input, one on each line.
+            while (fgets(szName, sizeof(szName), stdin) != NULL)
+            {
+                szName[strcspn(szName, "\r\n")] = '\0';
+                if (szName[0] != '\0' && !CorpusAddFile(&corpus, szName))
+                    return 1;
+            }
+        }
+        else if (argv[i][0] == '-')
+        {
+            Usage();
+            return 1;
+        }
+        else if (!CorpusAddFile(&corpus, argv[i]))
+            return 1;
+    }
+
+    if (corpus.cLines == 0 || cPasses <= 0)
+    {
+        Usage();
+        return 1;
+    }
+
+    printf("%zu files, %zu lines, %zu characters\n", corpus.cFiles, corpus.cLines, corpus.cwch);
+
+    if ((pfMissed = FindMissedKeywordLines(&corpus)) == NULL)
+    {
+        fprintf(stderr, "cppbench: out of memory\n");
+        return 1;
+    }
+
+    if (fVerify && !Verify(&corpus, pfMissed))
+        return 1;
+
+    // Warm up, then measure.
+    (void)Measure(&corpus, pfMissed, RefParseLine, 1, &hashRef);
+    (void)Measure(&corpus, pfMissed, CppParseLine, 1, &hashLex);
+    tRef = Measure(&corpus, pfMissed, RefParseLine, cPasses, &hashRef);
+    tLex = Measure(&corpus, pfMissed, CppParseLine, cPasses, &hashLex);
+
+    printf("\nparser        lines/s      ns/line  checksum\n");
+    printf("original %12.0f %12.1f  %016llx\n", corpus.cLines / tRef, tRef * 1e9 / corpus.cLines, (unsigned long long)hashRef);
+    printf("lexer    %12.0f %12.1f  %016llx\n", corpus.cLines / tLex, tLex * 1e9 / corpus.cLines, (unsigned long long)hashLex);
+    printf("\nspeedup  %.2fx\n", tRef / tLex);
+
+    if (hashRef != hashLex)
+    {
+        fprintf(stderr, "cppbench: checksums differ; run with -verify\n");
+        return 1;
+    }
+
+    // Keyword lookup alone.
+    if (!FindIdents(&corpus, &idents))
+    {
+        fprintf(stderr, "cppbench: out of memory\n");
+        return 1;
+    }
+
+    (void)MeasureKeywords(&corpus, &idents, SearchIsKeyword, 1, &cKeywordsRef);
+    (void)MeasureKeywords(&corpus, &idents, CppIsKeyword, 1, &cKeywordsLex);
+    tRef = MeasureKeywords(&corpus, &idents, SearchIsKeyword, cPasses, &cKeywordsRef);
+    tLex = MeasureKeywords(&corpus, &idents, CppIsKeyword, cPasses, &cKeywordsLex);
+
+    printf("\n%zu identifiers\n", idents.cIdents);
+    printf("\nkeywords      ident/s     ns/ident  keywords\n");
+    printf("search   %12.0f %12.2f  %zu\n", idents.cIdents / tRef, tRef * 1e9 / idents.cIdents, cKeywordsRef);
+    printf("hash     %12.0f %12.2f  %zu\n", idents.cIdents / tLex, tLex * 1e9 / idents.cIdents, cKeywordsLex);
+    printf("\nspeedup  %.2fx\n", tRef / tLex);
+
+    if (cKeywordsRef != cKeywordsLex)
+    {
+        fprintf(stderr, "cppbench: keyword counts differ\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Usage                                                          *
+ *                                                                          *
+ * Purpose : Display usage.                                                 *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static void Usage(void)
+{
+    fprintf(stderr, "Usage: cppbench [-verify] [-passes n] { file | - } ...\n"
+                    "       - reads file names from standard input\n");
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Verify                                                         *
+ *                                                                          *
+ * Purpose : Compare the lexer with the original parser, line by line;      *
+ *           lines with missed keywords (pfMissed) may differ in colors.    *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int Verify(const CORPUS *pCorpus, const unsigned char *pfMissed)
+{
+    ADDIN_PARSE_POINT *pPointsRef, *pPointsLex;
+    USHORT usCookie = 0, usCookieLex;
+    size_t iLine, iFileLine = 0;
+    size_t cMissed = 0;
+
+    pPointsRef = malloc((pCorpus->cchLongest + 1) * sizeof(ADDIN_PARSE_POINT));
+    pPointsLex = malloc((pCorpus->cchLongest + 1) * sizeof(ADDIN_PARSE_POINT));
+    if (pPointsRef == NULL || pPointsLex == NULL)
+    {
+        fprintf(stderr, "cppbench: out of memory\n");
+        return 0;
+    }
+
+    for (iLine = 0; iLine < pCorpus->cLines; iLine++)
+    {
+        PCWSTR pchText = &pCorpus->pwch[pCorpus->piLine[iLine]];
+        int cchText = (int)(pCorpus->piLine[iLine + 1] - pCorpus->piLine[iLine]);
+        int cPointsRef = 0, cPointsLex = 0;
+
+        if (CorpusIsFirstLine(pCorpus, iLine))
+            usCookie = 0, iFileLine = 0;
+        iFileLine++;
+
+        usCookieLex = CppParseLine(usCookie, pchText, cchText, pPointsLex, &cPointsLex);
+        usCookie = RefParseLine(usCookie, pchText, cchText, pPointsRef, &cPointsRef);
+
+        if (usCookie != usCookieLex || cPointsRef != cPointsLex ||
+            memcmp(pPointsRef, pPointsLex, cPointsRef * sizeof(ADDIN_PARSE_POINT)) != 0)
+        {
+            if (pfMissed[iLine] && usCookie == usCookieLex)
+            {
+                cMissed++;
+                continue;
+            }
+
+            fprintf(stderr, "cppbench: difference in %s, line %zu\n", pCorpus->ppszFiles[pCorpus->piFile[iLine]], iFileLine);
+            free(pPointsRef);
+            free(pPointsLex);
+            return 0;
+        }
+    }
+
+    printf("verified: identical output for all lines, except %zu with missed keywords\n", cMissed);
+    free(pPointsRef);
+    free(pPointsLex);
+    return 1;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: FindMissedKeywordLines                                         *
+ *                                                                          *
+ * Purpose : Return a flag for each line; set if it has a missed keyword.   *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static unsigned char *FindMissedKeywordLines(const CORPUS *pCorpus)
+{
+    unsigned char *pfMissed;
+    size_t iLine;
+
+    if ((pfMissed = calloc(pCorpus->cLines + 1, 1)) == NULL)
+        return NULL;
+
+    for (iLine = 0; iLine < pCorpus->cLines; iLine++)
+    {
+        size_t i = pCorpus->piLine[iLine], iEnd = pCorpus->piLine[iLine + 1];
+
+        while (i < iEnd && !pfMissed[iLine])
+        {
+            size_t iStart = i, k;
+
+            while (i < iEnd && (pCorpus->pwch[i] == L'_' || IsCharAlphaNumericW(pCorpus->pwch[i])))
+                i++;
+
+            for (k = 0; k < sizeof(apszMissedKeywords) / sizeof(apszMissedKeywords[0]) && i != iStart; k++)
+            {
+                if (Compare(apszMissedKeywords[k], &pCorpus->pwch[iStart], i - iStart) == 0)
+                    pfMissed[iLine] = 1;
+            }
+
+            if (i == iStart)
+                i++;
+        }
+    }
+
+    return pfMissed;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Measure                                                        *
+ *                                                                          *
+ * Purpose : Parse the corpus, and return seconds per pass. Lines with      *
+ *           missed keywords (pfMissed) are parsed, but not checksummed.    *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static double Measure(const CORPUS *pCorpus, const unsigned char *pfMissed, PARSEPROC pfnParser, int cPasses, uint64_t *pHash)
+{
+    ADDIN_PARSE_POINT *pPoints;
+    uint64_t hash = 0;
+    double t0, t;
+    int iPass;
+
+    if ((pPoints = malloc((pCorpus->cchLongest + 1) * sizeof(ADDIN_PARSE_POINT))) == NULL)
+    {
+        fprintf(stderr, "cppbench: out of memory\n");
+        exit(1);
+    }
+
+    t0 = Now();
+    for (iPass = 0; iPass < cPasses; iPass++)
+    {
+        USHORT usCookie = 0;
+        size_t iLine;
+
+        hash = 14695981039346656037ULL;  /* FNV-1a offset basis */
+        for (iLine = 0; iLine < pCorpus->cLines; iLine++)
+        {
+            int cPoints = 0;
+
+            if (CorpusIsFirstLine(pCorpus, iLine))
+                usCookie = 0;
+
+            usCookie = pfnParser(usCookie, &pCorpus->pwch[pCorpus->piLine[iLine]],
+                (int)(pCorpus->piLine[iLine + 1] - pCorpus->piLine[iLine]), pPoints, &cPoints);
+            if (!pfMissed[iLine])
+                hash = HashLine(hash, usCookie, pPoints, cPoints);
+        }
+    }
+    t = (Now() - t0) / cPasses;
+
+    free(pPoints);
+    *pHash = hash;
+    return t;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: FindIdents                                                     *
+ *                                                                          *
+ * Purpose : Find every identifier in the corpus (also in comments).        *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int FindIdents(const CORPUS *pCorpus, IDENTS *pIdents)
+{
+    size_t i, cIdentsMax = 0;
+
+    for (i = 0; i < pCorpus->cwch; )
+    {
+        size_t iStart = i;
+
+        if (pCorpus->pwch[i] != L'_' && !IsCharAlphaNumericW(pCorpus->pwch[i]))
+        {
+            i++;
+            continue;
+        }
+
+        do
+            i++;
+        while (i < pCorpus->cwch && (pCorpus->pwch[i] == L'_' || IsCharAlphaNumericW(pCorpus->pwch[i])));
+
+        // Not numbers, and not absurdly long names.
+        if (pCorpus->pwch[iStart] != L'_' && !IsCharAlphaW(pCorpus->pwch[iStart]))
+            continue;
+        if (i - iStart > 255)
+            continue;
+
+        if (pIdents->cIdents == cIdentsMax)
+        {
+            size_t *piIdent;
+            unsigned char *pcch;
+
+            cIdentsMax = cIdentsMax ? cIdentsMax * 2 : 65536;
+            if ((piIdent = realloc(pIdents->piIdent, cIdentsMax * sizeof(size_t))) != NULL)
+                pIdents->piIdent = piIdent;
+            if ((pcch = realloc(pIdents->pcch, cIdentsMax)) != NULL)
+                pIdents->pcch = pcch;
+            if (piIdent == NULL || pcch == NULL)
+                return 0;
+        }
+        pIdents->piIdent[pIdents->cIdents] = iStart;
+        pIdents->pcch[pIdents->cIdents++] = (unsigned char)(i - iStart);
+    }
+
+    return 1;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: MeasureKeywords                                                *
+ *                                                                          *
+ * Purpose : Look up every identifier, and return seconds per pass.         *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static double MeasureKeywords(const CORPUS *pCorpus, const IDENTS *pIdents, KEYWORDPROC pfnIsKeyword, int cPasses, size_t *pcKeywords)
+{
+    size_t cKeywords = 0;
+    double t0;
+    int iPass;
+
+    t0 = Now();
+    for (iPass = 0; iPass < cPasses; iPass++)
+    {
+        size_t i;
+
+        cKeywords = 0;
+        for (i = 0; i < pIdents->cIdents; i++)
+            cKeywords += pfnIsKeyword(&pCorpus->pwch[pIdents->piIdent[i]], pIdents->pcch[i]) != 0;
+    }
+
+    *pcKeywords = cKeywords;
+    return (Now() - t0) / cPasses;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: SearchIsKeyword                                                *
+ *                                                                          *
+ * Purpose : Binary search in the lexer's keyword list; what the hash       *
+ *           replaced. Return keyword number (1-KW_COUNT), or 0.            *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static size_t SearchIsKeyword(PCWSTR pchText, size_t cchText)
+{
+    size_t iLo = 0, iHi = KW_COUNT;
+
+    while (iLo < iHi)
+    {
+        size_t iMid = (iLo + iHi) / 2;
+        int iCmp = Compare(apszKeywords[iMid], pchText, cchText);
+
+        if (iCmp == 0)
+            return iMid + 1;
+        else if (iCmp < 0)
+            iLo = iMid + 1;
+        else
+            iHi = iMid;
+    }
+
+    return 0;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Compare                                                        *
+ *                                                                          *
+ * Purpose : Compare a keyword with a word of the text, like strcmp().      *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int Compare(const char *pszKeyword, PCWSTR pchText, size_t cchText)
+{
+    size_t i;
+
+    for (i = 0; i < cchText && pszKeyword[i] != '\0'; i++)
+    {
+        if ((WCHAR)(unsigned char)pszKeyword[i] != pchText[i])
+            return ((WCHAR)(unsigned char)pszKeyword[i] < pchText[i]) ? -1 : 1;
+    }
+
+    return (pszKeyword[i] != '\0') ? 1 : (i < cchText) ? -1 : 0;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: HashLine                                                       *
+ *                                                                          *
+ * Purpose : Add cookie and parse points of a line to the checksum.         *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static uint64_t HashLine(uint64_t hash, USHORT usCookie, const ADDIN_PARSE_POINT *pPoints, int cPoints)
+{
+    int i;
+
+    hash = (hash ^ usCookie) * 1099511628211ULL;
+    for (i = 0; i < cPoints; i++)
+    {
+        hash = (hash ^ pPoints[i].iChar) * 1099511628211ULL;
+        hash = (hash ^ pPoints[i].iColor) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Now                                                            *
+ *                                                                          *
+ * Purpose : Return current time, in seconds.                               *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static double Now(void)
+{
+    struct timespec ts;
+
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
@@ -0,0 +1,624 @@
+﻿/****************************************************************************
+ *                                                                          *
+ * File    : cppref.c                                                       *
+ *                                                                          *
+ * Purpose : Reference C++ syntax parser, for the benchmark.                *
+ *                                                                          *
+ *           The original character-by-character parser in cppfile.c,       *
+ *           kept as it was (only the keywords are narrow strings), so the  *
+ *           lexer in cpplex.c can be checked for identical output.         *
+ *           Don't "improve" this file.                                     *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+#include <wctype.h>
+#if defined(_WIN32)
+#include <windows.h>
+#include <addin.h>
+#else /* !_WIN32 */
+#include "../../Shared/winhost.h"
+#endif /* !_WIN32 */
+
+#define NELEMS(a)  (sizeof(a) / sizeof(a[0]))
+
+// Flags for usCookie.
+#define FLAG_COMMENT       0x01
+#define FLAG_PREPROCESSOR  0x02
+#define FLAG_EXT_COMMENT   0x04
+#define FLAG_STRING        0x08
+#define FLAG_CHAR          0x10
+
+// Minimum and maximum folding level.
+#define MIN_FOLDLEVEL  0
+#define MAX_FOLDLEVEL  255
+
+// Keyword list - must be sorted for IsKeyword().
+static const char *apszKeywords[] = {
+    "alignas",  /* C++11 */
+    "alignof",  /* C++11 */
+    "and",
+    "and_eq",
+    "asm",
+    "auto",
+    "bitand",
+    "bitor",
+    "bool",
+    "break",
+    "case",
+    "catch",
+    "char",
+    "char16_t",  /* C++11 */
+    "char32_t",  /* C++11 */
+    "class",
+    "compl",
+    "concept",  /* C++20 */
+    "const",
+    "constexpr",  /* C++11 */
+    "const_cast",
+    "continue",
+    "decltype",  /* C++11 */
+    "default",
+    "delete",
+    "do",
+    "double",
+    "dynamic_cast",
+    "else",
+    "enum",
+    "explicit",
+    "export",
+    "extern",
+    "false",
+    "float",
+    "for",
+    "friend",
+    "goto",
+    "if",
+    "inline",
+    "int",
+    "long",
+    "mutable",
+    "namespace",
+    "new",
+    "noexcept",  /* C++11 */
+    "not",
+    "not_eq",
+    "nullptr",  /* C++11 */
+    "operator",
+    "or",
+    "or_eq",
+    "private",
+    "protected",
+    "public",
+    "register",
+    "reinterpret_cast",
+    "requires",  /* C++20 */
+    "return",
+    "short",
+    "signed",
+    "sizeof",
+    "static",
+    "static_assert",  /* C++11 */
+    "static_cast",
+    "struct",
+    "switch",
+    "template",
+    "this",
+    "thread_local",  /* C++11 */
+    "throw",
+    "true",
+    "try",
+    "typedef",
+    "typeid",
+    "typename",
+    "union",
+    "unsigned",
+    "using",
+    "virtual",
+    "void",
+    "volatile",
+    "wchar_t",
+    "while",
+    "xor",
+    "xor_eq"
+};
+
+// Helper macro for assigning color to column position.
+#define DEFINE_BLOCK(pch,color) \
+    do { \
+        if (pPoints != NULL) { \
+            if (*pcPoints == 0 || (pPoints - 1)->iColor != (color)) { \
+                pPoints->iChar = (UINT)((pch) - pchText); \
+                pPoints->iColor = (color); \
+                pPoints++; \
+                (*pcPoints)++; \
+            } \
+        } \
+    } while (0)
+
+// Function prototypes.
+USHORT RefParseLine(USHORT, PCWSTR, int, ADDIN_PARSE_POINT [], PINT);
+static size_t IsKeyword(const char *[], size_t, PCWSTR, size_t);
+static int Compare(const char *, PCWSTR, size_t);
+static PCWSTR ParseNumber(PCWSTR, PCWSTR);
+
+/****************************************************************************
+ *                                                                          *
+ * Function: RefParseLine                                                   *
+ *                                                                          *
+ * Purpose : Parse C++ source code - for syntax color highlighting.         *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+USHORT RefParseLine(USHORT usCookie, PCWSTR pchText, int cchText, ADDIN_PARSE_POINT pPoints[], PINT pcPoints)
+{
+    PCWSTR pch = pchText, pchEnd = &pchText[cchText];
+    BYTE cFoldLevel = ADDIN_GET_COOKIE_LEVEL(usCookie);
+    BYTE bFlags = ADDIN_GET_COOKIE_FLAGS(usCookie);
+
+    if (pch == pchEnd)
+        ;
+    // Inside comment or extended comment.
+    else if (bFlags & (FLAG_COMMENT|FLAG_EXT_COMMENT))
+    {
+        DEFINE_BLOCK(pch, ADDIN_COLOR_COMMENT);
+    }
+    // Inside string or char constant.
+    else if (bFlags & (FLAG_CHAR|FLAG_STRING))
+    {
+        DEFINE_BLOCK(pch, ADDIN_COLOR_STRING);
+    }
+    // Inside preprocessor directive.
+    else if (bFlags & FLAG_PREPROCESSOR)
+    {
+        DEFINE_BLOCK(pch, ADDIN_COLOR_PREPROCESSOR);
+    }
+    else /* normal state */
+    {
+        while (pch < pchEnd && (*pch == L' ' || *pch == L'\t'))
+            pch++;
+
+        // Check for preprocessor directive: #...
+        if (pch < pchEnd && *pch == L'#')
+        {
+            DEFINE_BLOCK(pch, ADDIN_COLOR_PREPROCESSOR);
+            bFlags |= FLAG_PREPROCESSOR;
+
+            pch++;
+            while (pch < pchEnd && (*pch == L' ' || *pch == L'\t'))
+                pch++;
+
+            // Check for #if, #ifdef, #ifndef block.
+            if (&pch[1] < pchEnd &&
+                pch[0] == L'i' &&
+                pch[1] == L'f' &&
+                cFoldLevel < MAX_FOLDLEVEL)
+            {
+                cFoldLevel++;
+            }
+            else if (&pch[4] < pchEnd &&
+                pch[0] == L'e' &&
+                pch[1] == L'n' &&
+                pch[2] == L'd' &&
+                pch[3] == L'i' &&
+                pch[4] == L'f' &&
+                cFoldLevel > MIN_FOLDLEVEL)
+            {
+                cFoldLevel--;
+            }
+        }
+    }
+
+    while (pch < pchEnd)
+    {
+        // Inside string constant: "...."
+        if (bFlags & FLAG_STRING)
+        {
+            // Check for escape sequence.
+            if (*pch == L'\\')
+                pch++;
+            // Check for end of string constant.
+            else if (*pch == L'\"')
+                bFlags &= ~FLAG_STRING;
+            pch++;
+            continue;
+        }
+
+        // Inside char constant: '.'
+        if (bFlags & FLAG_CHAR)
+        {
+            // Check for escape sequence.
+            if (*pch == L'\\')
+                pch++;
+            // Check for end of char constant.
+            else if (*pch == L'\'')
+                bFlags &= ~FLAG_CHAR;
+            pch++;
+            continue;
+        }
+
+        // Inside single line comment: //....
+        if (bFlags & FLAG_COMMENT)
+            break;  /* done! */
+
+        // Inside extended comment: /*....*/
+        if (bFlags & FLAG_EXT_COMMENT)
+        {
+            // Check for end of extended comment...
+            if (*pch == L'*' && &pch[1] < pchEnd && pch[1] == L'/')
+            {
+                bFlags &= ~FLAG_EXT_COMMENT;
+                pch++;
+
+                // Can fold extended comments.
+                if (cFoldLevel > MIN_FOLDLEVEL) cFoldLevel--;
+            }
+            pch++;
+            continue;
+        }
+
+        // Inside preprocessor directive: #...
+        if (bFlags & FLAG_PREPROCESSOR)
+        {
+            // Check for string constant: "...."
+            if (*pch == L'\"')
+            {
+                bFlags |= FLAG_STRING;
+            }
+            // Check for char constant: '.'
+            else if (*pch == L'\'')
+            {
+                bFlags |= FLAG_CHAR;
+            }
+            // Check for single line comment: //
+            else if (*pch == L'/' && &pch[1] < pchEnd && pch[1] == L'/')
+            {
+                DEFINE_BLOCK(pch, ADDIN_COLOR_COMMENT);
+                bFlags |= FLAG_COMMENT;
+                pch++;
+            }
+            // Check for extended comment: /*....*/
+            else if (*pch == L'/' && &pch[1] < pchEnd && pch[1] == L'*')
+            {
+                DEFINE_BLOCK(pch, ADDIN_COLOR_COMMENT);
+                bFlags |= FLAG_EXT_COMMENT;
+                pch++;
+
+                // Can fold extended comments.
+                if (cFoldLevel < MAX_FOLDLEVEL) cFoldLevel++;
+            }
+            else
+            {
+                // Default case.
+                DEFINE_BLOCK(pch, ADDIN_COLOR_PREPROCESSOR);
+            }
+            pch++;
+            continue;
+        }
+
+        // Update curly brace level.
+        if (*pch == L'{' && cFoldLevel < MAX_FOLDLEVEL)
+            cFoldLevel++;
+        else if (*pch == L'}' && cFoldLevel > MIN_FOLDLEVEL)
+            cFoldLevel--;
+
+        // Check for single line comment: //
+        if (*pch == L'/' && &pch[1] < pchEnd && pch[1] == L'/')
+        {
+            DEFINE_BLOCK(pch, ADDIN_COLOR_COMMENT);
+            bFlags |= FLAG_COMMENT;
+            break;  /* done! */
+        }
+
+        // Check for extended comment: /*....*/
+        if (*pch == L'/' && &pch[1] < pchEnd && pch[1] == L'*')
+        {
+            DEFINE_BLOCK(pch, ADDIN_COLOR_COMMENT);
+            bFlags |= FLAG_EXT_COMMENT;
+            pch += 2;
+
+            // Can fold extended comments.
+            if (cFoldLevel < MAX_FOLDLEVEL) cFoldLevel++;
+            continue;
+        }
+
+        // Check for string constant: "...."
+        if (*pch == L'\"')
+        {
+            DEFINE_BLOCK(pch, ADDIN_COLOR_STRING);
+            bFlags |= FLAG_STRING;
+            pch++;
+            continue;
+        }
+
+        // Check for char constant: '.'
+        if (*pch == L'\'')
+        {
+            DEFINE_BLOCK(pch, ADDIN_COLOR_STRING);
+            bFlags |= FLAG_CHAR;
+            pch++;
+            continue;
+        }
+
+        // Check for operator.
+        if (&pch[2] < pchEnd && (
+            (pch[0] == L'<' && pch[1] == L'<' && pch[2] == L'=') ||  /* <<= */
+            (pch[0] == L'>' && pch[1] == L'>' && pch[2] == L'=') ||  /* >>= */
+            (pch[0] == L'.' && pch[1] == L'.' && pch[2] == L'.') ||  /* ... */
+            (pch[0] == L'-' && pch[1] == L'>' && pch[2] == L'*') ||  /* ->* */
+            (pch[0] == L'<' && pch[1] == L'=' && pch[2] == L'>')))   /* <=> */
+        {
+            DEFINE_BLOCK(pch, ADDIN_COLOR_OPERATOR);
+            pch += 3;
+            continue;
+        }
+        else if (&pch[1] < pchEnd && (
+            (pch[0] == L'+' && pch[1] == L'+') ||  /* ++ */
+            (pch[0] == L'-' && pch[1] == L'-') ||  /* -- */
+            (pch[0] == L'-' && pch[1] == L'>') ||  /* -> */
+            (pch[0] == L'<' && pch[1] == L'<') ||  /* << */
+            (pch[0] == L'>' && pch[1] == L'>') ||  /* >> */
+            (pch[0] == L'<' && pch[1] == L'=') ||  /* <= */
+            (pch[0] == L'>' && pch[1] == L'=') ||  /* >= */
+            (pch[0] == L'=' && pch[1] == L'=') ||  /* == */
+            (pch[0] == L'!' && pch[1] == L'=') ||  /* != */
+            (pch[0] == L'&' && pch[1] == L'&') ||  /* && */
+            (pch[0] == L'|' && pch[1] == L'|') ||  /* || */
+            (pch[0] == L'*' && pch[1] == L'=') ||  /* *= */
+            (pch[0] == L'/' && pch[1] == L'=') ||  /* /= */
+            (pch[0] == L'%' && pch[1] == L'=') ||  /* %= */
+            (pch[0] == L'+' && pch[1] == L'=') ||  /* += */
+            (pch[0] == L'-' && pch[1] == L'=') ||  /* -= */
+            (pch[0] == L'&' && pch[1] == L'=') ||  /* &= */
+            (pch[0] == L'^' && pch[1] == L'=') ||  /* ^= */
+            (pch[0] == L'|' && pch[1] == L'=') ||  /* |= */
+            (pch[0] == L'.' && pch[1] == L'*') ||  /* .* */
+            (pch[0] == L':' && pch[1] == L':')))   /* :: */
+        {
+            DEFINE_BLOCK(pch, ADDIN_COLOR_OPERATOR);
+            pch += 2;
+            continue;
+        }
+        else if (
+            *pch == L',' ||
+            *pch == L'*' ||  /* indirection or multiply */
+            *pch == L'(' ||
+            *pch == L')' ||
+            *pch == L'{' ||
+            *pch == L'}' ||
+            *pch == L'[' ||
+            *pch == L']' ||
+            *pch == L'=' ||
+            *pch == L'&' ||  /* address of, or bitwise and */
+            *pch == L'!' ||
+            *pch == L'+' ||
+            *pch == L'-' ||
+            *pch == L'.' ||
+            *pch == L'<' ||
+            *pch == L'>' ||
+            *pch == L'/' ||
+            *pch == L'%' ||
+            *pch == L'^' ||
+            *pch == L'|' ||
+            *pch == L'?' ||  /* ?: */
+            *pch == L':' ||  /* ?: or bitfield */
+            *pch == L'~')
+        {
+            DEFINE_BLOCK(pch, ADDIN_COLOR_OPERATOR);
+            pch++;
+            continue;
+        }
+
+        // Check for number.
+        if (iswdigit(*pch))
+        {
+            DEFINE_BLOCK(pch, ADDIN_COLOR_NUMBER);
+            pch = ParseNumber(pch, pchEnd);
+            continue;
+        }
+
+        // Check for identifier.
+        if (*pch == L'_' || IsCharAlphaW(*pch))
+        {
+            PCWSTR pchIdent = pch;
+            do
+                pch++;
+            while (pch < pchEnd && (*pch == L'_' || IsCharAlphaNumericW(*pch)));
+
+            if (IsKeyword(apszKeywords, NELEMS(apszKeywords), pchIdent, pch - pchIdent))
+            {
+                DEFINE_BLOCK(pchIdent, ADDIN_COLOR_KEYWORD);
+            }
+            else
+            {
+                DEFINE_BLOCK(pchIdent, ADDIN_COLOR_TEXT);
+            }
+            continue;
+        }
+
+        // Default case.
+        DEFINE_BLOCK(pch, ADDIN_COLOR_TEXT);
+        pch++;
+
+        // Skip useless white-space.
+        while (pch < pchEnd && (*pch == L' ' || *pch == L'\t'))
+            pch++;
+    }
+
+    // If no line continuation ('\'), clear *most* flags for next line.
+    if (cchText < 2 || pchText[cchText-1] != L'\n' || pchText[cchText-2] != L'\\')
+        bFlags &= FLAG_EXT_COMMENT;
+
+    return ADDIN_MAKE_COOKIE(bFlags, cFoldLevel);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: IsKeyword                                                      *
+ *                                                                          *
+ * Purpose : Return non-zero index, if the given string is a keyword.       *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static size_t IsKeyword(const char *apszKeywords[], size_t cKeywords, PCWSTR pchText, size_t cchText)
+{
+    const char **ppszKeywords = apszKeywords;
+
+    while (cKeywords > 0)
+    {
+        size_t pivot = cKeywords >> 1;
+        int cond = Compare(ppszKeywords[pivot], pchText, cchText);
+        if (cond > 0)
+        {
+            // Search below pivot.
+            cKeywords = pivot;
+            continue;
+        }
+        else if (cond < 0)
+        {
+            // Search above pivot.
+            ppszKeywords += pivot + 1;
+            cKeywords -= pivot + 1;
+            continue;
+        }
+        else
+        {
+            // Got a match, but is it exact?
+            if (ppszKeywords[pivot][cchText] == L'\0')
+                return 1 + (ppszKeywords - apszKeywords) + pivot;
+
+            // Search below pivot (for a shorter keyword).
+            cKeywords = pivot;
+            continue;
+        }
+    }
+    return 0;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Compare                                                        *
+ *                                                                          *
+ * Purpose : Like wcsncmp(), for a narrow keyword and UTF-16 text.          *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int Compare(const char *psz, PCWSTR pch, size_t cch)
+{
+    for (; cch > 0; cch--, psz++, pch++)
+    {
+        if ((WCHAR)(unsigned char)*psz != *pch)
+            return ((WCHAR)(unsigned char)*psz < *pch) ? -1 : 1;
+        if (*psz == '\0')
+            break;
+    }
+    return 0;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ParseNumber                                                    *
+ *                                                                          *
+ * Purpose : Parse a numeric value.                                         *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static PCWSTR ParseNumber(PCWSTR pch, PCWSTR pchEnd)
+{
+    BOOL fFloat = FALSE;
+
+    // Parse hexadecimal number.
+    if (pch[0] == L'0' && &pch[1] < pchEnd && (pch[1] == L'x' || pch[1] == L'X'))
+    {
+        pch += 2;
+
+        while (pch < pchEnd && iswxdigit(*pch))
+            pch++;
+    }
+    // Parse binary number (C++14).
+    if (pch[0] == L'0' && &pch[1] < pchEnd && (pch[1] == L'b' || pch[1] == L'B'))
+    {
+        pch += 2;
+
+        while (pch < pchEnd && (*pch == L'0' || *pch == L'1'))
+            pch++;
+    }
+    // Parse decimal number.
+    else
+    {
+        pch++;
+
+        while (pch < pchEnd && iswdigit(*pch))
+            pch++;
+
+        if (pch < pchEnd && *pch == L'.')
+        {
+            pch++;
+
+            while (pch < pchEnd && iswdigit(*pch))
+                pch++;
+
+            fFloat = TRUE;
+        }
+
+        if (pch < pchEnd && (*pch == L'e' || *pch == L'E'))
+        {
+            pch++;
+
+            if (pch < pchEnd && (*pch == L'-' || *pch == L'+'))
+                pch++;
+
+            while (pch < pchEnd && iswdigit(*pch))
+                pch++;
+
+            fFloat = TRUE;
+        }
+    }
+
+    // Parse suffix.
+    if (fFloat)
+    {
+        if (pch < pchEnd && (*pch == L'f' || *pch == L'F' || *pch == L'l' || *pch == L'L'))
+            pch++;
+    }
+    else
+    {
+        /* 'ULL' */
+        if (&pch[2] < pchEnd && (pch[0] == L'u' || pch[0] == L'U') && (pch[1] == L'l' || pch[1] == L'L') && (pch[2] == L'l' || pch[2] == L'L'))
+            pch += 3;
+        /* 'LLU' */
+        else if (&pch[2] < pchEnd && (pch[0] == L'l' || pch[0] == L'L') && (pch[1] == L'l' || pch[1] == L'L') && (pch[2] == L'u' || pch[2] == L'U'))
+            pch += 3;
+        /* 'LL' */
+        else if (&pch[1] < pchEnd && (pch[0] == L'l' || pch[0] == L'L') && (pch[1] == L'l' || pch[1] == L'L'))
+            pch += 2;
+        /* 'UL' */
+        else if (&pch[1] < pchEnd && (pch[0] == L'u' || pch[0] == L'U') && (pch[1] == L'l' || pch[1] == L'L'))
+            pch += 2;
+        /* 'LU' */
+        else if (&pch[1] < pchEnd && (pch[0] == L'l' || pch[0] == L'L') && (pch[1] == L'u' || pch[1] == L'U'))
+            pch += 2;
+        /* 'U' */
+        else if (pch < pchEnd && (*pch == L'u' || *pch == L'U'))
+            pch++;
+        /* 'L' */
+        else if (pch < pchEnd && (*pch == L'l' || *pch == L'L'))
+            pch++;
+    }
+
+    return pch;
+}
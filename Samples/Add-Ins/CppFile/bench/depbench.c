@@ -0,0 +1,932 @@
+﻿/****************************************************************************
+ *                                                                          *
+ * File    : depbench.c                                                     *
+ *                                                                          *
+ * Purpose : C++ dependency scanner benchmark.                              *
+ *                                                                          *
+ *           Writes a synthetic include graph into a directory: layers of   *
+ *           headers, each including a few headers of the next layer, and   *
+ *           all of them including common.h (deep fan-in). Then scans the   *
+ *           main file with the original recursive scanner (depref.c) and   *
+ *           with depscan.c, and prints time, files read, and dependencies  *
+ *           reported. Both must find the same files; depscan.c must        *
+ *           report each one once. With -cycles, each header also includes  *
+ *           one of the layer above; the original scanner would never stop, *
+ *           so it is skipped.                                              *
+ *                                                                          *
+ *           With -cache, also scans through the dependency cache: cold     *
+ *           (every file read), after saving and loading the cache (none    *
+ *           read), and after editing some headers, and adding late.h,      *
+ *           which main.cpp includes but is missing until then (only those  *
+ *           read). Each time, the files found must be the same as without  *
+ *           the cache.                                                     *
+ *                                                                          *
+ *           Only uses the C11 standard library, and stat(); builds on any  *
+ *           host:                                                          *
+ *           cc -O2 depbench.c depref.c ../depscan.c -o depbench            *
+ *           mkdir /tmp/deps && ./depbench -dir /tmp/deps                   *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "../depscan.h"
+
+#if defined(_WIN32)
+#define stat  _stat
+#endif
+
+#define CCHMAXNAME  1024
+
+// Defaults: headers in each layer, layers, includes of the next layer, includes in the main file,
+// other lines in each header, and passes.
+#define C_WIDTH   1000
+#define C_DEPTH   6
+#define C_FANOUT  3
+#define C_ROOTS   20
+#define C_LINES   50
+#define C_PASSES  5
+#define C_EDITS   10
+
+// Default most dependencies reported by the original scanner, before it is stopped.
+#define C_REFMAX  2000000
+
+// Include graph.
+typedef struct GRAPH {
+    const char *pszDir;     // Directory.
+    int cWidth;             // Headers in each layer.
+    int cDepth;             // Layers.
+    int cFanout;            // Includes of the next layer, in each header.
+    int cRoots;             // Includes in the main file.
+    int cLines;             // Other lines in each header.
+    int fCycles;            // Also include a header of the layer above.
+} GRAPH;
+
+// Dependencies found by one scan.
+typedef struct FOUND {
+    unsigned char *pfFound; // Each file: found?
+    size_t cFiles;          // Number of files.
+    size_t cWidth;          // Headers in each layer.
+    size_t cReported;       // Dependencies reported.
+    size_t cDistinct;       // Different dependencies reported.
+    size_t cReportedMax;    // Stop the scan after this many.
+} FOUND;
+
+// The original scanner (depref.c).
+BOOL CALLBACK RefScanner(LPCWSTR, BOOL (CALLBACK *)(LPCWSTR, LPCVOID), LPCVOID);
+
+// Reading files, and finding included files; also for depref.c.
+FILE *BenchOpenFile(PCWSTR);
+BOOL BenchReadLine(FILE *, PWSTR, size_t);
+PWSTR CALLBACK BenchSearchInclude(PWSTR, PCWSTR);
+
+// Files opened.
+static size_t g_cOpened;
+
+// Static function prototypes.
+static void Usage(void);
+static int MakeGraph(const GRAPH *, unsigned int);
+static int WriteHeader(const GRAPH *, int, int, uint32_t *);
+static double Measure(const GRAPH *, BOOL, PDEPCACHE, int, FOUND *);
+static int MeasureCache(const GRAPH *, int, int, FOUND *, unsigned int);
+static int EditGraph(const GRAPH *, int, const FOUND *, uint32_t *);
+static int SaveCache(PDEPCACHE, const char *, size_t *);
+static PDEPCACHE LoadCache(const char *);
+static BOOL CALLBACK ScanFile(PCWSTR, PDEPSCAN);
+static BOOL CALLBACK GetFileStamp(PCWSTR, uint64_t *);
+static BOOL CALLBACK AddDepFile(LPCWSTR, LPCVOID);
+static void MakeName(PWSTR, const char *, const char *);
+static void NarrowName(char *, PCWSTR);
+static double Now(void);
+static uint32_t Random(uint32_t *);
+
+// Inline functions.
+static inline BOOL IsSlash(WCHAR ch)
+{
+    return ch == L'/' || ch == L'\\';
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: main                                                           *
+ *                                                                          *
+ * Purpose : Main entry point.                                              *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+int main(int argc, char *argv[])
+{
+    GRAPH graph = { NULL, C_WIDTH, C_DEPTH, C_FANOUT, C_ROOTS, C_LINES, 0 };
+    FOUND foundRef = {0}, foundScan = {0};
+    size_t cOpenedRef = 0, cOpenedScan;
+    unsigned int seed = 1;
+    int cPasses = C_PASSES;
+    int cEdits = C_EDITS;
+    int fCache = 0;
+    double tRef = 0, tScan;
+    int i;
+
+    foundRef.cReportedMax = C_REFMAX;
+    foundScan.cReportedMax = SIZE_MAX;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-dir") == 0 && i + 1 < argc)
+            graph.pszDir = argv[++i];
+        else if (strcmp(argv[i], "-width") == 0 && i + 1 < argc)
+            graph.cWidth = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-depth") == 0 && i + 1 < argc)
+            graph.cDepth = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-fanout") == 0 && i + 1 < argc)
+            graph.cFanout = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-roots") == 0 && i + 1 < argc)
+            graph.cRoots = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-lines") == 0 && i + 1 < argc)
+            graph.cLines = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-cycles") == 0)
+            graph.fCycles = 1;
+        else if (strcmp(argv[i], "-passes") == 0 && i + 1 < argc)
+            cPasses = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-refmax") == 0 && i + 1 < argc)
+            foundRef.cReportedMax = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc)
+            seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-cache") == 0)
+            fCache = 1;
+        else if (strcmp(argv[i], "-edits") == 0 && i + 1 < argc)
+            cEdits = atoi(argv[++i]);
+        else
+        {
+            Usage();
+            return 1;
+        }
+    }
+
+    if (graph.pszDir == NULL || graph.cWidth <= 0 || graph.cWidth > 99999 || graph.cDepth <= 0 || graph.cDepth > 99 ||
+        graph.cFanout < 0 || graph.cRoots <= 0 || graph.cLines < 0 || cPasses <= 0 || cEdits < 0)
+    {
+        Usage();
+        return 1;
+    }
+
+    if (!MakeGraph(&graph, seed))
+        return 1;
+
+    // One flag for common.h, and one for each header.
+    foundRef.cFiles = foundScan.cFiles = 1 + (size_t)graph.cWidth * graph.cDepth;
+    foundRef.cWidth = foundScan.cWidth = graph.cWidth;
+    foundRef.pfFound = malloc(foundRef.cFiles);
+    foundScan.pfFound = malloc(foundScan.cFiles);
+    if (foundRef.pfFound == NULL || foundScan.pfFound == NULL)
+    {
+        fprintf(stderr, "depbench: out of memory\n");
+        return 1;
+    }
+
+    printf("%d headers (%d layers of %d), %d includes of the next layer%s, %d in the main file\n\n",
+        graph.cWidth * graph.cDepth, graph.cDepth, graph.cWidth, graph.cFanout, graph.fCycles ? " (and one of the layer above)" : "", graph.cRoots);
+
+    // Warm up (the file cache), then measure.
+    (void)Measure(&graph, TRUE, NULL, 1, &foundScan);
+    tScan = Measure(&graph, TRUE, NULL, cPasses, &foundScan);
+    cOpenedScan = g_cOpened / cPasses;
+
+    if (!graph.fCycles)
+    {
+        tRef = Measure(&graph, FALSE, NULL, 1, &foundRef);
+        cOpenedRef = g_cOpened;
+    }
+
+    printf("scanner       ms/scan   files read     reported     distinct\n");
+    if (graph.fCycles)
+        printf("original      skipped (would never stop)\n");
+    else if (foundRef.cReported > foundRef.cReportedMax)
+        printf("original   %10.1f %12zu %12zu %12zu  (stopped)\n", tRef * 1e3, cOpenedRef, foundRef.cReported, foundRef.cDistinct);
+    else
+        printf("original   %10.1f %12zu %12zu %12zu\n", tRef * 1e3, cOpenedRef, foundRef.cReported, foundRef.cDistinct);
+    printf("depscan    %10.1f %12zu %12zu %12zu\n", tScan * 1e3, cOpenedScan, foundScan.cReported, foundScan.cDistinct);
+
+    if (!graph.fCycles && foundRef.cReported <= foundRef.cReportedMax)
+    {
+        printf("\nspeedup    %.1fx\n", tRef / tScan);
+
+        if (memcmp(foundRef.pfFound, foundScan.pfFound, foundScan.cFiles) != 0)
+        {
+            fprintf(stderr, "depbench: different dependencies found\n");
+            return 1;
+        }
+    }
+
+    if (foundScan.cReported != foundScan.cDistinct)
+    {
+        fprintf(stderr, "depbench: dependencies reported more than once\n");
+        return 1;
+    }
+
+    if (fCache && !MeasureCache(&graph, cEdits, cPasses, &foundScan, seed))
+        return 1;
+
+    return 0;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Usage                                                          *
+ *                                                                          *
+ * Purpose : Display usage.                                                 *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static void Usage(void)
+{
+    fprintf(stderr, "Usage: depbench -dir directory [-width n] [-depth n] [-fanout n] [-roots n]\n"
+                    "                [-lines n] [-cycles] [-passes n] [-refmax n] [-seed n]\n"
+                    "                [-cache] [-edits n]\n"
+                    "       the directory must exist; files in it are overwritten\n");
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: MakeGraph                                                      *
+ *                                                                          *
+ * Purpose : Write the include graph: main.cpp, common.h, and headers       *
+ *           hLL_IIIII.h (layer LL, index IIIII). main.cpp also includes    *
+ *           late.h, which is missing (EditGraph() writes it).              *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int MakeGraph(const GRAPH *pGraph, unsigned int seed)
+{
+    char szName[CCHMAXNAME];
+    uint32_t uSeed = seed ? seed : 1;
+    FILE *pf;
+    int iLayer, i;
+
+    snprintf(szName, sizeof(szName), "%s/common.h", pGraph->pszDir);
+    if ((pf = fopen(szName, "w")) == NULL)
+    {
+        fprintf(stderr, "depbench: can't create '%s'\n", szName);
+        return 0;
+    }
+    fprintf(pf, "/* common.h - included by every header */\n#pragma once\ntypedef int common_t;\n");
+    fclose(pf);
+
+    snprintf(szName, sizeof(szName), "%s/late.h", pGraph->pszDir);
+    (void)remove(szName);
+
+    snprintf(szName, sizeof(szName), "%s/main.cpp", pGraph->pszDir);
+    if ((pf = fopen(szName, "w")) == NULL)
+    {
+        fprintf(stderr, "depbench: can't create '%s'\n", szName);
+        return 0;
+    }
+    fprintf(pf, "// main.cpp\n#include <stdio.h>\n#include \"late.h\"\n");
+    for (i = 0; i < pGraph->cRoots; i++)
+        fprintf(pf, "#include \"h00_%05u.h\"\n", (unsigned)(Random(&uSeed) % pGraph->cWidth));
+    fprintf(pf, "int main(void) { return 0; }\n");
+    fclose(pf);
+
+    for (iLayer = 0; iLayer < pGraph->cDepth; iLayer++)
+    {
+        for (i = 0; i < pGraph->cWidth; i++)
+        {
+            if (!WriteHeader(pGraph, iLayer, i, &uSeed))
+                return 0;
+        }
+    }
+
+    return 1;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: WriteHeader                                                    *
+ *                                                                          *
+ * Purpose : Write one header of the include graph.                         *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int WriteHeader(const GRAPH *pGraph, int iLayer, int iHeader, uint32_t *puSeed)
+{
+    char szName[CCHMAXNAME];
+    FILE *pf;
+    int i;
+
+    snprintf(szName, sizeof(szName), "%s/h%02d_%05d.h", pGraph->pszDir, iLayer, iHeader);
+    if ((pf = fopen(szName, "w")) == NULL)
+    {
+        fprintf(stderr, "depbench: can't create '%s'\n", szName);
+        return 0;
+    }
+
+    fprintf(pf, "/*\n * h%02d_%05d.h\n * #include \"not_a_dependency.h\"\n */\n\n#pragma once\n#include \"common.h\"\n", iLayer, iHeader);
+
+    // Some includes as ./name - the same file.
+    for (i = 0; iLayer + 1 < pGraph->cDepth && i < pGraph->cFanout; i++)
+        fprintf(pf, "#%sinclude \"%sh%02d_%05u.h\"\n", (i == 1) ? "  " : "", (Random(puSeed) % 4 == 0) ? "./" : "",
+            iLayer + 1, (unsigned)(Random(puSeed) % pGraph->cWidth));
+
+    if (pGraph->fCycles && iLayer > 0)
+        fprintf(pf, "#include \"h%02d_%05u.h\"\n", iLayer - 1, (unsigned)(Random(puSeed) % pGraph->cWidth));
+
+    fprintf(pf, "#include <string.h>\n\n");
+    for (i = 0; i < pGraph->cLines; i++)
+        fprintf(pf, "static inline int f%02d_%05d_%d(int x) { return x * %d + %d; }  /* %s */\n",
+            iLayer, iHeader, i, i + 1, iHeader, (i % 8 == 0) ? "#include \"nope.h\"" : "filler");
+
+    fclose(pf);
+    return 1;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Measure                                                        *
+ *                                                                          *
+ * Purpose : Scan the main file; return seconds per scan.                   *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static double Measure(const GRAPH *pGraph, BOOL fDepScan, PDEPCACHE pCache, int cPasses, FOUND *pFound)
+{
+    static const DEPSCANHOST Host = {
+        .pfnScanFile = ScanFile,
+        .pfnSearchInclude = BenchSearchInclude,
+        .pfnGetStamp = GetFileStamp,
+        .fIgnoreCase = FALSE,
+    };
+    WCHAR szMain[CCHMAXNAME];
+    double t0;
+    int iPass;
+
+    MakeName(szMain, pGraph->pszDir, "main.cpp");
+
+    g_cOpened = 0;
+    t0 = Now();
+    for (iPass = 0; iPass < cPasses; iPass++)
+    {
+        memset(pFound->pfFound, 0, pFound->cFiles);
+        pFound->cReported = pFound->cDistinct = 0;
+
+        if (fDepScan ? !DepScan(szMain, &Host, pCache, AddDepFile, pFound) : !RefScanner(szMain, AddDepFile, pFound))
+        {
+            // The original scanner may be stopped.
+            if (pFound->cReported <= pFound->cReportedMax || fDepScan)
+            {
+                fprintf(stderr, "depbench: scan failed\n");
+                exit(1);
+            }
+            break;
+        }
+    }
+
+    return (Now() - t0) / cPasses;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: MeasureCache                                                   *
+ *                                                                          *
+ * Purpose : Scan the main file through the dependency cache: cold, warm    *
+ *           (after saving and loading), and after editing the graph. The   *
+ *           files found must be the same as without the cache.             *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int MeasureCache(const GRAPH *pGraph, int cEdits, int cPasses, FOUND *pFound, unsigned int seed)
+{
+    char szCache[CCHMAXNAME];
+    FOUND found = *pFound;
+    uint32_t uSeed = seed ? seed : 1;
+    PDEPCACHE pCache;
+    double tCold, tLoad, tWarm, tEdit, t0;
+    size_t cOpenedCold, cOpenedWarm, cOpenedEdit, cbImage;
+    size_t cReportedCold, cReportedWarm;
+    int cEdited;
+
+    snprintf(szCache, sizeof(szCache), "%s/depcache.bin", pGraph->pszDir);
+
+    if ((found.pfFound = malloc(found.cFiles)) == NULL || (pCache = DepCacheCreate(FALSE)) == NULL)
+    {
+        fprintf(stderr, "depbench: out of memory\n");
+        return 0;
+    }
+
+    // Cold: every file is read, and kept.
+    tCold = Measure(pGraph, TRUE, pCache, 1, &found);
+    cOpenedCold = g_cOpened;
+    cReportedCold = found.cReported;
+    if (memcmp(found.pfFound, pFound->pfFound, found.cFiles) != 0)
+    {
+        fprintf(stderr, "depbench: different dependencies found (cold cache)\n");
+        return 0;
+    }
+
+    // Save, and load into a new cache, like the next session.
+    if (!SaveCache(pCache, szCache, &cbImage))
+        return 0;
+    DepCacheDestroy(pCache);
+
+    t0 = Now();
+    if ((pCache = LoadCache(szCache)) == NULL)
+        return 0;
+    tLoad = Now() - t0;
+
+    // Warm: nothing changed, nothing read.
+    tWarm = Measure(pGraph, TRUE, pCache, cPasses, &found);
+    cOpenedWarm = g_cOpened / cPasses;
+    cReportedWarm = found.cReported;
+    if (memcmp(found.pfFound, pFound->pfFound, found.cFiles) != 0)
+    {
+        fprintf(stderr, "depbench: different dependencies found (warm cache)\n");
+        return 0;
+    }
+
+    // Edit some headers, and write late.h; only those are read.
+    if ((cEdited = EditGraph(pGraph, cEdits, pFound, &uSeed)) < 0)
+        return 0;
+    (void)Measure(pGraph, TRUE, NULL, 1, pFound);
+    tEdit = Measure(pGraph, TRUE, pCache, 1, &found);
+    cOpenedEdit = g_cOpened;
+    if (memcmp(found.pfFound, pFound->pfFound, found.cFiles) != 0 || found.cDistinct != pFound->cDistinct)
+    {
+        fprintf(stderr, "depbench: different dependencies found (after edits)\n");
+        return 0;
+    }
+
+    printf("\ncache         ms/scan   files read     reported\n");
+    printf("cold       %10.1f %12zu %12zu\n", tCold * 1e3, cOpenedCold, cReportedCold);
+    printf("load       %10.1f %12s %12s  (%zu bytes)\n", tLoad * 1e3, "-", "-", cbImage);
+    printf("warm       %10.1f %12zu %12zu\n", tWarm * 1e3, cOpenedWarm, cReportedWarm);
+    printf("edited     %10.1f %12zu %12zu  (%d headers edited, late.h added)\n", tEdit * 1e3, cOpenedEdit, found.cReported, cEdited);
+
+    DepCacheDestroy(pCache);
+    free(found.pfFound);
+    return 1;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: EditGraph                                                      *
+ *                                                                          *
+ * Purpose : Add an include of the next layer to some headers found by the  *
+ *           last scan, and write late.h. Returns headers edited, or -1.    *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int EditGraph(const GRAPH *pGraph, int cEdits, const FOUND *pFound, uint32_t *puSeed)
+{
+    char szName[CCHMAXNAME];
+    int cEdited = 0, cTries;
+    FILE *pf;
+
+    for (cTries = 0; cEdited < cEdits && cTries < 100 * cEdits; cTries++)
+    {
+        int iLayer = (int)(Random(puSeed) % pGraph->cDepth);
+        int iHeader = (int)(Random(puSeed) % pGraph->cWidth);
+
+        if (iLayer + 1 >= pGraph->cDepth || !pFound->pfFound[1 + (size_t)iLayer * pGraph->cWidth + iHeader])
+            continue;
+
+        snprintf(szName, sizeof(szName), "%s/h%02d_%05d.h", pGraph->pszDir, iLayer, iHeader);
+        if ((pf = fopen(szName, "a")) == NULL)
+        {
+            fprintf(stderr, "depbench: can't write '%s'\n", szName);
+            return -1;
+        }
+        fprintf(pf, "#include \"h%02d_%05u.h\"\n", iLayer + 1, (unsigned)(Random(puSeed) % pGraph->cWidth));
+        fclose(pf);
+        cEdited++;
+    }
+
+    snprintf(szName, sizeof(szName), "%s/late.h", pGraph->pszDir);
+    if ((pf = fopen(szName, "w")) == NULL)
+    {
+        fprintf(stderr, "depbench: can't create '%s'\n", szName);
+        return -1;
+    }
+    fprintf(pf, "/* late.h */\n#include \"h%02d_%05u.h\"\n", pGraph->cDepth - 1, (unsigned)(Random(puSeed) % pGraph->cWidth));
+    fclose(pf);
+
+    return cEdited;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: SaveCache                                                      *
+ *                                                                          *
+ * Purpose : Save the dependency cache to a file.                           *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int SaveCache(PDEPCACHE pCache, const char *pszFileName, size_t *pcbImage)
+{
+    LPVOID pvImage;
+    FILE *pf;
+    int fOK;
+
+    if ((pvImage = DepCacheSave(pCache, pcbImage)) == NULL)
+    {
+        fprintf(stderr, "depbench: out of memory\n");
+        return 0;
+    }
+
+    if ((pf = fopen(pszFileName, "wb")) == NULL)
+    {
+        free(pvImage);
+        fprintf(stderr, "depbench: can't create '%s'\n", pszFileName);
+        return 0;
+    }
+
+    fOK = fwrite(pvImage, 1, *pcbImage, pf) == *pcbImage;
+    fOK = (fclose(pf) == 0) && fOK;
+    free(pvImage);
+
+    if (!fOK)
+        fprintf(stderr, "depbench: can't write '%s'\n", pszFileName);
+
+    return fOK;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: LoadCache                                                      *
+ *                                                                          *
+ * Purpose : Load a dependency cache from a file (read, not mapped).        *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static PDEPCACHE LoadCache(const char *pszFileName)
+{
+    PDEPCACHE pCache = NULL;
+    LPVOID pvImage;
+    long cbImage;
+    FILE *pf;
+
+    if ((pf = fopen(pszFileName, "rb")) == NULL)
+    {
+        fprintf(stderr, "depbench: can't open '%s'\n", pszFileName);
+        return NULL;
+    }
+
+    if (fseek(pf, 0, SEEK_END) != 0 || (cbImage = ftell(pf)) <= 0 || fseek(pf, 0, SEEK_SET) != 0 ||
+        (pvImage = malloc(cbImage)) == NULL)
+    {
+        fclose(pf);
+        fprintf(stderr, "depbench: can't read '%s'\n", pszFileName);
+        return NULL;
+    }
+
+    if (fread(pvImage, 1, cbImage, pf) == (size_t)cbImage && (pCache = DepCacheCreate(FALSE)) != NULL &&
+        !DepCacheLoad(pCache, pvImage, cbImage))
+    {
+        DepCacheDestroy(pCache);
+        pCache = NULL;
+    }
+
+    free(pvImage);
+    fclose(pf);
+
+    if (pCache == NULL)
+        fprintf(stderr, "depbench: bad cache '%s'\n", pszFileName);
+
+    return pCache;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ScanFile                                                       *
+ *                                                                          *
+ * Purpose : Read a file, line-by-line, for the dependency scanner.         *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static BOOL CALLBACK ScanFile(PCWSTR pcszFileName, PDEPSCAN pScan)
+{
+    WCHAR szLine[4096];
+    BOOL fOK = TRUE;
+    FILE *pf;
+
+    if ((pf = BenchOpenFile(pcszFileName)) == NULL)
+        return FALSE;
+
+    while (fOK && BenchReadLine(pf, szLine, sizeof(szLine) / sizeof(szLine[0])))
+        fOK = DepScanLine(pScan, szLine);
+
+    fclose(pf);
+    return fOK;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: GetFileStamp                                                   *
+ *                                                                          *
+ * Purpose : Get stamp of a file, for the dependency cache.                 *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static BOOL CALLBACK GetFileStamp(PCWSTR pcszFileName, uint64_t *pStamp)
+{
+    char szName[CCHMAXNAME];
+    struct stat st;
+
+    NarrowName(szName, pcszFileName);
+    if (stat(szName, &st) != 0)
+        return FALSE;
+
+    // Time is in seconds here; the size catches most edits in the same second.
+    *pStamp = ((uint64_t)st.st_mtime << 32) ^ (uint64_t)st.st_size;
+    return TRUE;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: AddDepFile                                                     *
+ *                                                                          *
+ * Purpose : Add a dependency - remember which file it is.                  *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static BOOL CALLBACK AddDepFile(LPCWSTR pcszDepFileName, LPCVOID pvCookie)
+{
+    FOUND *pFound = (FOUND *)pvCookie;
+    PCWSTR pszBase = pcszDepFileName, psz;
+    size_t iFile = 0;
+
+    for (psz = pcszDepFileName; *psz != L'\0'; psz++)
+    {
+        if (IsSlash(*psz))
+            pszBase = psz + 1;
+    }
+
+    // common.h is file 0; hLL_IIIII.h is file 1 + LL * width + IIIII.
+    if (pszBase[0] == L'h')
+    {
+        size_t iLayer = (pszBase[1] - L'0') * 10 + (pszBase[2] - L'0');
+        size_t iHeader = 0;
+
+        for (psz = &pszBase[4]; *psz >= L'0' && *psz <= L'9'; psz++)
+            iHeader = iHeader * 10 + (*psz - L'0');
+
+        iFile = (iHeader < pFound->cWidth) ? 1 + iLayer * pFound->cWidth + iHeader : pFound->cFiles;
+    }
+
+    if (iFile >= pFound->cFiles)
+        return FALSE;
+
+    if (!pFound->pfFound[iFile])
+        pFound->pfFound[iFile] = 1, pFound->cDistinct++;
+
+    return ++pFound->cReported <= pFound->cReportedMax;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: BenchOpenFile                                                  *
+ *                                                                          *
+ * Purpose : Open a file for reading; the name is ASCII.                    *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+FILE *BenchOpenFile(PCWSTR pcszFileName)
+{
+    char szName[CCHMAXNAME];
+
+    NarrowName(szName, pcszFileName);
+
+    g_cOpened++;
+    return fopen(szName, "r");
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: BenchReadLine                                                  *
+ *                                                                          *
+ * Purpose : Read a line, without new-line; the text is ASCII. Longer lines *
+ *           are split.                                                     *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+BOOL BenchReadLine(FILE *pf, PWSTR pchBuf, size_t cchBufMax)
+{
+    char szLine[4096];
+    size_t i;
+
+    if (cchBufMax > sizeof(szLine))
+        cchBufMax = sizeof(szLine);
+
+    if (fgets(szLine, (int)cchBufMax, pf) == NULL)
+        return FALSE;
+
+    for (i = 0; szLine[i] != '\0' && szLine[i] != '\r' && szLine[i] != '\n'; i++)
+        pchBuf[i] = (unsigned char)szLine[i];
+    pchBuf[i] = L'\0';
+
+    return TRUE;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: BenchSearchInclude                                             *
+ *                                                                          *
+ * Purpose : Get canonical name of the given include file: in the folder of *
+ *           the including file, without "." and "..". NULL if not found.   *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+PWSTR CALLBACK BenchSearchInclude(PWSTR pszIncludeName, PCWSTR pcszRefFileName)
+{
+    WCHAR szName[CCHMAXNAME];
+    size_t cch = 0, cchRoot;
+    PCWSTR psz;
+    PWSTR pszDup;
+    FILE *pf;
+
+    // Folder of the including file (with the slash).
+    if (pszIncludeName[0] != L'/')
+    {
+        for (psz = pcszRefFileName; *psz != L'\0'; psz++)
+        {
+            if (IsSlash(*psz))
+                cch = psz - pcszRefFileName + 1;
+        }
+        memcpy(szName, pcszRefFileName, cch * sizeof(WCHAR));
+    }
+    cchRoot = (cch > 0 && szName[0] == L'/') ? 1 : 0;
+
+    // Add the included name, one part at a time.
+    for (psz = pszIncludeName; *psz != L'\0'; )
+    {
+        PCWSTR pszPart = psz;
+        size_t cchPart;
+
+        while (*psz != L'\0' && !IsSlash(*psz))
+            psz++;
+        cchPart = psz - pszPart;
+        if (IsSlash(*psz))
+            psz++;
+
+        if (cchPart == 0 || (cchPart == 1 && pszPart[0] == L'.'))
+            continue;
+
+        if (cchPart == 2 && pszPart[0] == L'.' && pszPart[1] == L'.' && cch > cchRoot)
+        {
+            // Remove the last folder.
+            for (cch--; cch > cchRoot && !IsSlash(szName[cch - 1]); cch--)
+                ;
+            continue;
+        }
+
+        if (cch + cchPart + 2 > CCHMAXNAME)
+            return NULL;
+
+        memcpy(&szName[cch], pszPart, cchPart * sizeof(WCHAR));
+        cch += cchPart;
+        if (*psz != L'\0')
+            szName[cch++] = L'/';
+    }
+    szName[cch] = L'\0';
+
+    // Do we have a winner?
+    pf = BenchOpenFile(szName);
+    g_cOpened--;  /* not read */
+    if (pf == NULL)
+        return NULL;
+    fclose(pf);
+
+    if ((pszDup = malloc((cch + 1) * sizeof(WCHAR))) != NULL)
+        memcpy(pszDup, szName, (cch + 1) * sizeof(WCHAR));
+
+    return pszDup;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: MakeName                                                       *
+ *                                                                          *
+ * Purpose : Make a (wide) file name from folder and name.                  *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static void MakeName(PWSTR pszName, const char *pszDir, const char *pszFile)
+{
+    char szName[CCHMAXNAME];
+    size_t i;
+
+    snprintf(szName, sizeof(szName), "%s/%s", pszDir, pszFile);
+    for (i = 0; szName[i] != '\0'; i++)
+        pszName[i] = (unsigned char)szName[i];
+    pszName[i] = L'\0';
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: NarrowName                                                     *
+ *                                                                          *
+ * Purpose : Make a file name from a (wide) file name; the name is ASCII.   *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static void NarrowName(char *pszName, PCWSTR pcszFileName)
+{
+    size_t i;
+
+    for (i = 0; pcszFileName[i] != L'\0' && i < CCHMAXNAME - 1; i++)
+        pszName[i] = (char)pcszFileName[i];
+    pszName[i] = '\0';
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Now                                                            *
+ *                                                                          *
+ * Purpose : Return current time, in seconds.                               *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static double Now(void)
+{
+    struct timespec ts;
+
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Random                                                         *
+ *                                                                          *
+ * Purpose : Return pseudo-random number; same sequence on every host.      *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static uint32_t Random(uint32_t *puSeed)
+{
+    // xorshift32.
+    *puSeed ^= *puSeed << 13;
+    *puSeed ^= *puSeed >> 17;
+    *puSeed ^= *puSeed << 5;
+    return *puSeed;
+}
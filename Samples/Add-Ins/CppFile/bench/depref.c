@@ -0,0 +1,152 @@
+﻿/****************************************************************************
+ *                                                                          *
+ * File    : depref.c                                                       *
+ *                                                                          *
+ * Purpose : Reference C++ dependency scanner, for the benchmark.           *
+ *                                                                          *
+ *           The original recursive scanner in cppfile.c, kept as it was    *
+ *           (only reading lines, and finding included files, are done by   *
+ *           the benchmark), so the scanner in depscan.c can be checked for *
+ *           the same dependencies. It scans a file again for each time it  *
+ *           is included, and never stops for files that include each       *
+ *           other. Don't "improve" this file.                              *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#if defined(_WIN32)
+#include <windows.h>
+#include <addin.h>
+#else /* !_WIN32 */
+#include "../../Shared/winhost.h"
+#endif /* !_WIN32 */
+
+#define CCHMAXLINE  4096
+
+// Reading files, and finding included files (depbench.c).
+FILE *BenchOpenFile(PCWSTR);
+BOOL BenchReadLine(FILE *, PWSTR, size_t);
+PWSTR CALLBACK BenchSearchInclude(PWSTR, PCWSTR);
+
+// Inline functions.
+static inline PWSTR SkipWhiteSpace(PWSTR psz)
+{
+    while (*psz == L' ' || *psz == L'\t') ++psz;
+    return psz;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: RefScanner                                                     *
+ *                                                                          *
+ * Purpose : Scan a C++ file for dependencies.                              *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+BOOL CALLBACK RefScanner(LPCWSTR pcszFileName, BOOL (CALLBACK *pfnAddDepFile)(LPCWSTR pcszDepFileName, LPCVOID pvCookie), LPCVOID pvCookie)
+{
+    FILE *hf;
+    PWSTR pszInput;
+    BOOL fComment = FALSE;
+    BOOL fOK = TRUE;
+
+    // Open the file.
+    hf = BenchOpenFile(pcszFileName);
+    if (hf == NULL)
+        return FALSE;
+
+    if ((pszInput = malloc(CCHMAXLINE * sizeof(WCHAR))) == NULL)
+    {
+        fclose(hf);
+        return FALSE;
+    }
+
+    // Read the file, line-by-line.
+    while (fOK && BenchReadLine(hf, pszInput, CCHMAXLINE))
+    {
+        PWSTR psz = pszInput;
+
+restart:
+        if (fComment)
+        {
+            // In traditional comment, check for terminator.
+            while (*psz != L'\0' && (*psz != L'*' || psz[1] != L'/'))
+                psz++;
+
+            if (*psz == L'\0')
+                continue;
+
+            psz += 2;
+            fComment = FALSE;
+        }
+
+        psz = SkipWhiteSpace(psz);
+
+        // Check for traditional comment.
+        if (psz[0] == L'/' && psz[1] == L'*')
+        {
+            psz += 2;
+            fComment = TRUE;
+            goto restart;
+        }
+
+        // Parse preprocessor lines.
+        if (*psz++ == L'#')
+        {
+            psz = SkipWhiteSpace(psz);
+
+            // Look for #include preprocessor line.
+            if (psz[0] == L'i' && psz[1] == L'n' && psz[2] == L'c' && psz[3] == L'l' &&
+                psz[4] == L'u' && psz[5] == L'd' && psz[6] == L'e')
+            {
+                psz += 7;
+
+                psz = SkipWhiteSpace(psz);
+
+                if (*psz++ == L'"')  /* ignore "standard places" (#include <name>) */
+                {
+                    PWSTR pszName;
+
+                    // Scan for end of "name".
+                    for (pszName = psz; *psz != L'\0' && *psz != L'"'; psz++)
+                        ;
+
+                    if (*psz == L'"')
+                    {
+                        PWSTR pszDepFileName;
+
+                        // Insert sneaky terminator.
+                        *psz = L'\0';
+
+                        // Search for the included file.
+                        pszDepFileName = BenchSearchInclude(pszName, pcszFileName);
+                        if (pszDepFileName != NULL)
+                        {
+                            // Found included file: add as new dependency... */
+                            if (!pfnAddDepFile(pszDepFileName, pvCookie))
+                                fOK = FALSE;
+                            // ...and then recurse, to scan the new file.
+                            else if (!RefScanner(pszDepFileName, pfnAddDepFile, pvCookie))
+                                fOK = FALSE;
+                        }
+
+                        // Clean up.
+                        free(pszDepFileName);
+                    }
+                }
+            }
+        }
+    }
+
+    free(pszInput);
+    fclose(hf);
+
+    return fOK;
+}
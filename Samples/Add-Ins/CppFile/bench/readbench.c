@@ -0,0 +1,681 @@
+﻿/****************************************************************************
+ *                                                                          *
+ * File    : readbench.c                                                    *
+ *                                                                          *
+ * Purpose : Dependency scanner file reader benchmark.                      *
+ *                                                                          *
+ *           Scans files with depscan.c (includes are not followed), read   *
+ *           two ways: like the original reader, one line at a time (an     *
+ *           8 KB buffer allocated and read for every line, then a seek     *
+ *           back to the next line), and like the new one: the whole file,  *
+ *           decoded once, split into lines in place. Prints MB/s for each; *
+ *           both must see the same lines, except in files where the        *
+ *           original reader stopped at a long line.                        *
+ *                                                                          *
+ *           The readers use stdio here, instead of ReadFile() and a file   *
+ *           mapping, and decode text themselves (ANSI as Latin-1).         *
+ *                                                                          *
+ *           Only uses the C11 standard library; builds on any host:        *
+ *           cc -O2 readbench.c ../depscan.c -o readbench                   *
+ *           find /usr/include/c++ -type f | ./readbench -                  *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../depscan.h"
+
+// Default number of passes.
+#define C_PASSES  5
+
+// Limits of the original reader.
+#define CCHMAXLINE  4096
+#define RAWBUFSIZE  8192
+
+#define CCHMAXNAME  4096
+
+#define CHAR_EOF  0x1A
+
+// Text file encoding.
+typedef enum Encodings {
+    ENCODING_ANSI,
+    ENCODING_UTF8,
+    ENCODING_UTF16_LE,
+} ENCODING;
+
+// What a reader saw.
+typedef struct SEEN {
+    size_t cLines;          // Lines.
+    size_t cIncludes;       // Included names.
+    uint32_t uHash;         // Hash of the lines, and included names.
+    size_t cbRead;          // Bytes read.
+    BOOL fCut;              // Stopped at a long line (original reader).
+} SEEN;
+
+// Files.
+typedef struct FILES {
+    char **ppszNames;       // Names.
+    size_t c, cMax;         // Names used, and allocated.
+} FILES;
+
+// What the current scan saw.
+static SEEN g_seen;
+
+// Static function prototypes.
+static void Usage(void);
+static int AddName(FILES *, const char *);
+static double Measure(const FILES *, BOOL, int, SEEN *);
+static BOOL CALLBACK ScanFileByLine(PCWSTR, PDEPSCAN);
+static BOOL CALLBACK ScanFileWhole(PCWSTR, PDEPSCAN);
+static PWSTR CALLBACK SearchInclude(PWSTR, PCWSTR);
+static BOOL CALLBACK AddDepFile(LPCWSTR, LPCVOID);
+static ENCODING ReadTextFileEncoding(FILE *);
+static BOOL ReadTextFileLine(FILE *, ENCODING, PWSTR, DWORD);
+static PWSTR ReadTextFile(const char *, size_t *);
+static size_t GetTextFileEncoding(const unsigned char *, size_t, ENCODING *);
+static size_t DecodeText(const unsigned char *, size_t, ENCODING, PWSTR);
+static void HashText(PCWSTR);
+static void NarrowName(char *, PCWSTR);
+static double Now(void);
+
+/****************************************************************************
+ *                                                                          *
+ * Function: main                                                           *
+ *                                                                          *
+ * Purpose : Main entry point.                                              *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+int main(int argc, char *argv[])
+{
+    FILES files = {0};
+    SEEN seenLine, seenWhole, seen1, seen2;
+    size_t i, cCut = 0;
+    int cPasses = C_PASSES;
+    double tLine, tWhole;
+
+    for (i = 1; i < (size_t)argc; i++)
+    {
+        if (strcmp(argv[i], "-passes") == 0 && i + 1 < (size_t)argc)
+            cPasses = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-") == 0)
+        {
+            char szName[CCHMAXNAME];
+
+            // File names from standard input, one on each line.
+            while (fgets(szName, sizeof(szName), stdin) != NULL)
+            {
+                szName[strcspn(szName, "\r\n")] = '\0';
+                if (szName[0] != '\0' && !AddName(&files, szName))
+                    return 1;
+            }
+        }
+        else if (argv[i][0] == '-')
+        {
+            Usage();
+            return 1;
+        }
+        else if (!AddName(&files, argv[i]))
+            return 1;
+    }
+
+    if (files.c == 0 || cPasses <= 0)
+    {
+        Usage();
+        return 1;
+    }
+
+    // Both readers must see the same, file by file; except where the original one stopped.
+    for (i = 0; i < files.c; i++)
+    {
+        FILES file = { &files.ppszNames[i], 1, 1 };
+
+        (void)Measure(&file, FALSE, 1, &seen1);
+        (void)Measure(&file, TRUE, 1, &seen2);
+        if (seen1.fCut)
+            cCut++;
+        else if (seen1.cLines != seen2.cLines || seen1.cIncludes != seen2.cIncludes || seen1.uHash != seen2.uHash)
+        {
+            fprintf(stderr, "readbench: '%s': readers differ\n", files.ppszNames[i]);
+            return 1;
+        }
+    }
+
+    // Warm up (the file cache), then measure.
+    (void)Measure(&files, TRUE, 1, &seenWhole);
+    tLine = Measure(&files, FALSE, cPasses, &seenLine);
+    tWhole = Measure(&files, TRUE, cPasses, &seenWhole);
+
+    printf("%zu files, %.1f MB, %zu lines, %zu includes\n\n", files.c, seenWhole.cbRead / 1e6, seenWhole.cLines, seenWhole.cIncludes);
+    printf("reader          MB/s   MB read   lines\n");
+    printf("by line   %10.1f %9.1f %7zu\n", seenWhole.cbRead / 1e6 / tLine, seenLine.cbRead / 1e6, seenLine.cLines);
+    printf("whole     %10.1f %9.1f %7zu\n", seenWhole.cbRead / 1e6 / tWhole, seenWhole.cbRead / 1e6, seenWhole.cLines);
+    printf("\nspeedup   %.1fx\n", tLine / tWhole);
+    if (cCut != 0)
+        printf("%zu files were cut short by the original reader (line longer than %d)\n", cCut, CCHMAXLINE - 1);
+
+    return 0;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Usage                                                          *
+ *                                                                          *
+ * Purpose : Display usage.                                                 *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static void Usage(void)
+{
+    fprintf(stderr, "Usage: readbench [-passes n] { file | - } ...\n"
+                    "       - reads file names from standard input\n");
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: AddName                                                        *
+ *                                                                          *
+ * Purpose : Add a file name.                                               *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int AddName(FILES *pFiles, const char *pszName)
+{
+    if (pFiles->c == pFiles->cMax)
+    {
+        size_t cMax = pFiles->cMax ? pFiles->cMax * 2 : 256;
+        char **ppszNames = realloc(pFiles->ppszNames, cMax * sizeof(char *));
+        if (ppszNames == NULL)
+        {
+            fprintf(stderr, "readbench: out of memory\n");
+            return 0;
+        }
+        pFiles->ppszNames = ppszNames;
+        pFiles->cMax = cMax;
+    }
+
+    if (strlen(pszName) >= CCHMAXNAME || (pFiles->ppszNames[pFiles->c] = malloc(strlen(pszName) + 1)) == NULL)
+    {
+        fprintf(stderr, "readbench: bad name '%s'\n", pszName);
+        return 0;
+    }
+
+    strcpy(pFiles->ppszNames[pFiles->c++], pszName);
+    return 1;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Measure                                                        *
+ *                                                                          *
+ * Purpose : Scan all files; return seconds per pass.                       *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static double Measure(const FILES *pFiles, BOOL fWhole, int cPasses, SEEN *pSeen)
+{
+    static const DEPSCANHOST HostByLine = {
+        .pfnScanFile = ScanFileByLine,
+        .pfnSearchInclude = SearchInclude,
+    };
+    static const DEPSCANHOST HostWhole = {
+        .pfnScanFile = ScanFileWhole,
+        .pfnSearchInclude = SearchInclude,
+    };
+    WCHAR szName[CCHMAXNAME];
+    double t0;
+    size_t i, j;
+    int iPass;
+
+    t0 = Now();
+    for (iPass = 0; iPass < cPasses; iPass++)
+    {
+        memset(&g_seen, 0, sizeof(g_seen));
+
+        for (i = 0; i < pFiles->c; i++)
+        {
+            for (j = 0; pFiles->ppszNames[i][j] != '\0'; j++)
+                szName[j] = (unsigned char)pFiles->ppszNames[i][j];
+            szName[j] = L'\0';
+
+            if (!DepScan(szName, fWhole ? &HostWhole : &HostByLine, NULL, AddDepFile, NULL))
+            {
+                fprintf(stderr, "readbench: can't read '%s'\n", pFiles->ppszNames[i]);
+                exit(1);
+            }
+        }
+    }
+    *pSeen = g_seen;
+
+    return (Now() - t0) / cPasses;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ScanFileByLine                                                 *
+ *                                                                          *
+ * Purpose : Read a file, line-by-line, like the original reader.           *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static BOOL CALLBACK ScanFileByLine(PCWSTR pcszFileName, PDEPSCAN pScan)
+{
+    char szName[CCHMAXNAME];
+    PWSTR pszInput;
+    ENCODING eEncoding;
+    BOOL fOK = TRUE;
+    FILE *pf;
+
+    NarrowName(szName, pcszFileName);
+    if ((pf = fopen(szName, "rb")) == NULL)
+        return FALSE;
+
+    // Like GetInputLine().
+    if ((pszInput = malloc(CCHMAXLINE * sizeof(WCHAR))) == NULL)
+    {
+        fclose(pf);
+        return FALSE;
+    }
+
+    eEncoding = ReadTextFileEncoding(pf);
+    while (fOK && ReadTextFileLine(pf, eEncoding, pszInput, CCHMAXLINE))
+    {
+        HashText(pszInput);
+        g_seen.cLines++;
+        fOK = DepScanLine(pScan, pszInput);
+    }
+
+    free(pszInput);
+    fclose(pf);
+    return fOK;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ScanFileWhole                                                  *
+ *                                                                          *
+ * Purpose : Read a whole file, decoded once, like the new reader.          *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static BOOL CALLBACK ScanFileWhole(PCWSTR pcszFileName, PDEPSCAN pScan)
+{
+    char szName[CCHMAXNAME];
+    PWSTR pszText, pszEnd, psz;
+    size_t cchText;
+    BOOL fOK = TRUE;
+
+    NarrowName(szName, pcszFileName);
+    if ((pszText = ReadTextFile(szName, &cchText)) == NULL)
+        return FALSE;
+
+    // Same as ScanFile() in cppfile.c.
+    for (psz = pszText, pszEnd = pszText + cchText; fOK && psz < pszEnd; )
+    {
+        PWSTR pszLine = psz;
+
+        while (psz < pszEnd && *psz != L'\r' && *psz != L'\n')
+            psz++;
+
+        if (*psz == L'\r' && psz[1] == L'\n')
+            *psz++ = L'\0';
+        *psz++ = L'\0';
+
+        HashText(pszLine);
+        g_seen.cLines++;
+        fOK = DepScanLine(pScan, pszLine);
+    }
+
+    free(pszText);
+    return fOK;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: SearchInclude                                                  *
+ *                                                                          *
+ * Purpose : Remember an included name; never found (not followed).         *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static PWSTR CALLBACK SearchInclude(PWSTR pszIncludeName, PCWSTR pcszRefFileName)
+{
+    HashText(pszIncludeName);
+    g_seen.cIncludes++;
+    return NULL;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: AddDepFile                                                     *
+ *                                                                          *
+ * Purpose : Add a dependency; there are none.                              *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static BOOL CALLBACK AddDepFile(LPCWSTR pcszDepFileName, LPCVOID pvCookie)
+{
+    return TRUE;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ReadTextFileEncoding                                           *
+ *                                                                          *
+ * Purpose : Check for byte-order mark at the beginning of the file.        *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static ENCODING ReadTextFileEncoding(FILE *pf)
+{
+    unsigned char abBom[4];
+    ENCODING eEncoding;
+    size_t cbBom;
+
+    cbBom = fread(abBom, 1, sizeof(abBom), pf);
+    g_seen.cbRead += cbBom;
+
+    (void)fseek(pf, (long)GetTextFileEncoding(abBom, cbBom, &eEncoding), SEEK_SET);
+    return eEncoding;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ReadTextFileLine                                               *
+ *                                                                          *
+ * Purpose : Read a line from a text file, like the original reader: an     *
+ *           8 KB buffer allocated and read for each line, then a seek to   *
+ *           the next line.                                                 *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static BOOL ReadTextFileLine(FILE *pf, ENCODING eEncoding, PWSTR pchBuf, DWORD cchBufMax)
+{
+    long lCurrentOffset = ftell(pf);
+    unsigned char *pbRaw, *pb, *pbEnd;
+    size_t cbRead, cbChar = (eEncoding == ENCODING_UTF16_LE) ? 2 : 1;
+    BOOL fOK = FALSE;
+
+    if ((pbRaw = malloc(RAWBUFSIZE)) == NULL)
+        return FALSE;
+
+    cbRead = fread(pbRaw, 1, RAWBUFSIZE, pf);
+    g_seen.cbRead += cbRead;
+
+    if (cbRead != 0 && pbRaw[0] != CHAR_EOF)
+    {
+        // Find the end of the line.
+        for (pb = pbRaw, pbEnd = pbRaw + cbRead / cbChar * cbChar; pb < pbEnd; pb += cbChar)
+        {
+            unsigned ch = (cbChar == 2) ? pb[0] | pb[1] << 8 : pb[0];
+            if (ch == '\r' || ch == '\n' || ch == CHAR_EOF)
+                break;
+        }
+
+        // Too long?
+        if ((pb == pbEnd && cbRead == RAWBUFSIZE) || (DWORD)((pb - pbRaw) / cbChar) >= cchBufMax)
+        {
+            g_seen.fCut = TRUE;
+        }
+        else
+        {
+            pchBuf[DecodeText(pbRaw, pb - pbRaw, eEncoding, pchBuf)] = L'\0';
+
+            if (pb == pbEnd)
+                ;
+            else if (*pb == '\n')
+                pb += cbChar;
+            else if (*pb == '\r' && (pb += cbChar) < pbEnd && *pb == '\n')
+                pb += cbChar;
+
+            // Start from the correct file position next time.
+            fOK = fseek(pf, lCurrentOffset + (long)(pb - pbRaw), SEEK_SET) == 0;
+        }
+    }
+
+    free(pbRaw);
+    return fOK;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ReadTextFile                                                   *
+ *                                                                          *
+ * Purpose : Read a whole text file into a buffer (malloc'ed), as UTF-16;   *
+ *           up to CTRL+Z.                                                  *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static PWSTR ReadTextFile(const char *pszName, size_t *pcchText)
+{
+    unsigned char *pbFile, *pb;
+    ENCODING eEncoding;
+    PWSTR pszText;
+    size_t cbBom, cb;
+    long cbFile;
+    FILE *pf;
+
+    if ((pf = fopen(pszName, "rb")) == NULL)
+        return NULL;
+
+    // Like the file mapping: all of it.
+    if (fseek(pf, 0, SEEK_END) != 0 || (cbFile = ftell(pf)) < 0 || fseek(pf, 0, SEEK_SET) != 0 ||
+        (pbFile = malloc(cbFile + 1)) == NULL)
+    {
+        fclose(pf);
+        return NULL;
+    }
+
+    cb = fread(pbFile, 1, cbFile, pf);
+    fclose(pf);
+    g_seen.cbRead += cb;
+
+    cbBom = GetTextFileEncoding(pbFile, cb, &eEncoding);
+    pb = pbFile + cbBom;
+    cb -= cbBom;
+
+    if (eEncoding == ENCODING_UTF16_LE)
+    {
+        size_t i;
+
+        for (i = 0; i + 1 < cb && (pb[i] != CHAR_EOF || pb[i + 1] != 0); i += 2)
+            ;
+        cb = i;
+    }
+    else
+    {
+        unsigned char *pbEof = memchr(pb, CHAR_EOF, cb);
+        if (pbEof != NULL)
+            cb = pbEof - pb;
+    }
+
+    if ((pszText = malloc((cb + 1) * sizeof(WCHAR))) != NULL)
+    {
+        *pcchText = DecodeText(pb, cb, eEncoding, pszText);
+        pszText[*pcchText] = L'\0';
+    }
+
+    free(pbFile);
+    return pszText;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: GetTextFileEncoding                                            *
+ *                                                                          *
+ * Purpose : Get encoding from the byte-order mark; return its length.      *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static size_t GetTextFileEncoding(const unsigned char *pb, size_t cb, ENCODING *peEncoding)
+{
+    if (cb >= 3 && pb[0] == 0xEF && pb[1] == 0xBB && pb[2] == 0xBF)
+    {
+        *peEncoding = ENCODING_UTF8;
+        return 3;
+    }
+
+    if (cb >= 2 && pb[0] == 0xFF && pb[1] == 0xFE)
+    {
+        *peEncoding = ENCODING_UTF16_LE;
+        return 2;
+    }
+
+    *peEncoding = ENCODING_ANSI;
+    return 0;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: DecodeText                                                     *
+ *                                                                          *
+ * Purpose : Decode text as UTF-16; return characters (at most one for      *
+ *           each byte).                                                    *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static size_t DecodeText(const unsigned char *pb, size_t cb, ENCODING eEncoding, PWSTR pwch)
+{
+    const unsigned char *pbEnd = pb + cb;
+    size_t cwch = 0;
+
+    if (eEncoding == ENCODING_UTF16_LE)
+    {
+        for (; pb + 1 < pbEnd; pb += 2)
+            pwch[cwch++] = (WCHAR)(pb[0] | pb[1] << 8);
+    }
+    else if (eEncoding == ENCODING_ANSI)
+    {
+        while (pb < pbEnd)
+            pwch[cwch++] = *pb++;
+    }
+    else while (pb < pbEnd)
+    {
+        uint32_t ch = *pb++;
+        int cbMore = 0;
+
+        if (ch >= 0xF0 && ch < 0xF8) ch &= 0x07, cbMore = 3;
+        else if (ch >= 0xE0) ch &= 0x0F, cbMore = 2;
+        else if (ch >= 0xC0) ch &= 0x1F, cbMore = 1;
+        else if (ch >= 0x80) ch = 0xFFFD;  /* stray continuation byte */
+
+        for (; cbMore > 0 && pb < pbEnd && (*pb & 0xC0) == 0x80; cbMore--)
+            ch = (ch << 6) | (*pb++ & 0x3F);
+        if (cbMore != 0 || ch > 0x10FFFF)
+            ch = 0xFFFD;
+
+        if (ch >= 0x10000)
+        {
+            pwch[cwch++] = (WCHAR)(0xD800 + ((ch - 0x10000) >> 10));
+            pwch[cwch++] = (WCHAR)(0xDC00 + (ch & 0x3FF));
+        }
+        else
+            pwch[cwch++] = (WCHAR)ch;
+    }
+
+    return cwch;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: HashText                                                       *
+ *                                                                          *
+ * Purpose : Add text to the hash of what the reader saw (FNV-1a).          *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static void HashText(PCWSTR pcsz)
+{
+    uint32_t uHash = g_seen.uHash ? g_seen.uHash : 2166136261u;
+
+    for (; *pcsz != L'\0'; pcsz++)
+        uHash = (uHash ^ *pcsz) * 16777619u;
+
+    g_seen.uHash = (uHash ^ 0xFFFF) * 16777619u;  /* end of text */
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: NarrowName                                                     *
+ *                                                                          *
+ * Purpose : Make a file name from a (wide) file name; the name is ASCII.   *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static void NarrowName(char *pszName, PCWSTR pcszFileName)
+{
+    size_t i;
+
+    for (i = 0; pcszFileName[i] != L'\0' && i < CCHMAXNAME - 1; i++)
+        pszName[i] = (char)pcszFileName[i];
+    pszName[i] = '\0';
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Now                                                            *
+ *                                                                          *
+ * Purpose : Return current time, in seconds.                               *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static double Now(void)
+{
+    struct timespec ts;
+
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
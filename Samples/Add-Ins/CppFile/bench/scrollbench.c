@@ -0,0 +1,522 @@
+﻿/****************************************************************************
+ *                                                                          *
+ * File    : scrollbench.c                                                  *
+ *                                                                          *
+ * Purpose : Parse cache benchmark and scroll trace replay tool.            *
+ *                                                                          *
+ *           Replays a scroll trace over a corpus of C++ files, like the    *
+ *           IDE repaints an editor window: every visible line is parsed    *
+ *           again, with the cookie of the line above. Each thread replays  *
+ *           the trace (from its own starting point) through one shared     *
+ *           cache, and then again without the cache; prints nanoseconds    *
+ *           per line for both, the cache counters, and checksums of all    *
+ *           results (which must be the same).                              *
+ *                                                                          *
+ *           A trace is one top line number for each repaint. Without -t,   *
+ *           one is generated; -generate writes one to standard output.     *
+ *                                                                          *
+ *           Only uses the C11 standard library; builds on any host:        *
+ *           cc -O2 scrollbench.c corpus.c ../../Shared/parsecache.c        *
+ *              ../cpplex.c                                                 *
+ *           find /usr/include/c++ -type f | ./scrollbench -threads 4 -     *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <locale.h>
+#include <time.h>
+#include <threads.h>
+#include "../cpplex.h"
+#include "../../Shared/parsecache.h"
+#include "corpus.h"
+
+// Defaults: visible lines, repaints, and cached lines.
+#define C_VIEW      60
+#define C_REPAINTS  20000
+#define C_CACHE     2048
+
+// Most threads.
+#define C_THREADSMAX  64
+
+// Scroll trace.
+typedef struct TRACE {
+    size_t *piTop;          // Top line, for each repaint.
+    size_t cRepaints;       // Number of repaints.
+} TRACE;
+
+// Work for one thread.
+typedef struct REPLAY {
+    const CORPUS *pCorpus;  // Corpus.
+    const USHORT *pusCookies;  // Cookie before each line.
+    const TRACE *pTrace;    // Trace.
+    size_t cView;           // Visible lines.
+    size_t iOffset;         // Added to each top line (wraps).
+    PPARSECACHE pCache;     // Cache, or NULL.
+    uint64_t hash;          // Checksum of all results.
+    uint64_t cLines;        // Lines parsed.
+} REPLAY;
+
+// Static function prototypes.
+static void Usage(void);
+static int ReadTrace(const char *, TRACE *);
+static int MakeTrace(size_t, size_t, size_t, unsigned int, TRACE *);
+static USHORT *ComputeCookies(const CORPUS *);
+static double Run(REPLAY *, int);
+static int ReplayThread(void *);
+static uint64_t HashLine(USHORT, const ADDIN_PARSE_POINT *, int);
+static double Now(void);
+static uint32_t Random(uint32_t *);
+
+/****************************************************************************
+ *                                                                          *
+ * Function: main                                                           *
+ *                                                                          *
+ * Purpose : Main entry point.                                              *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+int main(int argc, char *argv[])
+{
+    static REPLAY aReplay[C_THREADSMAX];
+    CORPUS corpus = {0};
+    TRACE trace = {0};
+    const char *pszTrace = NULL;
+    size_t cView = C_VIEW, cRepaints = C_REPAINTS, cCache = C_CACHE;
+    unsigned int seed = 1;
+    int cThreads = 1, fGenerate = 0;
+    PARSECACHESTATS stats;
+    USHORT *pusCookies;
+    double tCached, tDirect;
+    uint64_t hashCached = 0, hashDirect = 0, cLines = 0;
+    int i;
+
+    // Non-ASCII letters and digits, as far as the C library knows them.
+    setlocale(LC_CTYPE, "");
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-view") == 0 && i + 1 < argc)
+            cView = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-repaints") == 0 && i + 1 < argc)
+            cRepaints = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-cache") == 0 && i + 1 < argc)
+            cCache = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+            cThreads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc)
+            seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+            pszTrace = argv[++i];
+        else if (strcmp(argv[i], "-generate") == 0)
+            fGenerate = 1;
+        else if (strcmp(argv[i], "-") == 0)
+        {
+            char szName[4096];
+
+            // File names from standard input, one on each line.
+            while (fgets(szName, sizeof(szName), stdin) != NULL)
+            {
+                szName[strcspn(szName, "\r\n")] = '\0';
+                if (szName[0] != '\0' && !CorpusAddFile(&corpus, szName))
+                    return 1;
+            }
+        }
+        else if (argv[i][0] == '-')
+        {
+            Usage();
+            return 1;
+        }
+        else if (!CorpusAddFile(&corpus, argv[i]))
+            return 1;
+    }
+
+    if (corpus.cLines == 0 || cView == 0 || cView > corpus.cLines || cRepaints == 0 || cThreads <= 0 || cThreads > C_THREADSMAX)
+    {
+        Usage();
+        return 1;
+    }
+
+    if (pszTrace != NULL ? !ReadTrace(pszTrace, &trace) : !MakeTrace(corpus.cLines, cView, cRepaints, seed, &trace))
+        return 1;
+
+    if (fGenerate)
+    {
+        size_t iRepaint;
+
+        for (iRepaint = 0; iRepaint < trace.cRepaints; iRepaint++)
+            printf("%zu\n", trace.piTop[iRepaint]);
+        return 0;
+    }
+
+    if ((pusCookies = ComputeCookies(&corpus)) == NULL)
+    {
+        fprintf(stderr, "scrollbench: out of memory\n");
+        return 1;
+    }
+
+    for (i = 0; i < cThreads; i++)
+    {
+        aReplay[i].pCorpus = &corpus;
+        aReplay[i].pusCookies = pusCookies;
+        aReplay[i].pTrace = &trace;
+        aReplay[i].cView = cView;
+        aReplay[i].iOffset = (corpus.cLines / cThreads) * i;
+    }
+
+    // Through the cache, then without it.
+    for (i = 0; i < cThreads; i++)
+        aReplay[i].pCache = ParseCacheCreate(CppParseLine, cCache);
+    if (aReplay[0].pCache == NULL)
+    {
+        fprintf(stderr, "scrollbench: out of memory\n");
+        return 1;
+    }
+    for (i = 1; i < cThreads; i++)
+    {
+        ParseCacheDestroy(aReplay[i].pCache);
+        aReplay[i].pCache = aReplay[0].pCache;  /* one shared cache */
+    }
+
+    if ((tCached = Run(aReplay, cThreads)) < 0)
+        return 1;
+    for (i = 0; i < cThreads; i++)
+        hashCached += aReplay[i].hash, cLines += aReplay[i].cLines;
+
+    ParseCacheGetStats(aReplay[0].pCache, &stats);
+    ParseCacheDestroy(aReplay[0].pCache);
+
+    for (i = 0; i < cThreads; i++)
+        aReplay[i].pCache = NULL;
+    if ((tDirect = Run(aReplay, cThreads)) < 0)
+        return 1;
+    for (i = 0; i < cThreads; i++)
+        hashDirect += aReplay[i].hash;
+
+    printf("%zu files, %zu lines; %zu visible lines, %zu repaints, %d thread(s), cache for %zu lines\n\n",
+        corpus.cFiles, corpus.cLines, cView, trace.cRepaints, cThreads, cCache);
+    printf("parser      ns/line  checksum\n");
+    printf("direct   %10.1f  %016llx\n", tDirect * 1e9 / cLines * cThreads, (unsigned long long)hashDirect);
+    printf("cached   %10.1f  %016llx\n", tCached * 1e9 / cLines * cThreads, (unsigned long long)hashCached);
+    printf("\nspeedup  %.2fx\n", tDirect / tCached);
+    printf("\n%llu hits, %llu misses (%llu not kept), hit rate %.1f%%\n",
+        (unsigned long long)stats.cHits, (unsigned long long)stats.cMisses, (unsigned long long)stats.cUncached,
+        100.0 * stats.cHits / (stats.cHits + stats.cMisses));
+
+    if (hashCached != hashDirect)
+    {
+        fprintf(stderr, "scrollbench: checksums differ\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Usage                                                          *
+ *                                                                          *
+ * Purpose : Display usage.                                                 *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static void Usage(void)
+{
+    fprintf(stderr, "Usage: scrollbench [-view n] [-repaints n] [-cache n] [-threads n] [-seed n]\n"
+                    "                   [-t trace | -generate] { file | - } ...\n"
+                    "       - reads file names from standard input\n");
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ReadTrace                                                      *
+ *                                                                          *
+ * Purpose : Read a scroll trace: one top line number for each repaint.     *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int ReadTrace(const char *pszFile, TRACE *pTrace)
+{
+    size_t cMax = 0, iTop;
+    FILE *pf;
+
+    if ((pf = fopen(pszFile, "r")) == NULL)
+    {
+        fprintf(stderr, "scrollbench: can't open '%s'\n", pszFile);
+        return 0;
+    }
+
+    while (fscanf(pf, "%zu", &iTop) == 1)
+    {
+        if (pTrace->cRepaints == cMax)
+        {
+            size_t *piTop = realloc(pTrace->piTop, (cMax = cMax ? cMax * 2 : 4096) * sizeof(size_t));
+            if (piTop == NULL)
+            {
+                fclose(pf);
+                fprintf(stderr, "scrollbench: out of memory\n");
+                return 0;
+            }
+            pTrace->piTop = piTop;
+        }
+        pTrace->piTop[pTrace->cRepaints++] = iTop;
+    }
+    fclose(pf);
+
+    if (pTrace->cRepaints == 0)
+    {
+        fprintf(stderr, "scrollbench: no repaints in '%s'\n", pszFile);
+        return 0;
+    }
+
+    return 1;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: MakeTrace                                                      *
+ *                                                                          *
+ * Purpose : Generate a scroll trace: mostly wheel scrolling (1-3 lines),   *
+ *           some page up/down, and now and then a jump somewhere else.     *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int MakeTrace(size_t cLines, size_t cView, size_t cRepaints, unsigned int seed, TRACE *pTrace)
+{
+    uint32_t uSeed = seed ? seed : 1;
+    size_t iTop = 0, cTopMax = cLines - cView + 1;
+    int iDir = 1;
+
+    if ((pTrace->piTop = malloc(cRepaints * sizeof(size_t))) == NULL)
+    {
+        fprintf(stderr, "scrollbench: out of memory\n");
+        return 0;
+    }
+
+    for (pTrace->cRepaints = 0; pTrace->cRepaints < cRepaints; pTrace->cRepaints++)
+    {
+        uint32_t r = Random(&uSeed) % 100;
+        size_t cMove;
+
+        if (r < 3)
+        {
+            // Jump (search result, go to definition...).
+            iTop = Random(&uSeed) % cTopMax;
+        }
+        else
+        {
+            // Wheel, or page; sometimes change direction.
+            if (r < 15)
+                iDir = -iDir;
+            cMove = (r < 85) ? 1 + Random(&uSeed) % 3 : cView;
+
+            if (iDir < 0)
+                iTop = (iTop > cMove) ? iTop - cMove : 0;
+            else
+                iTop = (iTop + cMove < cTopMax) ? iTop + cMove : cTopMax - 1;
+        }
+
+        pTrace->piTop[pTrace->cRepaints] = iTop;
+    }
+
+    return 1;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ComputeCookies                                                 *
+ *                                                                          *
+ * Purpose : Parse the corpus once, for the cookie before each line (the    *
+ *           IDE remembers these).                                          *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static USHORT *ComputeCookies(const CORPUS *pCorpus)
+{
+    USHORT *pusCookies, usCookie = 0;
+    size_t iLine;
+
+    if ((pusCookies = malloc(pCorpus->cLines * sizeof(USHORT))) == NULL)
+        return NULL;
+
+    for (iLine = 0; iLine < pCorpus->cLines; iLine++)
+    {
+        if (CorpusIsFirstLine(pCorpus, iLine))
+            usCookie = 0;
+
+        pusCookies[iLine] = usCookie;
+        usCookie = CppParseLine(usCookie, &pCorpus->pwch[pCorpus->piLine[iLine]],
+            (int)(pCorpus->piLine[iLine + 1] - pCorpus->piLine[iLine]), NULL, NULL);
+    }
+
+    return pusCookies;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Run                                                            *
+ *                                                                          *
+ * Purpose : Replay the trace on all threads; return seconds, or -1.        *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static double Run(REPLAY *aReplay, int cThreads)
+{
+    thrd_t athrd[C_THREADSMAX];
+    double t0;
+    int i;
+
+    t0 = Now();
+    for (i = 0; i < cThreads; i++)
+    {
+        if (thrd_create(&athrd[i], ReplayThread, &aReplay[i]) != thrd_success)
+        {
+            fprintf(stderr, "scrollbench: can't create thread\n");
+            return -1;
+        }
+    }
+    for (i = 0; i < cThreads; i++)
+        thrd_join(athrd[i], NULL);
+
+    return Now() - t0;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ReplayThread                                                   *
+ *                                                                          *
+ * Purpose : Replay the trace, on one thread.                               *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int ReplayThread(void *pv)
+{
+    REPLAY *pReplay = pv;
+    const CORPUS *pCorpus = pReplay->pCorpus;
+    size_t cTopMax = pCorpus->cLines - pReplay->cView + 1;
+    ADDIN_PARSE_POINT *pPoints;
+    size_t iRepaint;
+
+    if ((pPoints = malloc((pCorpus->cchLongest + 1) * sizeof(ADDIN_PARSE_POINT))) == NULL)
+    {
+        fprintf(stderr, "scrollbench: out of memory\n");
+        exit(1);
+    }
+
+    pReplay->hash = 0;
+    pReplay->cLines = 0;
+    for (iRepaint = 0; iRepaint < pReplay->pTrace->cRepaints; iRepaint++)
+    {
+        size_t iTop = (pReplay->pTrace->piTop[iRepaint] % cTopMax + pReplay->iOffset) % cTopMax;
+        size_t iLine;
+
+        for (iLine = iTop; iLine < iTop + pReplay->cView; iLine++)
+        {
+            PCWSTR pchText = &pCorpus->pwch[pCorpus->piLine[iLine]];
+            int cchText = (int)(pCorpus->piLine[iLine + 1] - pCorpus->piLine[iLine]);
+            int cPoints = 0;
+            USHORT usCookie;
+
+            if (pReplay->pCache != NULL)
+                usCookie = ParseCacheParse(pReplay->pCache, pReplay->pusCookies[iLine], pchText, cchText, pPoints, &cPoints);
+            else
+                usCookie = CppParseLine(pReplay->pusCookies[iLine], pchText, cchText, pPoints, &cPoints);
+
+            // Sum, not chain: the same for any order of threads.
+            pReplay->hash += HashLine(usCookie, pPoints, cPoints);
+        }
+        pReplay->cLines += pReplay->cView;
+    }
+
+    free(pPoints);
+    return 0;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: HashLine                                                       *
+ *                                                                          *
+ * Purpose : Hash cookie and parse points of a line.                        *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static uint64_t HashLine(USHORT usCookie, const ADDIN_PARSE_POINT *pPoints, int cPoints)
+{
+    uint64_t hash = 14695981039346656037ULL;  /* FNV-1a offset basis */
+    int i;
+
+    hash = (hash ^ usCookie) * 1099511628211ULL;
+    for (i = 0; i < cPoints; i++)
+    {
+        hash = (hash ^ pPoints[i].iChar) * 1099511628211ULL;
+        hash = (hash ^ pPoints[i].iColor) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Now                                                            *
+ *                                                                          *
+ * Purpose : Return current time, in seconds.                               *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static double Now(void)
+{
+    struct timespec ts;
+
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Random                                                         *
+ *                                                                          *
+ * Purpose : Return pseudo-random number; same sequence on every host.      *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static uint32_t Random(uint32_t *puSeed)
+{
+    // xorshift32.
+    *puSeed ^= *puSeed << 13;
+    *puSeed ^= *puSeed >> 17;
+    *puSeed ^= *puSeed << 5;
+    return *puSeed;
+}
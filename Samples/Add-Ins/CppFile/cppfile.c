@@ -17,130 +17,21 @@
 #include <shlwapi.h>
 #include <addin.h>
 #include <wchar.h>
-#include <wctype.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "cpplex.h"
+#include "../Shared/parsecache.h"
+#include "depscan.h"
 
-#define CCHMAXLINE  4096
+// Lines kept by the parse cache; a few screens of several files.
+#define C_CACHELINES  4096
 
-#define NELEMS(a)  (sizeof(a) / sizeof(a[0]))
+// Dependency cache file (in the temp folder), and the file written before it's replaced.
+#define DEPCACHE_FILE  L"cppfile.dep"
+#define DEPCACHE_TEMP  L"cppfile.tmp"
 
-// Flags for usCookie.
-#define FLAG_COMMENT       0x01
-#define FLAG_PREPROCESSOR  0x02
-#define FLAG_EXT_COMMENT   0x04
-#define FLAG_STRING        0x08
-#define FLAG_CHAR          0x10
-#define FLAG_UNUSED4       0x20    // Free for any use.
-#define FLAG_UNUSED5       0x40    // Free for any use.
-#define FLAG_UNUSED6       0x80    // Free for any use.
-
-// Minimum and maximum folding level.
-#define MIN_FOLDLEVEL  0
-#define MAX_FOLDLEVEL  255
-
-// Keyword list - must be sorted for IsKeyword().
-static PCWSTR apcszKeywords[] = {
-    L"alignas",  /* C++11 */
-    L"alignof",  /* C++11 */
-    L"and",
-    L"and_eq",
-    L"asm",
-    L"auto",
-    L"bitand",
-    L"bitor",
-    L"bool",
-    L"break",
-    L"case",
-    L"catch",
-    L"char",
-    L"char16_t",  /* C++11 */
-    L"char32_t",  /* C++11 */
-    L"class",
-    L"compl",
-    L"concept",  /* C++20 */
-    L"const",
-    L"constexpr",  /* C++11 */
-    L"const_cast",
-    L"continue",
-    L"decltype",  /* C++11 */
-    L"default",
-    L"delete",
-    L"do",
-    L"double",
-    L"dynamic_cast",
-    L"else",
-    L"enum",
-    L"explicit",
-    L"export",
-    L"extern",
-    L"false",
-    L"float",
-    L"for",
-    L"friend",
-    L"goto",
-    L"if",
-    L"inline",
-    L"int",
-    L"long",
-    L"mutable",
-    L"namespace",
-    L"new",
-    L"noexcept",  /* C++11 */
-    L"not",
-    L"not_eq",
-    L"nullptr",  /* C++11 */
-    L"operator",
-    L"or",
-    L"or_eq",
-    L"private",
-    L"protected",
-    L"public",
-    L"register",
-    L"reinterpret_cast",
-    L"requires",  /* C++20 */
-    L"return",
-    L"short",
-    L"signed",
-    L"sizeof",
-    L"static",
-    L"static_assert",  /* C++11 */
-    L"static_cast",
-    L"struct",
-    L"switch",
-    L"template",
-    L"this",
-    L"thread_local",  /* C++11 */
-    L"throw",
-    L"true",
-    L"try",
-    L"typedef",
-    L"typeid",
-    L"typename",
-    L"union",
-    L"unsigned",
-    L"using",
-    L"virtual",
-    L"void",
-    L"volatile",
-    L"wchar_t",
-    L"while",
-    L"xor",
-    L"xor_eq"
-};
-/* +overide, +final - in some contexts */
-
-// Helper macro for assigning color to column position.
-#define DEFINE_BLOCK(pch,color) \
-    do { \
-        if (pPoints != NULL) { \
-            if (*pcPoints == 0 || (pPoints - 1)->iColor != (color)) { \
-                pPoints->iChar = (UINT)((pch) - pchText); \
-                pPoints->iColor = (color); \
-                pPoints++; \
-                (*pcPoints)++; \
-            } \
-        } \
-    } while (0)
+#define NELEMS(a)  (sizeof(a) / sizeof(a[0]))
 
 // Known Unicode byte-order marks (little endian).
 #define BOM_UTF8      0xBFBBEF
@@ -164,41 +55,26 @@ typedef enum Encodings {
 // Locals.
 static HANDLE g_hmod = NULL;
 static HWND g_hwndMain = NULL;
+static PPARSECACHE g_pCache = NULL;
+static PDEPCACHE g_pDepCache = NULL;
 
 // Function prototypes.
+static USHORT CALLBACK CachedParser(USHORT, PCWSTR, int, ADDIN_PARSE_POINT [], PINT);
 static BOOL CALLBACK EnumProjFileCallback(LPCWSTR, LPVOID);
 static BOOL IsCppFile(PCWSTR);
-static USHORT CALLBACK Parser(USHORT, PCWSTR, int, ADDIN_PARSE_POINT [], PINT);
-static size_t IsKeyword(PCWSTR [], size_t, PCWSTR, size_t);
-static PCWSTR ParseNumber(PCWSTR, PCWSTR);
 static BOOL CALLBACK Scanner(LPCWSTR, BOOL (CALLBACK *)(LPCWSTR, LPCVOID), LPCVOID);
-static BOOL GetInputLine(HANDLE, PWSTR *, ENCODING *);
-static ENCODING ReadTextFileEncoding(HANDLE);
+static BOOL CALLBACK ScanFile(PCWSTR, PDEPSCAN);
+static BOOL CALLBACK GetFileStamp(PCWSTR, uint64_t *);
+static void LoadDepCache(void);
+static void SaveDepCache(void);
+static BOOL GetDepCacheName(PWSTR, PCWSTR);
+static PWSTR ReadTextFile(PCWSTR, size_t *);
+static PWSTR DecodeTextFile(const BYTE *, DWORD, size_t *);
 static DWORD GetTextFileEncoding(DWORD, ENCODING *);
-static BOOL ReadTextFileLine(HANDLE, ENCODING, PWSTR, DWORD);
-static BOOL SeekFile(HANDLE, DWORD, DWORD);
-static DWORD TellFile(HANDLE);
 static PWSTR NoUnixSlash(PWSTR);
-static PWSTR SearchIncludeFile(PCWSTR, PCWSTR);
+static PWSTR CALLBACK SearchIncludeFile(PWSTR, PCWSTR);
 static BOOL IsExistingFile(PCWSTR);
 
-// Inline functions.
-static inline PWSTR SkipWhiteSpace(PWSTR psz)
-{
-    while (*psz == L' ' || *psz == L'\t') ++psz;
-    return psz;
-}
-
-static inline BOOL SeekFile(HANDLE hf, DWORD dwOffset, DWORD method)
-{
-    return SetFilePointer(hf, dwOffset, NULL, FILE_BEGIN) != INVALID_SET_FILE_POINTER;
-}
-
-static inline DWORD TellFile(HANDLE hf)
-{
-    return SetFilePointer(hf, 0, NULL, FILE_CURRENT);
-}
-
 /****************************************************************************
  *                                                                          *
  * Function: DllMain                                                        *
@@ -219,6 +95,10 @@ BOOL WINAPI DllMain(HANDLE hDLL, DWORD dwReason, LPVOID lpReserved)
             return TRUE;
 
         case DLL_PROCESS_DETACH:
+            ParseCacheDestroy(g_pCache);
+            g_pCache = NULL;
+            DepCacheDestroy(g_pDepCache);
+            g_pDepCache = NULL;
             return TRUE;
 
         default:
@@ -249,7 +129,8 @@ ADDINAPI BOOL WINAPI AddInMain(HWND hwnd, ADDIN_EVENT eEvent)
             AddFile.cbSize = sizeof(AddFile);
             AddFile.pszDescription = L"C++ file";
             AddFile.pszExtension = L"cpp";  /* support *.cpp files */
-            AddFile.pfnParser = Parser;  /* syntax color parser */
+            g_pCache = ParseCacheCreate(CppParseLine, C_CACHELINES);
+            AddFile.pfnParser = (g_pCache != NULL) ? CachedParser : CppParseLine;  /* syntax color parser */
             AddFile.pszShells =
                 L"$(CPP) $(CPPFLAGS) \"$!\" -Fo\"$@\"\0";  /* command #1 */
                 L"\0";  /* terminate list of commands */
@@ -257,12 +138,22 @@ ADDINAPI BOOL WINAPI AddInMain(HWND hwnd, ADDIN_EVENT eEvent)
             if (!AddIn_AddFileType(hwnd, &AddFile))
                 return FALSE;
 
+            // Dependencies found by earlier builds.
+            if ((g_pDepCache = DepCacheCreate(TRUE)) != NULL)
+                LoadDepCache();
+
             // Save handle of the main IDE window.
             g_hwndMain = hwnd;
 
             return TRUE;
         }
 
+        case AIE_PRJ_ENDBUILD:
+        case AIE_APP_DESTROY:
+            // Keep the dependencies found for the next build.
+            SaveDepCache();
+            return TRUE;
+
         case AIE_PRJ_SAVE:  /* after significant changes, like adding or deleting project files */
         {
             // AddIn_SetProjectSymbol() will trigger a new AIE_PRJ_SAVE event.
@@ -306,6 +197,22 @@ ADDINAPI BOOL WINAPI AddInMain(HWND hwnd, ADDIN_EVENT eEvent)
     }
 }
 
+/****************************************************************************
+ *                                                                          *
+ * Function: CachedParser                                                   *
+ *                                                                          *
+ * Purpose : Syntax color parser, through the parse cache.                  *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static USHORT CALLBACK CachedParser(USHORT usCookie, PCWSTR pchText, int cchText, ADDIN_PARSE_POINT pPoints[], PINT pcPoints)
+{
+    return ParseCacheParse(g_pCache, usCookie, pchText, cchText, pPoints, pcPoints);
+}
+
 /****************************************************************************
  *                                                                          *
  * Function: EnumProjFileCallback                                           *
@@ -344,8 +251,8 @@ static BOOL CALLBACK EnumProjFileCallback(LPCWSTR pcszName, LPVOID pvData)
 ADDINAPI BOOL WINAPI AddInHelp(HWND hwnd, ADDIN_HELPEVENT eEvent, LPCVOID pcvData)
 {
     // Use AIHE_SRC_KEYWORD_FIRST to avoid getting help for C keywords with the same name.
-    if (eEvent == AIHE_SRC_KEYWORD_FIRST && IsKeyword(apcszKeywords,
-        NELEMS(apcszKeywords), (LPCWSTR)pcvData, wcslen((LPCWSTR)pcvData)) != 0)
+    if (eEvent == AIHE_SRC_KEYWORD_FIRST && CppIsKeyword((LPCWSTR)pcvData,
+        wcslen((LPCWSTR)pcvData)) != 0)
     {
         HWND hwndDoc = AddIn_GetActiveDocument(g_hwndMain);
         if (hwndDoc)
@@ -391,623 +298,329 @@ static BOOL IsCppFile(PCWSTR pcszFileName)
 
 /****************************************************************************
  *                                                                          *
- * Function: Parser                                                         *
+ * Function: Scanner                                                        *
  *                                                                          *
- * Purpose : Parse C++ source code - for syntax color highlighting.         *
+ * Purpose : Scan a C++ file for dependencies.                              *
  *                                                                          *
  * History : Date      Reason                                               *
  *           00/00/00  Created                                              *
  *                                                                          *
  ****************************************************************************/
 
-static USHORT CALLBACK Parser(USHORT usCookie, PCWSTR pchText, int cchText, ADDIN_PARSE_POINT pPoints[], PINT pcPoints)
+static BOOL CALLBACK Scanner(LPCWSTR pcszFileName, BOOL (CALLBACK *pfnAddDepFile)(LPCWSTR pcszDepFileName, LPCVOID pvCookie), LPCVOID pvCookie)
 {
-    PCWSTR pch = pchText, pchEnd = &pchText[cchText];
-    BYTE cFoldLevel = ADDIN_GET_COOKIE_LEVEL(usCookie);
-    BYTE bFlags = ADDIN_GET_COOKIE_FLAGS(usCookie);
-
-    if (pch == pchEnd)
-        ;
-    // Inside comment or extended comment.
-    else if (bFlags & (FLAG_COMMENT|FLAG_EXT_COMMENT))
-    {
-        DEFINE_BLOCK(pch, ADDIN_COLOR_COMMENT);
-    }
-    // Inside string or char constant.
-    else if (bFlags & (FLAG_CHAR|FLAG_STRING))
-    {
-        DEFINE_BLOCK(pch, ADDIN_COLOR_STRING);
-    }
-    // Inside preprocessor directive.
-    else if (bFlags & FLAG_PREPROCESSOR)
-    {
-        DEFINE_BLOCK(pch, ADDIN_COLOR_PREPROCESSOR);
-    }
-    else /* normal state */
-    {
-        while (pch < pchEnd && (*pch == L' ' || *pch == L'\t'))
-            pch++;
+    static const DEPSCANHOST Host = {
+        .pfnScanFile = ScanFile,
+        .pfnSearchInclude = SearchIncludeFile,
+        .pfnGetStamp = GetFileStamp,
+        .fIgnoreCase = TRUE,  /* file names are not case sensitive */
+    };
+
+    return DepScan(pcszFileName, &Host, g_pDepCache, pfnAddDepFile, pvCookie);
+}
 
-        // Check for preprocessor directive: #...
-        if (pch < pchEnd && *pch == L'#')
-        {
-            DEFINE_BLOCK(pch, ADDIN_COLOR_PREPROCESSOR);
-            bFlags |= FLAG_PREPROCESSOR;
-
-            pch++;
-            while (pch < pchEnd && (*pch == L' ' || *pch == L'\t'))
-                pch++;
-
-            // Check for #if, #ifdef, #ifndef block.
-            if (&pch[1] < pchEnd &&
-                pch[0] == L'i' &&
-                pch[1] == L'f' &&
-                cFoldLevel < MAX_FOLDLEVEL)
-            {
-                cFoldLevel++;
-            }
-            else if (&pch[4] < pchEnd &&
-                pch[0] == L'e' &&
-                pch[1] == L'n' &&
-                pch[2] == L'd' &&
-                pch[3] == L'i' &&
-                pch[4] == L'f' &&
-                cFoldLevel > MIN_FOLDLEVEL)
-            {
-                cFoldLevel--;
-            }
-        }
-    }
+/****************************************************************************
+ *                                                                          *
+ * Function: ScanFile                                                       *
+ *                                                                          *
+ * Purpose : Read a whole C++ file, decoded, and hand it to the dependency  *
+ *           scanner one line at a time.                                    *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
 
-    while (pch < pchEnd)
-    {
-        // Inside string constant: "...."
-        if (bFlags & FLAG_STRING)
-        {
-            // Check for escape sequence.
-            if (*pch == L'\\')
-                pch++;
-            // Check for end of string constant.
-            else if (*pch == L'\"')
-                bFlags &= ~FLAG_STRING;
-            pch++;
-            continue;
-        }
+static BOOL CALLBACK ScanFile(PCWSTR pcszFileName, PDEPSCAN pScan)
+{
+    PWSTR pszText, pszEnd, psz;
+    size_t cchText;
+    BOOL fOK = TRUE;
 
-        // Inside char constant: '.'
-        if (bFlags & FLAG_CHAR)
-        {
-            // Check for escape sequence.
-            if (*pch == L'\\')
-                pch++;
-            // Check for end of char constant.
-            else if (*pch == L'\'')
-                bFlags &= ~FLAG_CHAR;
-            pch++;
-            continue;
-        }
+    // Read the whole file, decoded.
+    if ((pszText = ReadTextFile(pcszFileName, &cchText)) == NULL)
+        return FALSE;
 
-        // Inside single line comment: //....
-        if (bFlags & FLAG_COMMENT)
-            break;  /* done! */
+    // Scan it, line-by-line; lines end with \r\n, \n or \r.
+    for (psz = pszText, pszEnd = pszText + cchText; fOK && psz < pszEnd; )
+    {
+        PWSTR pszLine = psz;
 
-        // Inside extended comment: /*....*/
-        if (bFlags & FLAG_EXT_COMMENT)
-        {
-            // Check for end of extended comment...
-            if (*pch == L'*' && &pch[1] < pchEnd && pch[1] == L'/')
-            {
-                bFlags &= ~FLAG_EXT_COMMENT;
-                pch++;
+        while (psz < pszEnd && *psz != L'\r' && *psz != L'\n')
+            psz++;
 
-                // Can fold extended comments.
-                if (cFoldLevel > MIN_FOLDLEVEL) cFoldLevel--;
-            }
-            pch++;
-            continue;
-        }
+        // Terminate the line; the text itself is terminated, too.
+        if (*psz == L'\r' && psz[1] == L'\n')
+            *psz++ = L'\0';
+        *psz++ = L'\0';
 
-        // Inside preprocessor directive: #...
-        if (bFlags & FLAG_PREPROCESSOR)
-        {
-            // Check for string constant: "...."
-            if (*pch == L'\"')
-            {
-                bFlags |= FLAG_STRING;
-            }
-            // Check for char constant: '.'
-            else if (*pch == L'\'')
-            {
-                bFlags |= FLAG_CHAR;
-            }
-            // Check for single line comment: //
-            else if (*pch == L'/' && &pch[1] < pchEnd && pch[1] == L'/')
-            {
-                DEFINE_BLOCK(pch, ADDIN_COLOR_COMMENT);
-                bFlags |= FLAG_COMMENT;
-                pch++;
-            }
-            // Check for extended comment: /*....*/
-            else if (*pch == L'/' && &pch[1] < pchEnd && pch[1] == L'*')
-            {
-                DEFINE_BLOCK(pch, ADDIN_COLOR_COMMENT);
-                bFlags |= FLAG_EXT_COMMENT;
-                pch++;
+        fOK = DepScanLine(pScan, pszLine);
+    }
 
-                // Can fold extended comments.
-                if (cFoldLevel < MAX_FOLDLEVEL) cFoldLevel++;
-            }
-            else
-            {
-                // Default case.
-                DEFINE_BLOCK(pch, ADDIN_COLOR_PREPROCESSOR);
-            }
-            pch++;
-            continue;
-        }
+    free(pszText);
+    return fOK;
+}
 
-        // Update curly brace level.
-        if (*pch == L'{' && cFoldLevel < MAX_FOLDLEVEL)
-            cFoldLevel++;
-        else if (*pch == L'}' && cFoldLevel > MIN_FOLDLEVEL)
-            cFoldLevel--;
+/****************************************************************************
+ *                                                                          *
+ * Function: GetFileStamp                                                   *
+ *                                                                          *
+ * Purpose : Get stamp of a file (last write time), for the cache.          *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
 
-        // Check for single line comment: //
-        if (*pch == L'/' && &pch[1] < pchEnd && pch[1] == L'/')
-        {
-            DEFINE_BLOCK(pch, ADDIN_COLOR_COMMENT);
-            bFlags |= FLAG_COMMENT;
-            break;  /* done! */
-        }
+static BOOL CALLBACK GetFileStamp(PCWSTR pcszFileName, uint64_t *pStamp)
+{
+    WIN32_FILE_ATTRIBUTE_DATA fad;
 
-        // Check for extended comment: /*....*/
-        if (*pch == L'/' && &pch[1] < pchEnd && pch[1] == L'*')
-        {
-            DEFINE_BLOCK(pch, ADDIN_COLOR_COMMENT);
-            bFlags |= FLAG_EXT_COMMENT;
-            pch += 2;
+    if (!GetFileAttributesEx(pcszFileName, GetFileExInfoStandard, &fad))
+        return FALSE;
 
-            // Can fold extended comments.
-            if (cFoldLevel < MAX_FOLDLEVEL) cFoldLevel++;
-            continue;
-        }
+    *pStamp = (uint64_t)fad.ftLastWriteTime.dwHighDateTime << 32 | fad.ftLastWriteTime.dwLowDateTime;
+    return TRUE;
+}
 
-        // Check for string constant: "...."
-        if (*pch == L'\"')
-        {
-            DEFINE_BLOCK(pch, ADDIN_COLOR_STRING);
-            bFlags |= FLAG_STRING;
-            pch++;
-            continue;
-        }
+/****************************************************************************
+ *                                                                          *
+ * Function: LoadDepCache                                                   *
+ *                                                                          *
+ * Purpose : Load the dependency cache from its file (mapped, not read).    *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
 
-        // Check for char constant: '.'
-        if (*pch == L'\'')
-        {
-            DEFINE_BLOCK(pch, ADDIN_COLOR_STRING);
-            bFlags |= FLAG_CHAR;
-            pch++;
-            continue;
-        }
+static void LoadDepCache(void)
+{
+    WCHAR szFileName[MAX_PATH];
+    LARGE_INTEGER liSize;
+    HANDLE hf, hmap;
+    LPVOID pvImage;
 
-        // Check for operator.
-        if (&pch[2] < pchEnd && (
-            (pch[0] == L'<' && pch[1] == L'<' && pch[2] == L'=') ||  /* <<= */
-            (pch[0] == L'>' && pch[1] == L'>' && pch[2] == L'=') ||  /* >>= */
-            (pch[0] == L'.' && pch[1] == L'.' && pch[2] == L'.') ||  /* ... */
-            (pch[0] == L'-' && pch[1] == L'>' && pch[2] == L'*') ||  /* ->* */
-            (pch[0] == L'<' && pch[1] == L'=' && pch[2] == L'>')))   /* <=> */
-        {
-            DEFINE_BLOCK(pch, ADDIN_COLOR_OPERATOR);
-            pch += 3;
-            continue;
-        }
-        else if (&pch[1] < pchEnd && (
-            (pch[0] == L'+' && pch[1] == L'+') ||  /* ++ */
-            (pch[0] == L'-' && pch[1] == L'-') ||  /* -- */
-            (pch[0] == L'-' && pch[1] == L'>') ||  /* -> */
-            (pch[0] == L'<' && pch[1] == L'<') ||  /* << */
-            (pch[0] == L'>' && pch[1] == L'>') ||  /* >> */
-            (pch[0] == L'<' && pch[1] == L'=') ||  /* <= */
-            (pch[0] == L'>' && pch[1] == L'=') ||  /* >= */
-            (pch[0] == L'=' && pch[1] == L'=') ||  /* == */
-            (pch[0] == L'!' && pch[1] == L'=') ||  /* != */
-            (pch[0] == L'&' && pch[1] == L'&') ||  /* && */
-            (pch[0] == L'|' && pch[1] == L'|') ||  /* || */
-            (pch[0] == L'*' && pch[1] == L'=') ||  /* *= */
-            (pch[0] == L'/' && pch[1] == L'=') ||  /* /= */
-            (pch[0] == L'%' && pch[1] == L'=') ||  /* %= */
-            (pch[0] == L'+' && pch[1] == L'=') ||  /* += */
-            (pch[0] == L'-' && pch[1] == L'=') ||  /* -= */
-            (pch[0] == L'&' && pch[1] == L'=') ||  /* &= */
-            (pch[0] == L'^' && pch[1] == L'=') ||  /* ^= */
-            (pch[0] == L'|' && pch[1] == L'=') ||  /* |= */
-            (pch[0] == L'.' && pch[1] == L'*') ||  /* .* */
-            (pch[0] == L':' && pch[1] == L':')))   /* :: */
-        {
-            DEFINE_BLOCK(pch, ADDIN_COLOR_OPERATOR);
-            pch += 2;
-            continue;
-        }
-        else if (
-            *pch == L',' ||
-            *pch == L'*' ||  /* indirection or multiply */
-            *pch == L'(' ||
-            *pch == L')' ||
-            *pch == L'{' ||
-            *pch == L'}' ||
-            *pch == L'[' ||
-            *pch == L']' ||
-            *pch == L'=' ||
-            *pch == L'&' ||  /* address of, or bitwise and */
-            *pch == L'!' ||
-            *pch == L'+' ||
-            *pch == L'-' ||
-            *pch == L'.' ||
-            *pch == L'<' ||
-            *pch == L'>' ||
-            *pch == L'/' ||
-            *pch == L'%' ||
-            *pch == L'^' ||
-            *pch == L'|' ||
-            *pch == L'?' ||  /* ?: */
-            *pch == L':' ||  /* ?: or bitfield */
-            *pch == L'~')
-        {
-            DEFINE_BLOCK(pch, ADDIN_COLOR_OPERATOR);
-            pch++;
-            continue;
-        }
+    if (!GetDepCacheName(szFileName, DEPCACHE_FILE))
+        return;
 
-        // Check for number.
-        if (iswdigit(*pch))
-        {
-            DEFINE_BLOCK(pch, ADDIN_COLOR_NUMBER);
-            pch = ParseNumber(pch, pchEnd);
-            continue;
-        }
+    // No file the first time.
+    hf = CreateFile(szFileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, 0);
+    if (hf == INVALID_HANDLE_VALUE)
+        return;
 
-        // Check for identifier.
-        if (*pch == L'_' || IsCharAlphaW(*pch))
+    // A bad file is ignored; it's replaced after the next build.
+    if (GetFileSizeEx(hf, &liSize) && liSize.QuadPart > 0 && (ULONGLONG)liSize.QuadPart <= SIZE_MAX &&
+        (hmap = CreateFileMapping(hf, NULL, PAGE_READONLY, 0, 0, NULL)) != NULL)
+    {
+        if ((pvImage = MapViewOfFile(hmap, FILE_MAP_READ, 0, 0, 0)) != NULL)
         {
-            PCWSTR pchIdent = pch;
-            do
-                pch++;
-            while (pch < pchEnd && (*pch == L'_' || IsCharAlphaNumericW(*pch)));
-
-            if (IsKeyword(apcszKeywords, NELEMS(apcszKeywords), pchIdent, pch - pchIdent))
+            __try
             {
-                DEFINE_BLOCK(pchIdent, ADDIN_COLOR_KEYWORD);
+                (void)DepCacheLoad(g_pDepCache, pvImage, (size_t)liSize.QuadPart);
             }
-            else
+            __except (GetExceptionCode() == EXCEPTION_IN_PAGE_ERROR ? EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH)
             {
-                DEFINE_BLOCK(pchIdent, ADDIN_COLOR_TEXT);
+                // The file went away (network drive?). The cache may be half loaded,
+                // and still locked; nothing uses it yet, so start over with a new one.
+                DepCacheDestroy(g_pDepCache);
+                g_pDepCache = DepCacheCreate(TRUE);
             }
-            continue;
+            UnmapViewOfFile(pvImage);
         }
-
-        // Default case.
-        DEFINE_BLOCK(pch, ADDIN_COLOR_TEXT);
-        pch++;
-
-        // Skip useless white-space.
-        while (pch < pchEnd && (*pch == L' ' || *pch == L'\t'))
-            pch++;
+        CloseHandle(hmap);
     }
 
-    // If no line continuation ('\'), clear *most* flags for next line.
-    if (cchText < 2 || pchText[cchText-1] != L'\n' || pchText[cchText-2] != L'\\')
-        bFlags &= FLAG_EXT_COMMENT;
-
-    return ADDIN_MAKE_COOKIE(bFlags, cFoldLevel);
+    CloseHandle(hf);
 }
 
 /****************************************************************************
  *                                                                          *
- * Function: IsKeyword                                                      *
+ * Function: SaveDepCache                                                   *
  *                                                                          *
- * Purpose : Return non-zero index, if the given string is a keyword.       *
+ * Purpose : Save the dependency cache to its file, if it changed.          *
  *                                                                          *
  * History : Date      Reason                                               *
  *           00/00/00  Created                                              *
  *                                                                          *
  ****************************************************************************/
 
-static size_t IsKeyword(PCWSTR apcszKeywords[], size_t cKeywords, PCWSTR pchText, size_t cchText)
+static void SaveDepCache(void)
 {
-    PCWSTR *ppcszKeywords = apcszKeywords;
+    WCHAR szFileName[MAX_PATH];
+    WCHAR szTempName[MAX_PATH];
+    LPVOID pvImage;
+    size_t cbImage;
+    DWORD cbWritten;
+    HANDLE hf;
+    BOOL fOK;
+
+    if (g_pDepCache == NULL || !DepCacheIsDirty(g_pDepCache) ||
+        !GetDepCacheName(szFileName, DEPCACHE_FILE) || !GetDepCacheName(szTempName, DEPCACHE_TEMP))
+        return;
+
+    if ((pvImage = DepCacheSave(g_pDepCache, &cbImage)) == NULL)
+        return;
 
-    while (cKeywords > 0)
+    // Write a new file, then replace the old one; a build running in another IDE never maps half a file.
+    hf = CreateFile(szTempName, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+    if (hf != INVALID_HANDLE_VALUE)
     {
-        size_t pivot = cKeywords >> 1;
-        int cond = wcsncmp(ppcszKeywords[pivot], pchText, cchText);
-        if (cond > 0)
-        {
-            // Search below pivot.
-            cKeywords = pivot;
-            continue;
-        }
-        else if (cond < 0)
-        {
-            // Search above pivot.
-            ppcszKeywords += pivot + 1;
-            cKeywords -= pivot + 1;
-            continue;
-        }
-        else
-        {
-            // Got a match, but is it exact?
-            if (ppcszKeywords[pivot][cchText] == L'\0')
-                return 1 + (ppcszKeywords - apcszKeywords) + pivot;
+        fOK = cbImage <= MAXDWORD && WriteFile(hf, pvImage, (DWORD)cbImage, &cbWritten, NULL) && cbWritten == cbImage;
+        CloseHandle(hf);
 
-            // Search below pivot (for a shorter keyword).
-            cKeywords = pivot;
-            continue;
-        }
+        if (!fOK || !MoveFileEx(szTempName, szFileName, MOVEFILE_REPLACE_EXISTING))
+            DeleteFile(szTempName);
     }
-    return 0;
+
+    free(pvImage);
 }
 
 /****************************************************************************
  *                                                                          *
- * Function: ParseNumber                                                    *
+ * Function: GetDepCacheName                                                *
  *                                                                          *
- * Purpose : Parse a numeric value.                                         *
+ * Purpose : Get name of a dependency cache file, in the temp folder.       *
  *                                                                          *
  * History : Date      Reason                                               *
  *           00/00/00  Created                                              *
  *                                                                          *
  ****************************************************************************/
 
-static PCWSTR ParseNumber(PCWSTR pch, PCWSTR pchEnd)
+static BOOL GetDepCacheName(PWSTR pszFileName, PCWSTR pcszName)
 {
-    BOOL fFloat = FALSE;
-
-    // Parse hexadecimal number.
-    if (pch[0] == L'0' && &pch[1] < pchEnd && (pch[1] == L'x' || pch[1] == L'X'))
-    {
-        pch += 2;
-
-        while (pch < pchEnd && iswxdigit(*pch))
-            pch++;
-    }
-    // Parse binary number (C++14).
-    if (pch[0] == L'0' && &pch[1] < pchEnd && (pch[1] == L'b' || pch[1] == L'B'))
-    {
-        pch += 2;
-
-        while (pch < pchEnd && (*pch == L'0' || *pch == L'1'))
-            pch++;
-    }
-    // Parse decimal number.
-    else
-    {
-        pch++;
-
-        while (pch < pchEnd && iswdigit(*pch))
-            pch++;
+    DWORD cch = GetTempPath(MAX_PATH, pszFileName);
 
-        if (pch < pchEnd && *pch == L'.')
-        {
-            pch++;
-
-            while (pch < pchEnd && iswdigit(*pch))
-                pch++;
-
-            fFloat = TRUE;
-        }
-
-        if (pch < pchEnd && (*pch == L'e' || *pch == L'E'))
-        {
-            pch++;
-
-            if (pch < pchEnd && (*pch == L'-' || *pch == L'+'))
-                pch++;
-
-            while (pch < pchEnd && iswdigit(*pch))
-                pch++;
-
-            fFloat = TRUE;
-        }
-    }
-
-    // Parse suffix.
-    if (fFloat)
-    {
-        if (pch < pchEnd && (*pch == L'f' || *pch == L'F' || *pch == L'l' || *pch == L'L'))
-            pch++;
-    }
-    else
-    {
-        /* 'ULL' */
-        if (&pch[2] < pchEnd && (pch[0] == L'u' || pch[0] == L'U') && (pch[1] == L'l' || pch[1] == L'L') && (pch[2] == L'l' || pch[2] == L'L'))
-            pch += 3;
-        /* 'LLU' */
-        else if (&pch[2] < pchEnd && (pch[0] == L'l' || pch[0] == L'L') && (pch[1] == L'l' || pch[1] == L'L') && (pch[2] == L'u' || pch[2] == L'U'))
-            pch += 3;
-        /* 'LL' */
-        else if (&pch[1] < pchEnd && (pch[0] == L'l' || pch[0] == L'L') && (pch[1] == L'l' || pch[1] == L'L'))
-            pch += 2;
-        /* 'UL' */
-        else if (&pch[1] < pchEnd && (pch[0] == L'u' || pch[0] == L'U') && (pch[1] == L'l' || pch[1] == L'L'))
-            pch += 2;
-        /* 'LU' */
-        else if (&pch[1] < pchEnd && (pch[0] == L'l' || pch[0] == L'L') && (pch[1] == L'u' || pch[1] == L'U'))
-            pch += 2;
-        /* 'U' */
-        else if (pch < pchEnd && (*pch == L'u' || *pch == L'U'))
-            pch++;
-        /* 'L' */
-        else if (pch < pchEnd && (*pch == L'l' || *pch == L'L'))
-            pch++;
-    }
+    if (cch == 0 || cch + lstrlen(pcszName) >= MAX_PATH)
+        return FALSE;
 
-    return pch;
+    lstrcpy(pszFileName + cch, pcszName);
+    return TRUE;
 }
 
 /****************************************************************************
  *                                                                          *
- * Function: Scanner                                                        *
+ * Function: ReadTextFile                                                   *
  *                                                                          *
- * Purpose : Scan a C++ file for dependencies.                              *
+ * Purpose : Read a whole text file into a buffer (malloc'ed), as UTF-16.   *
  *                                                                          *
  * History : Date      Reason                                               *
  *           00/00/00  Created                                              *
  *                                                                          *
  ****************************************************************************/
 
-#define INCLUDESTRING  L"include"
-
-static BOOL CALLBACK Scanner(LPCWSTR pcszFileName, BOOL (CALLBACK *pfnAddDepFile)(LPCWSTR pcszDepFileName, LPCVOID pvCookie), LPCVOID pvCookie)
+static PWSTR ReadTextFile(PCWSTR pcszFileName, size_t *pcchText)
 {
-    HANDLE hf;
-    PWSTR pszInput;
-    BOOL fComment = FALSE;
-    ENCODING eEncoding;
-    BOOL fOK = TRUE;
+    LARGE_INTEGER liSize;
+    PWSTR pszText = NULL;
+    HANDLE hf, hmap;
+    PVOID pvView;
 
     // Open the file.
     hf = CreateFile(pcszFileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, 0);
     if (hf == INVALID_HANDLE_VALUE)
-        return FALSE;
+        return NULL;
 
-    // Read the file, line-by-line.
-    for (pszInput = NULL; fOK && GetInputLine(hf, &pszInput, &eEncoding); )
+    // Map it, and decode it in one go (an empty file can't be mapped).
+    if (GetFileSizeEx(hf, &liSize) && liSize.QuadPart < INT_MAX)
     {
-        PWSTR psz = pszInput;
-
-restart:
-        if (fComment)
-        {
-            // In traditional comment, check for terminator.
-            while (*psz != L'\0' && (*psz != L'*' || psz[1] != L'/'))
-                psz++;
-
-            if (*psz == L'\0')
-                continue;
-
-            psz += 2;
-            fComment = FALSE;
-        }
-
-        psz = SkipWhiteSpace(psz);
-
-        // Check for traditional comment.
-        if (psz[0] == L'/' && psz[1] == L'*')
+        if (liSize.QuadPart == 0)
         {
-            psz += 2;
-            fComment = TRUE;
-            goto restart;
+            if ((pszText = malloc(sizeof(WCHAR))) != NULL)
+            {
+                *pszText = L'\0';
+                *pcchText = 0;
+            }
         }
-
-        // Parse preprocessor lines.
-        if (*psz++ == L'#')
+        else if ((hmap = CreateFileMapping(hf, NULL, PAGE_READONLY, 0, 0, NULL)) != NULL)
         {
-            psz = SkipWhiteSpace(psz);
-
-            // Look for #include preprocessor line.
-            if (wcsncmp(psz, INCLUDESTRING, wcslen(INCLUDESTRING)) == 0)
+            if ((pvView = MapViewOfFile(hmap, FILE_MAP_READ, 0, 0, 0)) != NULL)
             {
-                psz += wcslen(INCLUDESTRING);
-
-                psz = SkipWhiteSpace(psz);
-
-                if (*psz++ == L'"')  /* ignore "standard places" (#include <name>) */
-                {
-                    PWSTR pszName;
-
-                    // Scan for end of "name".
-                    for (pszName = psz; *psz != L'\0' && *psz != L'"'; psz++)
-                        ;
-
-                    if (*psz == L'"')
-                    {
-                        PWSTR pszDepFileName;
-
-                        // Insert sneaky terminator.
-                        *psz = L'\0';
-
-                        // Search for the included file.
-                        pszDepFileName = SearchIncludeFile(NoUnixSlash(pszName), pcszFileName);
-                        if (pszDepFileName != NULL)
-                        {
-                            // Found included file: add as new dependency... */
-                            if (!pfnAddDepFile(pszDepFileName, pvCookie))
-                                fOK = FALSE;
-                            // ...and then recurse, to scan the new file.
-                            else if (!Scanner(pszDepFileName, pfnAddDepFile, pvCookie))
-                                fOK = FALSE;
-                        }
-
-                        // Clean up.
-                        free(pszDepFileName);
-                    }
-                }
+                pszText = DecodeTextFile(pvView, (DWORD)liSize.QuadPart, pcchText);
+                UnmapViewOfFile(pvView);
             }
+            CloseHandle(hmap);
         }
     }
 
-    free(pszInput);
     CloseHandle(hf);
-
-    return fOK;
+    return pszText;
 }
 
-#undef INCLUDESTRING
-
 /****************************************************************************
  *                                                                          *
- * Function: GetInputLine                                                   *
+ * Function: DecodeTextFile                                                 *
  *                                                                          *
- * Purpose : Read a line of text into a dynamically allocated buffer.       *
+ * Purpose : Decode the text of a file (after the byte-order mark, up to    *
+ *           CTRL+Z) into a buffer (malloc'ed), as UTF-16.                  *
  *                                                                          *
  * History : Date      Reason                                               *
  *           00/00/00  Created                                              *
  *                                                                          *
  ****************************************************************************/
 
-static BOOL GetInputLine(HANDLE hf, PWSTR *ppszInput, ENCODING *peEncoding)
+static PWSTR DecodeTextFile(const BYTE *pbFile, DWORD cbFile, size_t *pcchText)
 {
-    // First call for this file?
-    if (!*ppszInput)
-    {
-        // Allocate a line buffer.
-        *ppszInput = malloc(CCHMAXLINE * sizeof(WCHAR));
-        if (!*ppszInput) return FALSE;
+    PWSTR pszText = NULL;
+    ENCODING eEncoding;
+    DWORD bom = 0;
+    DWORD cbBom;
+    int cch = 0;
 
+    __try
+    {
         // Determine the file encoding.
-        *peEncoding = ReadTextFileEncoding(hf);
-    }
+        memcpy(&bom, pbFile, min(cbFile, sizeof(bom)));
+        cbBom = GetTextFileEncoding(bom, &eEncoding);
+        pbFile += cbBom;
+        cbFile -= cbBom;
 
-    // Fill the line buffer.
-    return ReadTextFileLine(hf, *peEncoding, *ppszInput, CCHMAXLINE);
-}
+        // Handle UTF-16LE encoding (the view is page aligned).
+        if (eEncoding == ENCODING_UTF16_LE)
+        {
+            const WCHAR *pwch = (const WCHAR *)pbFile;
+            int cwch = (int)(cbFile / sizeof(WCHAR));
 
-/****************************************************************************
- *                                                                          *
- * Function: ReadTextFileEncoding                                           *
- *                                                                          *
- * Purpose : Check for byte-order mark at the beginning of the file.        *
- *                                                                          *
- * History : Date      Reason                                               *
- *           00/00/00  Created                                              *
- *                                                                          *
- ****************************************************************************/
+            while (cch < cwch && pwch[cch] != CHAR_EOF)
+                cch++;
 
-static ENCODING ReadTextFileEncoding(HANDLE hf)
-{
-    ENCODING eEncoding;
-    DWORD bom;
-    DWORD cbBom;
+            if ((pszText = malloc((cch + 1) * sizeof(WCHAR))) == NULL)
+                return NULL;
+
+            memcpy(pszText, pwch, cch * sizeof(WCHAR));
+        }
+        // Handle plain text, and UTF-8 encoding.
+        else
+        {
+            UINT uCodePage = (eEncoding == ENCODING_UTF8) ? CP_UTF8 : CP_ACP;
+            const BYTE *pbEof;
+
+            if ((pbEof = memchr(pbFile, CHAR_EOF, cbFile)) != NULL)
+                cbFile = (DWORD)(pbEof - pbFile);
 
-    bom = 0;
-    if (!ReadFile(hf, &bom, sizeof(bom), &cbBom, NULL))
-        return ENCODING_UNKNOWN;
+            if (cbFile != 0 && (cch = MultiByteToWideChar(uCodePage, 0, (PCSTR)pbFile, (int)cbFile, NULL, 0)) == 0)
+                return NULL;
 
-    if (SetFilePointer(hf, GetTextFileEncoding(bom, &eEncoding), NULL, FILE_BEGIN) == INVALID_SET_FILE_POINTER)
-        return ENCODING_UNKNOWN;
+            if ((pszText = malloc((cch + 1) * sizeof(WCHAR))) == NULL)
+                return NULL;
 
-    return eEncoding;
+            if (cch != 0 && MultiByteToWideChar(uCodePage, 0, (PCSTR)pbFile, (int)cbFile, pszText, cch) != cch)
+            {
+                free(pszText);
+                return NULL;
+            }
+        }
+    }
+    __except (GetExceptionCode() == EXCEPTION_IN_PAGE_ERROR ? EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH)
+    {
+        // The file went away (network drive?).
+        free(pszText);
+        return NULL;
+    }
+
+    pszText[cch] = L'\0';
+    *pcchText = cch;
+    return pszText;
 }
 
 /****************************************************************************
@@ -1046,158 +659,6 @@ static DWORD GetTextFileEncoding(DWORD bom, ENCODING *peEncoding)
 
 #undef BYTEMASK
 
-/****************************************************************************
- *                                                                          *
- * Function: ReadTextFileLine                                               *
- *                                                                          *
- * Purpose : Read a line from a text file using given encoding.             *
- *                                                                          *
- * History : Date      Reason                                               *
- *           00/00/00  Created                                              *
- *                                                                          *
- ****************************************************************************/
-
-#define RAWBUFSIZE  8192
-
-static BOOL ReadTextFileLine(HANDLE hf, ENCODING eEncoding, PWSTR pchBuf, DWORD cchBufMax)
-{
-    /* Remember the current file position */
-    DWORD dwCurrentOffset = TellFile(hf);
-    DWORD cbRead;
-    PVOID pvRaw;
-
-    if (cchBufMax == 0)
-        return FALSE;
-
-    // Allocate a work buffer.
-    if ((pvRaw = malloc(RAWBUFSIZE)) == NULL)
-        return FALSE;
-
-    __try
-    {
-        // Read a chunk from the file.
-        if (!ReadFile(hf, pvRaw, RAWBUFSIZE, &cbRead, NULL))
-            return FALSE;
-
-        if (cbRead == 0)
-            return FALSE;
-
-        // Check for CTRL+Z from last read.
-        if (*((PCHAR)pvRaw) == CHAR_EOF)
-            return FALSE;
-
-        // Handle UTF-16LE encoding.
-        if (eEncoding == ENCODING_UTF16_LE)
-        {
-#define pwchRaw  ((PWCHAR)pvRaw)
-            PWSTR pwch, pwchEnd;
-
-            for (pwch = pwchRaw, pwchEnd = pwchRaw + cbRead/sizeof(WCHAR); pwch < pwchEnd; pwch++)
-            {
-                if (*pwch == L'\r' || *pwch == L'\n' || *pwch == CHAR_EOF)
-                    break;
-
-                if (--cchBufMax == 0)
-                    return FALSE;
-
-                *pchBuf++ = *pwch;
-            }
-            *pchBuf = L'\0';
-
-            if (pwch == pwchEnd && cbRead == RAWBUFSIZE)
-                return FALSE;
-
-            if (pwch == pwchEnd)
-                ;
-            else if (*pwch == L'\n')
-                ++pwch;
-            else if (*pwch == L'\r' && *++pwch == L'\n')
-                ++pwch;
-
-            // Start from the correct file position next time.
-            return SeekFile(hf, dwCurrentOffset + (DWORD)((pwch - pwchRaw) * sizeof(WCHAR)), FILE_BEGIN);
-#undef pwchRaw
-        }
-        // Handle plain text encoding.
-        else if (eEncoding == ENCODING_ANSI)
-        {
-#define pchRaw  ((char *)pvRaw)
-            PCHAR pch, pchEnd;
-            DWORD cch = 0;
-
-            for (pch = pchRaw, pchEnd = pchRaw + cbRead; pch < pchEnd; pch++)
-            {
-                if (*pch == '\r' || *pch == '\n' || *pch == CHAR_EOF)
-                    break;
-            }
-
-            if (pch == pchEnd && cbRead == RAWBUFSIZE)
-                return FALSE;
-
-            if ((DWORD)(pch - pchRaw) >= cchBufMax)
-                return FALSE;
-
-            if (pch > pchRaw && (cch = MultiByteToWideChar(CP_ACP,
-                0, pchRaw, (int)(pch - pchRaw), pchBuf, cchBufMax-1)) == 0)
-                return FALSE;
-
-            pchBuf[cch] = L'\0';
-
-            if (pch == pchEnd)
-                ;
-            else if (*pch == '\n')
-                ++pch;
-            else if (*pch == '\r' && *++pch == '\n')
-                ++pch;
-
-            // Start from the correct file position next time.
-            return SeekFile(hf, dwCurrentOffset + (DWORD)(pch - pchRaw), FILE_BEGIN);
-#undef pchRaw
-        }
-        // Handle UTF-8 encoding.
-        else if (eEncoding == ENCODING_UTF8)
-        {
-#define pchRaw  ((char *)pvRaw)
-            PCHAR pch, pchEnd;
-            DWORD cch = 0;
-
-            for (pch = pchRaw, pchEnd = pchRaw + cbRead; pch < pchEnd; pch++)
-            {
-                if (*pch == '\r' || *pch == '\n' || *pch == CHAR_EOF)
-                    break;
-            }
-
-            if (pch == pchEnd && cbRead == RAWBUFSIZE)
-                return FALSE;
-
-            if (pch > pchRaw && (cch = MultiByteToWideChar(CP_UTF8, 0, pchRaw, (int)(pch - pchRaw), pchBuf, cchBufMax-1)) == 0)
-                return FALSE;
-
-            pchBuf[cch] = L'\0';
-
-            if (pch == pchEnd)
-                ;
-            else if (*pch == '\n')
-                ++pch;
-            else if (*pch == '\r' && *++pch == '\n')
-                ++pch;
-
-            // Start from the correct file position next time.
-            return SeekFile(hf, dwCurrentOffset + (DWORD)(pch - pchRaw), FILE_BEGIN);
-#undef pchRaw
-        }
-        // Handle bad dog.
-        else return FALSE;
-    }
-    __finally
-    {
-        free(pvRaw);
-    }
-    return TRUE;
-}
-
-#undef RAWBUFSIZE
-
 /****************************************************************************
  *                                                                          *
  * Function: NoUnixSlash                                                    *
@@ -1228,7 +689,7 @@ static PWSTR NoUnixSlash(PWSTR pszFileName)
  *                                                                          *
  ****************************************************************************/
 
-static PWSTR SearchIncludeFile(PCWSTR pcszIncludeName, PCWSTR pcszRefFileName)
+static PWSTR CALLBACK SearchIncludeFile(PWSTR pszIncludeName, PCWSTR pcszRefFileName)
 {
     WCHAR szPath[MAX_PATH];
     WCHAR szFileName[MAX_PATH];
@@ -1237,8 +698,8 @@ static PWSTR SearchIncludeFile(PCWSTR pcszIncludeName, PCWSTR pcszRefFileName)
     lstrcpyn(szPath, pcszRefFileName, NELEMS(szPath));
     PathRemoveFileSpec(szPath);
 
-    // Combine path with the included name.
-    PathCombine(szFileName, szPath, pcszIncludeName);
+    // Combine path with the included name; also removes "." and "..".
+    PathCombine(szFileName, szPath, NoUnixSlash(pszIncludeName));
 
     // Do we have a winner?
     if (IsExistingFile(szFileName))
@@ -0,0 +1,618 @@
+﻿/****************************************************************************
+ *                                                                          *
+ * File    : cpplex.c                                                       *
+ *                                                                          *
+ * Purpose : C++ syntax color lexer, for the sample add-in.                 *
+ *                                                                          *
+ *           Table driven: ASCII characters are classified with one lookup  *
+ *           in abCharClass[], and operators are matched by a small DFA     *
+ *           (longest match). Only characters outside ASCII go through the  *
+ *           iswdigit() and IsCharAlpha*() functions. Keywords are found    *
+ *           with a perfect hash. The tables are generated by mkcpptab,     *
+ *           into cpptab.h. Inside strings, char constants and extended     *
+ *           comments, SSE2 (when available) skips ahead 8 characters at    *
+ *           a time, to the next character that matters.                    *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define UNICODE   /* for Windows API */
+#define _UNICODE  /* for C runtime */
+#endif
+#include <wctype.h>
+#include "cpplex.h"
+#include "cpptab.h"
+
+// SSE2 is always available for x64; define CPPLEX_NO_SIMD to try the plain C code.
+#if !defined(CPPLEX_NO_SIMD) && (defined(_M_AMD64) || defined(_M_X64) || defined(__SSE2__))
+#define CPPLEX_SSE2
+#include <emmintrin.h>
+#if !defined(__GNUC__)
+#include <intrin.h>
+#endif
+#endif
+
+#define NELEMS(a)  (sizeof(a) / sizeof(a[0]))
+
+// Flags for usCookie.
+#define FLAG_COMMENT       0x01
+#define FLAG_PREPROCESSOR  0x02
+#define FLAG_EXT_COMMENT   0x04
+#define FLAG_STRING        0x08
+#define FLAG_CHAR          0x10
+#define FLAG_UNUSED4       0x20    // Free for any use.
+#define FLAG_UNUSED5       0x40    // Free for any use.
+#define FLAG_UNUSED6       0x80    // Free for any use.
+
+// Minimum and maximum folding level.
+#define MIN_FOLDLEVEL  0
+#define MAX_FOLDLEVEL  255
+
+// Helper macro for assigning color to column position.
+#define DEFINE_BLOCK(pch,color) \
+    do { \
+        if (pPoints != NULL) { \
+            if (*pcPoints == 0 || (pPoints - 1)->iColor != (color)) { \
+                pPoints->iChar = (UINT)((pch) - pchText); \
+                pPoints->iColor = (color); \
+                pPoints++; \
+                (*pcPoints)++; \
+            } \
+        } \
+    } while (0)
+
+// Function prototypes.
+static PCWSTR ParseOperator(PCWSTR, PCWSTR);
+static PCWSTR FindChar(PCWSTR, PCWSTR, WCHAR);
+static PCWSTR FindChar2(PCWSTR, PCWSTR, WCHAR, WCHAR);
+static PCWSTR ParseNumber(PCWSTR, PCWSTR);
+static BOOL IsSameKeyword(const char *, PCWSTR, size_t);
+
+// Inline functions.
+static inline BYTE CharClass(WCHAR ch)
+{
+    if (ch < 0x80)
+        return abCharClass[ch];
+
+    // Not ASCII - same tests, in the same order, as the parser always did.
+    if (iswdigit(ch))
+        return CC_DIGIT;
+    if (IsCharAlphaW(ch))
+        return CC_ALPHA;
+    return CC_TEXT;
+}
+
+static inline BOOL IsIdentChar(WCHAR ch)
+{
+    return (ch < 0x80) ? (abCharClass[ch] & (CC_ALPHA|CC_DIGIT)) != 0 : IsCharAlphaNumericW(ch);
+}
+
+static inline BOOL IsDigit(WCHAR ch)
+{
+    return (ch < 0x80) ? (abCharClass[ch] & CC_DIGIT) != 0 : iswdigit(ch) != 0;
+}
+
+static inline BOOL IsXDigit(WCHAR ch)
+{
+    return (ch < 0x80) ? (abCharClass[ch] & CC_XDIGIT) != 0 : iswxdigit(ch) != 0;
+}
+
+static inline BOOL IsSpace(WCHAR ch)
+{
+    return ch < 0x80 && (abCharClass[ch] & CC_SPACE) != 0;
+}
+
+#if defined(CPPLEX_SSE2)
+static inline int LowestBit(UINT u)
+{
+#if defined(__GNUC__)
+    return __builtin_ctz(u);
+#else
+    unsigned long i;
+    _BitScanForward(&i, u);
+    return (int)i;
+#endif
+}
+#endif
+
+static inline UINT KeywordHash(PCWSTR pch, size_t cch)
+{
+    UINT u = (UINT)cch * KW_MULLEN + pch[0] * KW_MULFIRST + pch[cch - 1] * KW_MULLAST +
+        pch[cch > KW_KEYPOS ? KW_KEYPOS : 0] * KW_MULKEY;
+
+    return (UINT)(u * 0x9E3779B1u) >> (32 - KW_HASHBITS);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: CppParseLine                                                   *
+ *                                                                          *
+ * Purpose : Parse C++ source code - for syntax color highlighting.         *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+USHORT CALLBACK CppParseLine(USHORT usCookie, PCWSTR pchText, int cchText, ADDIN_PARSE_POINT pPoints[], PINT pcPoints)
+{
+    PCWSTR pch = pchText, pchEnd = &pchText[cchText];
+    BYTE cFoldLevel = ADDIN_GET_COOKIE_LEVEL(usCookie);
+    BYTE bFlags = ADDIN_GET_COOKIE_FLAGS(usCookie);
+
+    if (pch == pchEnd)
+        ;
+    // Inside comment or extended comment.
+    else if (bFlags & (FLAG_COMMENT|FLAG_EXT_COMMENT))
+    {
+        DEFINE_BLOCK(pch, ADDIN_COLOR_COMMENT);
+    }
+    // Inside string or char constant.
+    else if (bFlags & (FLAG_CHAR|FLAG_STRING))
+    {
+        DEFINE_BLOCK(pch, ADDIN_COLOR_STRING);
+    }
+    // Inside preprocessor directive.
+    else if (bFlags & FLAG_PREPROCESSOR)
+    {
+        DEFINE_BLOCK(pch, ADDIN_COLOR_PREPROCESSOR);
+    }
+    else /* normal state */
+    {
+        while (pch < pchEnd && IsSpace(*pch))
+            pch++;
+
+        // Check for preprocessor directive: #...
+        if (pch < pchEnd && *pch == L'#')
+        {
+            DEFINE_BLOCK(pch, ADDIN_COLOR_PREPROCESSOR);
+            bFlags |= FLAG_PREPROCESSOR;
+
+            pch++;
+            while (pch < pchEnd && IsSpace(*pch))
+                pch++;
+
+            // Check for #if, #ifdef, #ifndef block.
+            if (&pch[1] < pchEnd &&
+                pch[0] == L'i' &&
+                pch[1] == L'f' &&
+                cFoldLevel < MAX_FOLDLEVEL)
+            {
+                cFoldLevel++;
+            }
+            else if (&pch[4] < pchEnd &&
+                pch[0] == L'e' &&
+                pch[1] == L'n' &&
+                pch[2] == L'd' &&
+                pch[3] == L'i' &&
+                pch[4] == L'f' &&
+                cFoldLevel > MIN_FOLDLEVEL)
+            {
+                cFoldLevel--;
+            }
+        }
+    }
+
+    while (pch < pchEnd)
+    {
+        BYTE bClass;
+
+        // Inside string constant: "...."
+        if (bFlags & FLAG_STRING)
+        {
+            // Nothing else matters.
+            if ((pch = FindChar2(pch, pchEnd, L'\\', L'\"')) == pchEnd)
+                break;
+
+            // Check for escape sequence.
+            if (*pch == L'\\')
+                pch++;
+            // Check for end of string constant.
+            else
+                bFlags &= ~FLAG_STRING;
+            pch++;
+            continue;
+        }
+
+        // Inside char constant: '.'
+        if (bFlags & FLAG_CHAR)
+        {
+            // Nothing else matters.
+            if ((pch = FindChar2(pch, pchEnd, L'\\', L'\'')) == pchEnd)
+                break;
+
+            // Check for escape sequence.
+            if (*pch == L'\\')
+                pch++;
+            // Check for end of char constant.
+            else
+                bFlags &= ~FLAG_CHAR;
+            pch++;
+            continue;
+        }
+
+        // Inside single line comment: //....
+        if (bFlags & FLAG_COMMENT)
+            break;  /* done! */
+
+        // Inside extended comment: /*....*/
+        if (bFlags & FLAG_EXT_COMMENT)
+        {
+            // Nothing else matters.
+            if ((pch = FindChar(pch, pchEnd, L'*')) == pchEnd)
+                break;
+
+            // Check for end of extended comment...
+            if (&pch[1] < pchEnd && pch[1] == L'/')
+            {
+                bFlags &= ~FLAG_EXT_COMMENT;
+                pch++;
+
+                // Can fold extended comments.
+                if (cFoldLevel > MIN_FOLDLEVEL) cFoldLevel--;
+            }
+            pch++;
+            continue;
+        }
+
+        // Inside preprocessor directive: #...
+        if (bFlags & FLAG_PREPROCESSOR)
+        {
+            // Check for string constant: "...."
+            if (*pch == L'\"')
+            {
+                bFlags |= FLAG_STRING;
+            }
+            // Check for char constant: '.'
+            else if (*pch == L'\'')
+            {
+                bFlags |= FLAG_CHAR;
+            }
+            // Check for single line comment: //
+            else if (*pch == L'/' && &pch[1] < pchEnd && pch[1] == L'/')
+            {
+                DEFINE_BLOCK(pch, ADDIN_COLOR_COMMENT);
+                bFlags |= FLAG_COMMENT;
+                pch++;
+            }
+            // Check for extended comment: /*....*/
+            else if (*pch == L'/' && &pch[1] < pchEnd && pch[1] == L'*')
+            {
+                DEFINE_BLOCK(pch, ADDIN_COLOR_COMMENT);
+                bFlags |= FLAG_EXT_COMMENT;
+                pch++;
+
+                // Can fold extended comments.
+                if (cFoldLevel < MAX_FOLDLEVEL) cFoldLevel++;
+            }
+            else
+            {
+                // Default case.
+                DEFINE_BLOCK(pch, ADDIN_COLOR_PREPROCESSOR);
+            }
+            pch++;
+            continue;
+        }
+
+        // One lookup decides what kind of token starts here.
+        bClass = CharClass(*pch);
+
+        // Check for operator (or comment).
+        if (bClass & CC_OPERATOR)
+        {
+            // Update curly brace level.
+            if (*pch == L'{' && cFoldLevel < MAX_FOLDLEVEL)
+                cFoldLevel++;
+            else if (*pch == L'}' && cFoldLevel > MIN_FOLDLEVEL)
+                cFoldLevel--;
+
+            if (*pch == L'/' && &pch[1] < pchEnd)
+            {
+                // Check for single line comment: //
+                if (pch[1] == L'/')
+                {
+                    DEFINE_BLOCK(pch, ADDIN_COLOR_COMMENT);
+                    bFlags |= FLAG_COMMENT;
+                    break;  /* done! */
+                }
+
+                // Check for extended comment: /*....*/
+                if (pch[1] == L'*')
+                {
+                    DEFINE_BLOCK(pch, ADDIN_COLOR_COMMENT);
+                    bFlags |= FLAG_EXT_COMMENT;
+                    pch += 2;
+
+                    // Can fold extended comments.
+                    if (cFoldLevel < MAX_FOLDLEVEL) cFoldLevel++;
+                    continue;
+                }
+            }
+
+            DEFINE_BLOCK(pch, ADDIN_COLOR_OPERATOR);
+            pch = ParseOperator(pch, pchEnd);
+            continue;
+        }
+
+        // Check for string constant: "...." or char constant: '.'
+        if (bClass & CC_QUOTE)
+        {
+            DEFINE_BLOCK(pch, ADDIN_COLOR_STRING);
+            bFlags |= (*pch == L'\"') ? FLAG_STRING : FLAG_CHAR;
+            pch++;
+            continue;
+        }
+
+        // Check for number.
+        if (bClass & CC_DIGIT)
+        {
+            DEFINE_BLOCK(pch, ADDIN_COLOR_NUMBER);
+            pch = ParseNumber(pch, pchEnd);
+            continue;
+        }
+
+        // Check for identifier.
+        if (bClass & CC_ALPHA)
+        {
+            PCWSTR pchIdent = pch;
+            do
+                pch++;
+            while (pch < pchEnd && IsIdentChar(*pch));
+
+            if (CppIsKeyword(pchIdent, pch - pchIdent))
+            {
+                DEFINE_BLOCK(pchIdent, ADDIN_COLOR_KEYWORD);
+            }
+            else
+            {
+                DEFINE_BLOCK(pchIdent, ADDIN_COLOR_TEXT);
+            }
+            continue;
+        }
+
+        // Default case.
+        DEFINE_BLOCK(pch, ADDIN_COLOR_TEXT);
+        pch++;
+
+        // Skip useless white-space.
+        while (pch < pchEnd && IsSpace(*pch))
+            pch++;
+    }
+
+    // If no line continuation ('\'), clear *most* flags for next line.
+    if (cchText < 2 || pchText[cchText-1] != L'\n' || pchText[cchText-2] != L'\\')
+        bFlags &= FLAG_EXT_COMMENT;
+
+    return ADDIN_MAKE_COOKIE(bFlags, cFoldLevel);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: CppIsKeyword                                                   *
+ *                                                                          *
+ * Purpose : Return non-zero index, if the given string is a keyword.       *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+size_t CppIsKeyword(PCWSTR pchText, size_t cchText)
+{
+    size_t iKeyword;
+
+    // One probe; the hash may only be trusted for a keyword, so compare.
+    if (cchText == 0 || (iKeyword = abKeywordHash[KeywordHash(pchText, cchText)]) == 0 ||
+        !IsSameKeyword(apszKeywords[iKeyword - 1], pchText, cchText))
+        return 0;
+
+    return iKeyword;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ParseOperator                                                  *
+ *                                                                          *
+ * Purpose : Parse the longest operator starting at pch.                    *
+ *           Runs the operator DFA, and remembers the last accepting state; *
+ *           no operator is longer than three characters.                   *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static PCWSTR ParseOperator(PCWSTR pch, PCWSTR pchEnd)
+{
+    BYTE bState = abOpNext[0][abOpChar[*pch]];
+    PCWSTR pchOp;
+
+    // Every operator character is also an operator.
+    pchOp = ++pch;
+
+    while (pch < pchEnd && *pch < 0x80 && (bState = abOpNext[bState][abOpChar[*pch]]) != 0)
+    {
+        pch++;
+        if (abOpAccept[bState])
+            pchOp = pch;
+    }
+
+    return pchOp;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: FindChar, FindChar2                                            *
+ *                                                                          *
+ * Purpose : Return the first of the given character(s), or pchEnd.         *
+ *                                                                          *
+ *           With SSE2, compares 8 characters at a time (unaligned loads,   *
+ *           never past pchEnd); the rest, or everything without SSE2, one  *
+ *           character at a time.                                           *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static PCWSTR FindChar(PCWSTR pch, PCWSTR pchEnd, WCHAR ch)
+{
+#if defined(CPPLEX_SSE2)
+    __m128i vch = _mm_set1_epi16((short)ch);
+
+    for (; pchEnd - pch >= 8; pch += 8)
+    {
+        UINT uMask = (UINT)_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *)pch), vch));
+        if (uMask != 0)
+            return pch + (LowestBit(uMask) >> 1);
+    }
+#endif
+
+    while (pch < pchEnd && *pch != ch)
+        pch++;
+
+    return pch;
+}
+
+static PCWSTR FindChar2(PCWSTR pch, PCWSTR pchEnd, WCHAR ch1, WCHAR ch2)
+{
+#if defined(CPPLEX_SSE2)
+    __m128i vch1 = _mm_set1_epi16((short)ch1);
+    __m128i vch2 = _mm_set1_epi16((short)ch2);
+
+    for (; pchEnd - pch >= 8; pch += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)pch);
+        UINT uMask = (UINT)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi16(v, vch1), _mm_cmpeq_epi16(v, vch2)));
+        if (uMask != 0)
+            return pch + (LowestBit(uMask) >> 1);
+    }
+#endif
+
+    while (pch < pchEnd && *pch != ch1 && *pch != ch2)
+        pch++;
+
+    return pch;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ParseNumber                                                    *
+ *                                                                          *
+ * Purpose : Parse a numeric value.                                         *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static PCWSTR ParseNumber(PCWSTR pch, PCWSTR pchEnd)
+{
+    BOOL fFloat = FALSE;
+
+    // Parse hexadecimal number.
+    if (pch[0] == L'0' && &pch[1] < pchEnd && (pch[1] == L'x' || pch[1] == L'X'))
+    {
+        pch += 2;
+
+        while (pch < pchEnd && IsXDigit(*pch))
+            pch++;
+    }
+    // Parse binary number (C++14).
+    if (pch[0] == L'0' && &pch[1] < pchEnd && (pch[1] == L'b' || pch[1] == L'B'))
+    {
+        pch += 2;
+
+        while (pch < pchEnd && (*pch == L'0' || *pch == L'1'))
+            pch++;
+    }
+    // Parse decimal number.
+    else
+    {
+        pch++;
+
+        while (pch < pchEnd && IsDigit(*pch))
+            pch++;
+
+        if (pch < pchEnd && *pch == L'.')
+        {
+            pch++;
+
+            while (pch < pchEnd && IsDigit(*pch))
+                pch++;
+
+            fFloat = TRUE;
+        }
+
+        if (pch < pchEnd && (*pch == L'e' || *pch == L'E'))
+        {
+            pch++;
+
+            if (pch < pchEnd && (*pch == L'-' || *pch == L'+'))
+                pch++;
+
+            while (pch < pchEnd && IsDigit(*pch))
+                pch++;
+
+            fFloat = TRUE;
+        }
+    }
+
+    // Parse suffix.
+    if (fFloat)
+    {
+        if (pch < pchEnd && (*pch == L'f' || *pch == L'F' || *pch == L'l' || *pch == L'L'))
+            pch++;
+    }
+    else
+    {
+        /* 'ULL' */
+        if (&pch[2] < pchEnd && (pch[0] == L'u' || pch[0] == L'U') && (pch[1] == L'l' || pch[1] == L'L') && (pch[2] == L'l' || pch[2] == L'L'))
+            pch += 3;
+        /* 'LLU' */
+        else if (&pch[2] < pchEnd && (pch[0] == L'l' || pch[0] == L'L') && (pch[1] == L'l' || pch[1] == L'L') && (pch[2] == L'u' || pch[2] == L'U'))
+            pch += 3;
+        /* 'LL' */
+        else if (&pch[1] < pchEnd && (pch[0] == L'l' || pch[0] == L'L') && (pch[1] == L'l' || pch[1] == L'L'))
+            pch += 2;
+        /* 'UL' */
+        else if (&pch[1] < pchEnd && (pch[0] == L'u' || pch[0] == L'U') && (pch[1] == L'l' || pch[1] == L'L'))
+            pch += 2;
+        /* 'LU' */
+        else if (&pch[1] < pchEnd && (pch[0] == L'l' || pch[0] == L'L') && (pch[1] == L'u' || pch[1] == L'U'))
+            pch += 2;
+        /* 'U' */
+        else if (pch < pchEnd && (*pch == L'u' || *pch == L'U'))
+            pch++;
+        /* 'L' */
+        else if (pch < pchEnd && (*pch == L'l' || *pch == L'L'))
+            pch++;
+    }
+
+    return pch;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: IsSameKeyword                                                  *
+ *                                                                          *
+ * Purpose : Compare a keyword with UTF-16 text.                            *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static BOOL IsSameKeyword(const char *psz, PCWSTR pch, size_t cch)
+{
+    for (; cch > 0; cch--)
+    {
+        if (*psz == '\0' || (WCHAR)(unsigned char)*psz++ != *pch++)
+            return FALSE;
+    }
+    return *psz == '\0';
+}
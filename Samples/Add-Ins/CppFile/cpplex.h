@@ -0,0 +1,34 @@
+﻿/****************************************************************************
+ *                                                                          *
+ * File    : cpplex.h                                                       *
+ *                                                                          *
+ * Purpose : Definitions for the C++ syntax color lexer.                    *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+#ifndef _CPPLEX_H
+#define _CPPLEX_H
+
+/*
+ * The lexer only needs a few types and the IsCharAlpha*() functions, so
+ * it can also be built, verified and profiled on other hosts; see bench\
+ * and ..\Shared\winhost.h.
+ */
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <addin.h>
+#else /* !_WIN32 */
+#include "../Shared/winhost.h"
+#endif /* !_WIN32 */
+#include <stddef.h>
+
+/****** Function prototypes ************************************************/
+
+USHORT CALLBACK CppParseLine(USHORT /*usCookie*/, PCWSTR /*pchText*/, int /*cchText*/, ADDIN_PARSE_POINT [] /*pPoints*/, PINT /*pcPoints*/);
+size_t CppIsKeyword(PCWSTR /*pchText*/, size_t /*cchText*/);
+
+#endif /* _CPPLEX_H */
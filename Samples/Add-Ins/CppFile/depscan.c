@@ -0,0 +1,1209 @@
+﻿/****************************************************************************
+ *                                                                          *
+ * File    : depscan.c                                                      *
+ *                                                                          *
+ * Purpose : C++ dependency scanner, for the sample add-in.                 *
+ *                                                                          *
+ *           Finds #include "name" lines, and all files included from the   *
+ *           included files. Works through a list of files still to scan,   *
+ *           instead of recursion, and keeps the canonical names of all     *
+ *           files found in a hash set: a header included from 50 places    *
+ *           is scanned and reported once, and headers that include each    *
+ *           other are not scanned over and over, until the stack is gone.  *
+ *                                                                          *
+ *           The cache keeps the includes of each file, with its stamp, so  *
+ *           unchanged files are not read again. It's saved as an image:    *
+ *           header, files, includes (file indexes) and names, all found    *
+ *           by offset or index, so it's used (and checked) where it was    *
+ *           mapped, without parsing.                                       *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define UNICODE   /* for Windows API */
+#define _UNICODE  /* for C runtime */
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include "depscan.h"
+
+// Initial size of the file set (power of two), and of the list of files to scan.
+#define C_SETINIT   256
+#define C_WORKINIT  64
+
+// Initial size of the cache (power of two).
+#define C_CACHEINIT  1024
+
+// Cached files not used for this many generations (loads) are not saved.
+#define C_GENERATIONS  16
+
+// Cache image: header, files, includes, and names. Little-endian, like all
+// hosts of the IDE; every part starts naturally aligned.
+#define DEPCACHE_MAGIC    0x50454443  /* "CDEP" */
+#define DEPCACHE_VERSION  1
+
+typedef struct DEPCACHEHDR {
+    uint32_t uMagic;        // DEPCACHE_MAGIC.
+    uint32_t uVersion;      // DEPCACHE_VERSION.
+    uint32_t uGeneration;   // Generation when saved.
+    uint32_t cFiles;        // Files (DEPCACHEREC).
+    uint32_t cRefs;         // Includes, and names not found (uint32_t).
+    uint32_t cchNames;      // Names, each one terminated (WCHAR).
+} DEPCACHEHDR;
+
+typedef struct DEPCACHEREC {
+    uint64_t stamp;         // Stamp of the file, when read.
+    uint32_t ichName;       // Name (offset in names).
+    uint32_t uGeneration;   // Generation when last used.
+    uint32_t fScanned;      // Stamp and includes are known (else, it's only included).
+    uint32_t iFirstRef;     // Includes (first).
+    uint32_t cIncludes;     // Files included (index of file).
+    uint32_t cMissing;      // Then, names included but not found (offset in names).
+} DEPCACHEREC;
+
+// Cached file.
+typedef struct DEPFILE {
+    PWSTR pszName;          // Canonical name.
+    uint64_t stamp;         // Stamp of the file, when read.
+    UINT uGeneration;       // Generation when last used.
+    BOOL fScanned;          // Stamp and includes are known (else, it's only included).
+    struct DEPFILE **ppIncludes;  // Files included.
+    size_t cIncludes;       // Number of files included.
+    PWSTR *ppszMissing;     // Names included, but not found (they may show up).
+    size_t cMissing;        // Number of names not found.
+    size_t iSaved;          // Index in the image (while saving).
+} DEPFILE;
+
+// Cache.
+struct DEPCACHE {
+    CRITICAL_SECTION cs;    // Lock; scans may run on several threads.
+    BOOL fIgnoreCase;       // Compare names without regard to (ASCII) case.
+    BOOL fDirty;            // Changed since loaded, or saved.
+    UINT uGeneration;       // Current generation.
+    DEPFILE **ppFiles;      // Files; hash set, NULL = free.
+    size_t cFiles, cFilesMax;  // Files used, and size of the set.
+};
+
+// List of names.
+typedef struct DEPLIST {
+    PWSTR *ppsz;            // Names (malloc'ed).
+    size_t c, cMax;         // Names used, and allocated.
+} DEPLIST;
+
+// Scan in progress.
+struct DEPSCAN {
+    const DEPSCANHOST *pHost;  // Host functions.
+    BOOL (CALLBACK *pfnAddDepFile)(LPCWSTR, LPCVOID);  // Add dependency (IDE).
+    LPCVOID pvCookie;       // Cookie for pfnAddDepFile.
+    PWSTR *ppszSet;         // Names of all files found; hash set, NULL = free.
+    size_t cSet, cSetMax;   // Names used, and size of the set.
+    PWSTR *ppszWork;        // Files still to scan (names are owned by the set).
+    size_t cWork, cWorkMax; // Files used, and allocated.
+    PCWSTR pszFile;         // File being scanned.
+    BOOL fComment;          // Inside traditional comment.
+    PDEPCACHE pCache;       // Cache, or NULL.
+    BOOL fRecord;           // Keep the includes of the file being scanned.
+    DEPLIST Includes;       // Files included by the file being scanned.
+    DEPLIST Missing;        // Names included, but not found.
+};
+
+// Static function prototypes.
+static BOOL ScanCached(PDEPSCAN);
+static BOOL FoundMissing(PDEPSCAN);
+static BOOL AddCachedInclude(PDEPSCAN, PCWSTR);
+static BOOL AddInclude(PDEPSCAN, PWSTR);
+static BOOL AddDependency(PDEPSCAN, PWSTR);
+static int AddFile(PDEPSCAN, PWSTR);
+static BOOL GrowSet(PDEPSCAN);
+static size_t FindName(PDEPSCAN, PCWSTR);
+static size_t HashName(PCWSTR, BOOL);
+static BOOL IsSameName(PCWSTR, PCWSTR, BOOL);
+static PWSTR DupName(PCWSTR);
+static size_t NameLength(PCWSTR);
+static BOOL GetCachedFile(PDEPCACHE, PCWSTR, uint64_t, DEPLIST *, DEPLIST *);
+static BOOL PutCachedFile(PDEPCACHE, PCWSTR, uint64_t, const DEPLIST *, DEPLIST *);
+static DEPFILE *LookupFile(PDEPCACHE, PCWSTR, BOOL);
+static BOOL GrowCache(PDEPCACHE);
+static void ClearCache(PDEPCACHE);
+static void ClearFile(DEPFILE *);
+static BOOL IsKeptFile(PDEPCACHE, const DEPFILE *);
+static BOOL AddToList(DEPLIST *, PWSTR);
+static void ClearList(DEPLIST *);
+
+// Inline functions.
+static inline PWSTR SkipWhiteSpace(PWSTR psz)
+{
+    while (*psz == L' ' || *psz == L'\t') ++psz;
+    return psz;
+}
+
+static inline WCHAR FoldCase(WCHAR ch)
+{
+    return (ch >= L'A' && ch <= L'Z') ? (WCHAR)(ch - L'A' + L'a') : ch;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: DepScan                                                        *
+ *                                                                          *
+ * Purpose : Scan a C++ file for dependencies; report each one once.        *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+BOOL DepScan(PCWSTR pcszFileName, const DEPSCANHOST *pHost, PDEPCACHE pCache, BOOL (CALLBACK *pfnAddDepFile)(LPCWSTR, LPCVOID), LPCVOID pvCookie)
+{
+    struct DEPSCAN scan = {0};
+    PWSTR pszFile;
+    BOOL fOK = TRUE;
+    size_t i;
+
+    scan.pHost = pHost;
+    scan.pfnAddDepFile = pfnAddDepFile;
+    scan.pvCookie = pvCookie;
+    scan.pCache = pCache;
+
+    // The file itself is found already, but not a dependency.
+    if ((pszFile = DupName(pcszFileName)) == NULL || AddFile(&scan, pszFile) < 0)
+    {
+        free(pszFile);
+        fOK = FALSE;
+    }
+
+    while (fOK && scan.cWork > 0)
+    {
+        scan.pszFile = scan.ppszWork[--scan.cWork];
+        scan.fComment = FALSE;
+        if (!(pCache != NULL ? ScanCached(&scan) : pHost->pfnScanFile(scan.pszFile, &scan)))
+            fOK = FALSE;
+    }
+
+    // Clean up.
+    for (i = 0; i < scan.cSetMax; i++)
+        free(scan.ppszSet[i]);
+    free(scan.ppszSet);
+    free(scan.ppszWork);
+    ClearList(&scan.Includes);
+    ClearList(&scan.Missing);
+    free(scan.Includes.ppsz);
+    free(scan.Missing.ppsz);
+
+    return fOK;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: DepScanLine                                                    *
+ *                                                                          *
+ * Purpose : Scan a line of the current file; FALSE to stop the scan.       *
+ *           The line is changed.                                           *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+BOOL DepScanLine(PDEPSCAN pScan, PWSTR pszLine)
+{
+    PWSTR psz = pszLine;
+
+restart:
+    if (pScan->fComment)
+    {
+        // In traditional comment, check for terminator.
+        while (*psz != L'\0' && (*psz != L'*' || psz[1] != L'/'))
+            psz++;
+
+        if (*psz == L'\0')
+            return TRUE;
+
+        psz += 2;
+        pScan->fComment = FALSE;
+    }
+
+    psz = SkipWhiteSpace(psz);
+
+    // Check for traditional comment.
+    if (psz[0] == L'/' && psz[1] == L'*')
+    {
+        psz += 2;
+        pScan->fComment = TRUE;
+        goto restart;
+    }
+
+    // Parse preprocessor lines.
+    if (*psz++ == L'#')
+    {
+        psz = SkipWhiteSpace(psz);
+
+        // Look for #include preprocessor line.
+        if (psz[0] == L'i' && psz[1] == L'n' && psz[2] == L'c' && psz[3] == L'l' &&
+            psz[4] == L'u' && psz[5] == L'd' && psz[6] == L'e')
+        {
+            psz = SkipWhiteSpace(psz + 7);
+
+            if (*psz++ == L'"')  /* ignore "standard places" (#include <name>) */
+            {
+                PWSTR pszName;
+
+                // Scan for end of "name".
+                for (pszName = psz; *psz != L'\0' && *psz != L'"'; psz++)
+                    ;
+
+                if (*psz == L'"')
+                {
+                    // Insert sneaky terminator.
+                    *psz = L'\0';
+                    return AddInclude(pScan, pszName);
+                }
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: DepCacheCreate                                                 *
+ *                                                                          *
+ * Purpose : Create an (empty) dependency cache.                            *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+PDEPCACHE DepCacheCreate(BOOL fIgnoreCase)
+{
+    PDEPCACHE pCache;
+
+    if ((pCache = calloc(1, sizeof(*pCache))) == NULL)
+        return NULL;
+
+    InitializeCriticalSection(&pCache->cs);
+    pCache->fIgnoreCase = fIgnoreCase;
+    pCache->uGeneration = 1;
+
+    return pCache;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: DepCacheDestroy                                                *
+ *                                                                          *
+ * Purpose : Destroy a dependency cache.                                    *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+void DepCacheDestroy(PDEPCACHE pCache)
+{
+    if (pCache == NULL)
+        return;
+
+    ClearCache(pCache);
+    DeleteCriticalSection(&pCache->cs);
+    free(pCache);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: DepCacheLoad                                                   *
+ *                                                                          *
+ * Purpose : Load an empty cache from an image, saved by DepCacheSave().    *
+ *           The image is only read; it's not needed afterwards. FALSE if   *
+ *           the image is not valid (the cache stays empty).                *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+BOOL DepCacheLoad(PDEPCACHE pCache, LPCVOID pvImage, size_t cbImage)
+{
+    const DEPCACHEHDR *pHdr = pvImage;
+    const DEPCACHEREC *pRecs;
+    const uint32_t *pRefs;
+    PCWSTR pchNames;
+    DEPFILE **ppLoaded;
+    BOOL fOK;
+    size_t i, j;
+
+    // Check the header, and the size of all parts.
+    if (cbImage < sizeof(DEPCACHEHDR) || pHdr->uMagic != DEPCACHE_MAGIC || pHdr->uVersion != DEPCACHE_VERSION ||
+        sizeof(DEPCACHEHDR) + (uint64_t)pHdr->cFiles * sizeof(DEPCACHEREC) + (uint64_t)pHdr->cRefs * sizeof(uint32_t) +
+        (uint64_t)pHdr->cchNames * sizeof(WCHAR) != cbImage)
+        return FALSE;
+
+    pRecs = (const DEPCACHEREC *)(pHdr + 1);
+    pRefs = (const uint32_t *)(pRecs + pHdr->cFiles);
+    pchNames = (PCWSTR)(pRefs + pHdr->cRefs);
+
+    // The names must be terminated.
+    if (pHdr->cchNames == 0 || pchNames[pHdr->cchNames - 1] != L'\0')
+        return FALSE;
+
+    if ((ppLoaded = malloc((pHdr->cFiles + 1) * sizeof(DEPFILE *))) == NULL)
+        return FALSE;
+
+    EnterCriticalSection(&pCache->cs);
+
+    // First all files, so includes can refer to any of them.
+    for (fOK = TRUE, i = 0; fOK && i < pHdr->cFiles; i++)
+    {
+        fOK = pRecs[i].ichName < pHdr->cchNames &&
+            (uint64_t)pRecs[i].iFirstRef + pRecs[i].cIncludes + pRecs[i].cMissing <= pHdr->cRefs &&
+            (ppLoaded[i] = LookupFile(pCache, &pchNames[pRecs[i].ichName], TRUE)) != NULL;
+    }
+
+    // Then the includes.
+    for (i = 0; fOK && i < pHdr->cFiles; i++)
+    {
+        const DEPCACHEREC *pRec = &pRecs[i];
+        const uint32_t *pRef = &pRefs[pRec->iFirstRef];
+        DEPFILE *pFile = ppLoaded[i];
+
+        if (!pRec->fScanned)
+            continue;
+
+        ClearFile(pFile);
+        pFile->ppIncludes = malloc((pRec->cIncludes + 1) * sizeof(DEPFILE *));
+        pFile->ppszMissing = malloc((pRec->cMissing + 1) * sizeof(PWSTR));
+        if (pFile->ppIncludes == NULL || pFile->ppszMissing == NULL)
+        {
+            fOK = FALSE;
+            break;
+        }
+
+        for (j = 0; fOK && j < pRec->cIncludes; j++)
+        {
+            if ((fOK = pRef[j] < pHdr->cFiles) != FALSE)
+                pFile->ppIncludes[pFile->cIncludes++] = ppLoaded[pRef[j]];
+        }
+        for (pRef += j, j = 0; fOK && j < pRec->cMissing; j++)
+        {
+            if ((fOK = pRef[j] < pHdr->cchNames && (pFile->ppszMissing[pFile->cMissing] = DupName(&pchNames[pRef[j]])) != NULL) != FALSE)
+                pFile->cMissing++;
+        }
+
+        pFile->stamp = pRec->stamp;
+        pFile->uGeneration = pRec->uGeneration;
+        pFile->fScanned = fOK;
+    }
+
+    if (fOK)
+        pCache->uGeneration = pHdr->uGeneration + 1;
+    else
+        ClearCache(pCache);
+    pCache->fDirty = FALSE;
+
+    LeaveCriticalSection(&pCache->cs);
+
+    free(ppLoaded);
+    return fOK;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: DepCacheSave                                                   *
+ *                                                                          *
+ * Purpose : Save the cache as an image (malloc'ed); NULL if out of memory. *
+ *           Files not used for a while are left out.                       *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+LPVOID DepCacheSave(PDEPCACHE pCache, size_t *pcbImage)
+{
+    DEPCACHEHDR hdr = {0};
+    DEPCACHEREC *pRecs;
+    uint32_t *pRefs;
+    PWSTR pchNames;
+    uint64_t cbImage, cRefs = 0, cchNames = 0, cFiles = 0;
+    LPVOID pvImage = NULL;
+    size_t i, j;
+
+    EnterCriticalSection(&pCache->cs);
+
+    // Number the files to keep, and then the files they include.
+    for (i = 0; i < pCache->cFilesMax; i++)
+    {
+        DEPFILE *pFile = pCache->ppFiles[i];
+
+        if (pFile != NULL && (pFile->iSaved = IsKeptFile(pCache, pFile) ? (size_t)cFiles++ : SIZE_MAX) != SIZE_MAX)
+        {
+            cRefs += pFile->cIncludes + pFile->cMissing;
+            cchNames += NameLength(pFile->pszName) + 1;
+            for (j = 0; j < pFile->cMissing; j++)
+                cchNames += NameLength(pFile->ppszMissing[j]) + 1;
+        }
+    }
+    for (i = 0; i < pCache->cFilesMax; i++)
+    {
+        DEPFILE *pFile = pCache->ppFiles[i];
+
+        for (j = 0; pFile != NULL && pFile->iSaved != SIZE_MAX && IsKeptFile(pCache, pFile) && j < pFile->cIncludes; j++)
+        {
+            if (pFile->ppIncludes[j]->iSaved == SIZE_MAX)
+            {
+                pFile->ppIncludes[j]->iSaved = (size_t)cFiles++;
+                cchNames += NameLength(pFile->ppIncludes[j]->pszName) + 1;
+            }
+        }
+    }
+
+    cbImage = sizeof(DEPCACHEHDR) + cFiles * sizeof(DEPCACHEREC) + cRefs * sizeof(uint32_t) + cchNames * sizeof(WCHAR);
+    if (cFiles > UINT32_MAX || cRefs > UINT32_MAX || cchNames > UINT32_MAX || cbImage > SIZE_MAX ||
+        (pvImage = calloc(1, (size_t)cbImage)) == NULL)
+        goto done;
+
+    hdr.uMagic = DEPCACHE_MAGIC;
+    hdr.uVersion = DEPCACHE_VERSION;
+    hdr.uGeneration = pCache->uGeneration;
+    hdr.cFiles = (uint32_t)cFiles;
+    hdr.cRefs = (uint32_t)cRefs;
+    hdr.cchNames = (uint32_t)cchNames;
+    memcpy(pvImage, &hdr, sizeof(hdr));
+
+    pRecs = (DEPCACHEREC *)((DEPCACHEHDR *)pvImage + 1);
+    pRefs = (uint32_t *)(pRecs + cFiles);
+    pchNames = (PWSTR)(pRefs + cRefs);
+
+    // Write the files; numbered files only.
+    for (cRefs = cchNames = 0, i = 0; i < pCache->cFilesMax; i++)
+    {
+        DEPFILE *pFile = pCache->ppFiles[i];
+        DEPCACHEREC *pRec;
+
+        if (pFile == NULL || pFile->iSaved == SIZE_MAX)
+            continue;
+
+        pRec = &pRecs[pFile->iSaved];
+        pRec->ichName = (uint32_t)cchNames;
+        cchNames += NameLength(pFile->pszName) + 1;
+        memcpy(&pchNames[pRec->ichName], pFile->pszName, (cchNames - pRec->ichName) * sizeof(WCHAR));
+        pRec->uGeneration = pFile->uGeneration;
+
+        if (IsKeptFile(pCache, pFile))
+        {
+            pRec->stamp = pFile->stamp;
+            pRec->fScanned = TRUE;
+            pRec->iFirstRef = (uint32_t)cRefs;
+            pRec->cIncludes = (uint32_t)pFile->cIncludes;
+            pRec->cMissing = (uint32_t)pFile->cMissing;
+
+            for (j = 0; j < pFile->cIncludes; j++)
+                pRefs[cRefs++] = (uint32_t)pFile->ppIncludes[j]->iSaved;
+
+            for (j = 0; j < pFile->cMissing; j++)
+            {
+                size_t cch = NameLength(pFile->ppszMissing[j]) + 1;
+
+                pRefs[cRefs++] = (uint32_t)cchNames;
+                memcpy(&pchNames[cchNames], pFile->ppszMissing[j], cch * sizeof(WCHAR));
+                cchNames += cch;
+            }
+        }
+    }
+
+    *pcbImage = (size_t)cbImage;
+    pCache->fDirty = FALSE;
+
+done:
+    LeaveCriticalSection(&pCache->cs);
+    return pvImage;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: DepCacheIsDirty                                                *
+ *                                                                          *
+ * Purpose : Return TRUE if the cache changed since loaded, or saved.       *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+BOOL DepCacheIsDirty(PDEPCACHE pCache)
+{
+    BOOL fDirty;
+
+    EnterCriticalSection(&pCache->cs);
+    fDirty = pCache->fDirty;
+    LeaveCriticalSection(&pCache->cs);
+
+    return fDirty;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ScanCached                                                     *
+ *                                                                          *
+ * Purpose : Scan a file through the cache: take the includes from the      *
+ *           cache if the file is unchanged, else read the file, and keep   *
+ *           its includes in the cache.                                     *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static BOOL ScanCached(PDEPSCAN pScan)
+{
+    uint64_t stamp;
+    BOOL fOK;
+    size_t i;
+
+    if (!pScan->pHost->pfnGetStamp(pScan->pszFile, &stamp))
+        return FALSE;
+
+    // Unchanged, and none of the names not found showed up?
+    if (GetCachedFile(pScan->pCache, pScan->pszFile, stamp, &pScan->Includes, &pScan->Missing) && !FoundMissing(pScan))
+    {
+        for (i = 0; i < pScan->Includes.c; i++)
+        {
+            if (!AddCachedInclude(pScan, pScan->Includes.ppsz[i]))
+                return FALSE;
+        }
+        return TRUE;
+    }
+
+    // Read the file; keep what it includes.
+    ClearList(&pScan->Includes);
+    ClearList(&pScan->Missing);
+    pScan->fRecord = TRUE;
+    fOK = pScan->pHost->pfnScanFile(pScan->pszFile, pScan);
+    pScan->fRecord = FALSE;
+
+    if (fOK)
+        (void)PutCachedFile(pScan->pCache, pScan->pszFile, stamp, &pScan->Includes, &pScan->Missing);  /* else, read it next time */
+
+    return fOK;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: FoundMissing                                                   *
+ *                                                                          *
+ * Purpose : Return TRUE if a name not found by the cached scan is found    *
+ *           now (or maybe: when out of memory).                            *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static BOOL FoundMissing(PDEPSCAN pScan)
+{
+    size_t i;
+
+    for (i = 0; i < pScan->Missing.c; i++)
+    {
+        PWSTR pszName, pszDepFileName;
+
+        // The host may change the name.
+        if ((pszName = DupName(pScan->Missing.ppsz[i])) == NULL)
+            return TRUE;
+
+        pszDepFileName = pScan->pHost->pfnSearchInclude(pszName, pScan->pszFile);
+        free(pszName);
+        if (pszDepFileName != NULL)
+        {
+            free(pszDepFileName);
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: AddCachedInclude                                               *
+ *                                                                          *
+ * Purpose : Add an included file from the cache, if it's new, and still    *
+ *           there.                                                         *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static BOOL AddCachedInclude(PDEPSCAN pScan, PCWSTR pcszDepFileName)
+{
+    PWSTR pszDepFileName;
+    uint64_t stamp;
+
+    if (pScan->ppszSet[FindName(pScan, pcszDepFileName)] != NULL)
+        return TRUE;
+
+    if (!pScan->pHost->pfnGetStamp(pcszDepFileName, &stamp))
+        return TRUE;
+
+    if ((pszDepFileName = DupName(pcszDepFileName)) == NULL)
+        return FALSE;
+
+    return AddDependency(pScan, pszDepFileName);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: AddInclude                                                     *
+ *                                                                          *
+ * Purpose : Search for an included file; if it's new, report it, and       *
+ *           scan it later.                                                 *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static BOOL AddInclude(PDEPSCAN pScan, PWSTR pszName)
+{
+    PWSTR pszDepFileName;
+
+    // Search for the included file.
+    if ((pszDepFileName = pScan->pHost->pfnSearchInclude(pszName, pScan->pszFile)) == NULL)
+        return !pScan->fRecord || AddToList(&pScan->Missing, DupName(pszName));
+
+    // The list keeps the name; only a new file needs a copy.
+    if (pScan->fRecord)
+    {
+        if (!AddToList(&pScan->Includes, pszDepFileName))
+            return FALSE;
+
+        if (pScan->ppszSet[FindName(pScan, pszDepFileName)] != NULL)
+            return TRUE;
+
+        if ((pszDepFileName = DupName(pszDepFileName)) == NULL)
+            return FALSE;
+    }
+
+    return AddDependency(pScan, pszDepFileName);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: AddDependency                                                  *
+ *                                                                          *
+ * Purpose : Add an included file (malloc'ed name); if it's new, report it, *
+ *           and scan it later.                                             *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static BOOL AddDependency(PDEPSCAN pScan, PWSTR pszDepFileName)
+{
+    switch (AddFile(pScan, pszDepFileName))
+    {
+        case 1:
+            // Found new included file: add as new dependency (scan it later).
+            return pScan->pfnAddDepFile(pszDepFileName, pScan->pvCookie);
+
+        case 0:
+            // Found it before.
+            free(pszDepFileName);
+            return TRUE;
+
+        default:
+            free(pszDepFileName);
+            return FALSE;
+    }
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: AddFile                                                        *
+ *                                                                          *
+ * Purpose : Add a file to the set, and to the files to scan. Returns 1 if  *
+ *           added (the set owns the name), 0 if found before, -1 if out    *
+ *           of memory.                                                     *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int AddFile(PDEPSCAN pScan, PWSTR pszFileName)
+{
+    size_t iSlot;
+
+    // Keep the set at most half full.
+    if (2 * (pScan->cSet + 1) > pScan->cSetMax && !GrowSet(pScan))
+        return -1;
+
+    iSlot = FindName(pScan, pszFileName);
+    if (pScan->ppszSet[iSlot] != NULL)
+        return 0;
+
+    if (pScan->cWork == pScan->cWorkMax)
+    {
+        size_t cWorkMax = pScan->cWorkMax ? pScan->cWorkMax * 2 : C_WORKINIT;
+        PWSTR *ppszWork = realloc(pScan->ppszWork, cWorkMax * sizeof(PWSTR));
+        if (ppszWork == NULL)
+            return -1;
+        pScan->ppszWork = ppszWork;
+        pScan->cWorkMax = cWorkMax;
+    }
+
+    pScan->ppszSet[iSlot] = pszFileName;
+    pScan->cSet++;
+    pScan->ppszWork[pScan->cWork++] = pszFileName;
+    return 1;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: GrowSet                                                        *
+ *                                                                          *
+ * Purpose : Double the size of the file set.                               *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static BOOL GrowSet(PDEPSCAN pScan)
+{
+    PWSTR *ppszOld = pScan->ppszSet;
+    size_t cOld = pScan->cSetMax;
+    size_t i;
+
+    pScan->cSetMax = cOld ? cOld * 2 : C_SETINIT;
+    if ((pScan->ppszSet = calloc(pScan->cSetMax, sizeof(PWSTR))) == NULL)
+    {
+        pScan->ppszSet = ppszOld;
+        pScan->cSetMax = cOld;
+        return FALSE;
+    }
+
+    for (i = 0; i < cOld; i++)
+    {
+        if (ppszOld[i] != NULL)
+            pScan->ppszSet[FindName(pScan, ppszOld[i])] = ppszOld[i];
+    }
+
+    free(ppszOld);
+    return TRUE;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: FindName                                                       *
+ *                                                                          *
+ * Purpose : Return slot of a name in the file set, or the free slot for    *
+ *           it (linear probing).                                           *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static size_t FindName(PDEPSCAN pScan, PCWSTR pcszName)
+{
+    size_t iMask = pScan->cSetMax - 1;
+    size_t iSlot = HashName(pcszName, pScan->pHost->fIgnoreCase) & iMask;
+
+    while (pScan->ppszSet[iSlot] != NULL && !IsSameName(pScan->ppszSet[iSlot], pcszName, pScan->pHost->fIgnoreCase))
+        iSlot = (iSlot + 1) & iMask;
+
+    return iSlot;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: HashName                                                       *
+ *                                                                          *
+ * Purpose : Hash a file name (FNV-1a).                                     *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static size_t HashName(PCWSTR pcszName, BOOL fIgnoreCase)
+{
+    UINT uHash = 2166136261u;
+
+    for (; *pcszName != L'\0'; pcszName++)
+        uHash = (uHash ^ (fIgnoreCase ? FoldCase(*pcszName) : *pcszName)) * 16777619u;
+
+    return uHash;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: IsSameName                                                     *
+ *                                                                          *
+ * Purpose : Compare file names.                                            *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static BOOL IsSameName(PCWSTR pcsz1, PCWSTR pcsz2, BOOL fIgnoreCase)
+{
+    if (fIgnoreCase)
+    {
+        while (*pcsz1 != L'\0' && FoldCase(*pcsz1) == FoldCase(*pcsz2))
+            pcsz1++, pcsz2++;
+    }
+    else
+    {
+        while (*pcsz1 != L'\0' && *pcsz1 == *pcsz2)
+            pcsz1++, pcsz2++;
+    }
+
+    return *pcsz1 == *pcsz2;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: DupName                                                        *
+ *                                                                          *
+ * Purpose : Duplicate a file name.                                         *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static PWSTR DupName(PCWSTR pcszName)
+{
+    size_t cch = NameLength(pcszName);
+    PWSTR psz;
+
+    if ((psz = malloc((cch + 1) * sizeof(WCHAR))) != NULL)
+        memcpy(psz, pcszName, (cch + 1) * sizeof(WCHAR));
+
+    return psz;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: NameLength                                                     *
+ *                                                                          *
+ * Purpose : Return length of a file name.                                  *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static size_t NameLength(PCWSTR pcszName)
+{
+    size_t cch;
+
+    for (cch = 0; pcszName[cch] != L'\0'; cch++)
+        ;
+
+    return cch;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: GetCachedFile                                                  *
+ *                                                                          *
+ * Purpose : Get the includes of a file from the cache; FALSE if the file   *
+ *           is not cached, or the stamp differs.                           *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static BOOL GetCachedFile(PDEPCACHE pCache, PCWSTR pcszFileName, uint64_t stamp, DEPLIST *pIncludes, DEPLIST *pMissing)
+{
+    DEPFILE *pFile;
+    BOOL fOK = FALSE;
+    size_t i;
+
+    ClearList(pIncludes);
+    ClearList(pMissing);
+
+    EnterCriticalSection(&pCache->cs);
+
+    if ((pFile = LookupFile(pCache, pcszFileName, FALSE)) != NULL && pFile->fScanned && pFile->stamp == stamp)
+    {
+        for (fOK = TRUE, i = 0; fOK && i < pFile->cIncludes; i++)
+            fOK = AddToList(pIncludes, DupName(pFile->ppIncludes[i]->pszName));
+        for (i = 0; fOK && i < pFile->cMissing; i++)
+            fOK = AddToList(pMissing, DupName(pFile->ppszMissing[i]));
+
+        // Used in this generation.
+        if (pFile->uGeneration != pCache->uGeneration)
+        {
+            pFile->uGeneration = pCache->uGeneration;
+            pCache->fDirty = TRUE;
+        }
+    }
+
+    LeaveCriticalSection(&pCache->cs);
+
+    return fOK;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: PutCachedFile                                                  *
+ *                                                                          *
+ * Purpose : Keep the includes of a file in the cache. The names not found  *
+ *           are moved from the list, not copied.                           *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static BOOL PutCachedFile(PDEPCACHE pCache, PCWSTR pcszFileName, uint64_t stamp, const DEPLIST *pIncludes, DEPLIST *pMissing)
+{
+    DEPFILE **ppIncludes = malloc((pIncludes->c + 1) * sizeof(DEPFILE *));
+    DEPFILE *pFile = NULL;
+    BOOL fOK = (ppIncludes != NULL);
+    size_t i;
+
+    EnterCriticalSection(&pCache->cs);
+
+    if (fOK && (pFile = LookupFile(pCache, pcszFileName, TRUE)) == NULL)
+        fOK = FALSE;
+
+    for (i = 0; fOK && i < pIncludes->c; i++)
+        fOK = (ppIncludes[i] = LookupFile(pCache, pIncludes->ppsz[i], TRUE)) != NULL;
+
+    if (fOK)
+    {
+        ClearFile(pFile);
+        pFile->stamp = stamp;
+        pFile->uGeneration = pCache->uGeneration;
+        pFile->fScanned = TRUE;
+        pFile->ppIncludes = ppIncludes;
+        pFile->cIncludes = pIncludes->c;
+        pFile->ppszMissing = pMissing->ppsz;
+        pFile->cMissing = pMissing->c;
+        pCache->fDirty = TRUE;
+
+        pMissing->ppsz = NULL;
+        pMissing->c = pMissing->cMax = 0;
+    }
+
+    LeaveCriticalSection(&pCache->cs);
+
+    if (!fOK)
+        free(ppIncludes);
+
+    return fOK;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: LookupFile                                                     *
+ *                                                                          *
+ * Purpose : Find a file in the cache; add it if asked to (not scanned).    *
+ *           NULL if not found, or out of memory. The lock must be held.    *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static DEPFILE *LookupFile(PDEPCACHE pCache, PCWSTR pcszFileName, BOOL fAdd)
+{
+    size_t iMask, iSlot;
+    DEPFILE *pFile;
+
+    // Keep the set at most half full.
+    if (fAdd && 2 * (pCache->cFiles + 1) > pCache->cFilesMax && !GrowCache(pCache))
+        return NULL;
+
+    if (pCache->cFilesMax == 0)
+        return NULL;
+
+    iMask = pCache->cFilesMax - 1;
+    iSlot = HashName(pcszFileName, pCache->fIgnoreCase) & iMask;
+    while (pCache->ppFiles[iSlot] != NULL && !IsSameName(pCache->ppFiles[iSlot]->pszName, pcszFileName, pCache->fIgnoreCase))
+        iSlot = (iSlot + 1) & iMask;
+
+    if (pCache->ppFiles[iSlot] != NULL || !fAdd)
+        return pCache->ppFiles[iSlot];
+
+    if ((pFile = calloc(1, sizeof(*pFile))) == NULL)
+        return NULL;
+
+    if ((pFile->pszName = DupName(pcszFileName)) == NULL)
+    {
+        free(pFile);
+        return NULL;
+    }
+
+    pCache->ppFiles[iSlot] = pFile;
+    pCache->cFiles++;
+    return pFile;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: GrowCache                                                      *
+ *                                                                          *
+ * Purpose : Double the size of the cache.                                  *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static BOOL GrowCache(PDEPCACHE pCache)
+{
+    DEPFILE **ppOld = pCache->ppFiles;
+    size_t cOld = pCache->cFilesMax;
+    size_t i, iMask, iSlot;
+
+    pCache->cFilesMax = cOld ? cOld * 2 : C_CACHEINIT;
+    if ((pCache->ppFiles = calloc(pCache->cFilesMax, sizeof(DEPFILE *))) == NULL)
+    {
+        pCache->ppFiles = ppOld;
+        pCache->cFilesMax = cOld;
+        return FALSE;
+    }
+
+    iMask = pCache->cFilesMax - 1;
+    for (i = 0; i < cOld; i++)
+    {
+        if (ppOld[i] == NULL)
+            continue;
+
+        iSlot = HashName(ppOld[i]->pszName, pCache->fIgnoreCase) & iMask;
+        while (pCache->ppFiles[iSlot] != NULL)
+            iSlot = (iSlot + 1) & iMask;
+        pCache->ppFiles[iSlot] = ppOld[i];
+    }
+
+    free(ppOld);
+    return TRUE;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ClearCache                                                     *
+ *                                                                          *
+ * Purpose : Remove all files from the cache.                               *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static void ClearCache(PDEPCACHE pCache)
+{
+    size_t i;
+
+    for (i = 0; i < pCache->cFilesMax; i++)
+    {
+        if (pCache->ppFiles[i] != NULL)
+        {
+            ClearFile(pCache->ppFiles[i]);
+            free(pCache->ppFiles[i]->pszName);
+            free(pCache->ppFiles[i]);
+        }
+    }
+
+    free(pCache->ppFiles);
+    pCache->ppFiles = NULL;
+    pCache->cFiles = pCache->cFilesMax = 0;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ClearFile                                                      *
+ *                                                                          *
+ * Purpose : Forget the includes of a cached file.                          *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static void ClearFile(DEPFILE *pFile)
+{
+    size_t i;
+
+    for (i = 0; i < pFile->cMissing; i++)
+        free(pFile->ppszMissing[i]);
+    free(pFile->ppszMissing);
+    free(pFile->ppIncludes);
+
+    pFile->ppIncludes = NULL;
+    pFile->ppszMissing = NULL;
+    pFile->cIncludes = pFile->cMissing = 0;
+    pFile->fScanned = FALSE;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: IsKeptFile                                                     *
+ *                                                                          *
+ * Purpose : Return TRUE if a cached file is saved with its includes.       *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static BOOL IsKeptFile(PDEPCACHE pCache, const DEPFILE *pFile)
+{
+    return pFile->fScanned && pCache->uGeneration - pFile->uGeneration < C_GENERATIONS;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: AddToList, ClearList                                           *
+ *                                                                          *
+ * Purpose : Add a name (malloc'ed, or NULL if out of memory) to a list,    *
+ *           or free it; remove all names from a list.                      *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static BOOL AddToList(DEPLIST *pList, PWSTR pszName)
+{
+    if (pszName == NULL)
+        return FALSE;
+
+    if (pList->c == pList->cMax)
+    {
+        size_t cMax = pList->cMax ? pList->cMax * 2 : C_WORKINIT;
+        PWSTR *ppsz = realloc(pList->ppsz, cMax * sizeof(PWSTR));
+        if (ppsz == NULL)
+        {
+            free(pszName);
+            return FALSE;
+        }
+        pList->ppsz = ppsz;
+        pList->cMax = cMax;
+    }
+
+    pList->ppsz[pList->c++] = pszName;
+    return TRUE;
+}
+
+static void ClearList(DEPLIST *pList)
+{
+    while (pList->c > 0)
+        free(pList->ppsz[--pList->c]);
+}
@@ -0,0 +1,63 @@
+﻿/****************************************************************************
+ *                                                                          *
+ * File    : depscan.h                                                      *
+ *                                                                          *
+ * Purpose : Definitions for the C++ dependency scanner.                    *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+#ifndef _DEPSCAN_H
+#define _DEPSCAN_H
+
+/*
+ * The scanner keeps a list of files still to scan, and the set of files
+ * already found, so every dependency is scanned and reported once, and
+ * files that include each other are no problem. Reading files and finding
+ * included files is left to the host, so the scanner can also be built,
+ * verified and profiled on other hosts; see bench\.
+ *
+ * With a cache, the included files found in each file are kept, with the
+ * stamp (modification time) of the file when it was read. A file with the
+ * same stamp is not read again; its includes are taken from the cache. The
+ * cache can be saved as one block of memory, and loaded from it, so it can
+ * be kept between builds (and mapped from a file, instead of read).
+ */
+
+#include <stdint.h>
+#if defined(_WIN32)
+#include <windows.h>
+#include <addin.h>
+#else /* !_WIN32 */
+#include "../Shared/winhost.h"
+#endif /* !_WIN32 */
+
+typedef struct DEPSCAN *PDEPSCAN;
+typedef struct DEPCACHE *PDEPCACHE;
+
+// Host functions.
+typedef struct DEPSCANHOST {
+    // Read a file, and call DepScanLine() for each line; FALSE on error.
+    BOOL (CALLBACK *pfnScanFile)(PCWSTR pcszFileName, PDEPSCAN pScan);
+    // Return canonical name (malloc'ed) of an included file, or NULL if not found.
+    PWSTR (CALLBACK *pfnSearchInclude)(PWSTR pszIncludeName, PCWSTR pcszRefFileName);
+    // Get stamp of a file, which changes when the file is written; FALSE if not found.
+    // Only used with a cache.
+    BOOL (CALLBACK *pfnGetStamp)(PCWSTR pcszFileName, uint64_t *pStamp);
+    // Compare names without regard to (ASCII) case.
+    BOOL fIgnoreCase;
+} DEPSCANHOST;
+
+/****** Function prototypes ************************************************/
+
+BOOL DepScan(PCWSTR /*pcszFileName*/, const DEPSCANHOST * /*pHost*/, PDEPCACHE /*pCache*/, BOOL (CALLBACK * /*pfnAddDepFile*/)(LPCWSTR, LPCVOID), LPCVOID /*pvCookie*/);
+BOOL DepScanLine(PDEPSCAN /*pScan*/, PWSTR /*pszLine*/);
+PDEPCACHE DepCacheCreate(BOOL /*fIgnoreCase*/);
+void DepCacheDestroy(PDEPCACHE /*pCache*/);
+BOOL DepCacheLoad(PDEPCACHE /*pCache*/, LPCVOID /*pvImage*/, size_t /*cbImage*/);
+LPVOID DepCacheSave(PDEPCACHE /*pCache*/, size_t * /*pcbImage*/);
+BOOL DepCacheIsDirty(PDEPCACHE /*pCache*/);
+
+#endif /* _DEPSCAN_H */
@@ -0,0 +1,469 @@
+﻿/****************************************************************************
+ *                                                                          *
+ * File    : mkcpptab.c                                                     *
+ *                                                                          *
+ * Purpose : Generator for the C++ lexer tables (cpptab.h).                 *
+ *                                                                          *
+ *           Writes the ASCII character-class table, a maximal-munch DFA    *
+ *           for the C++ operators, and a perfect hash for the keywords,    *
+ *           as C source to standard output:                                *
+ *           mkcpptab > ..\cpptab.h                                         *
+ *                                                                          *
+ *           Only uses the C99 standard library; builds on any host.        *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+
+#define NELEMS(a)  (sizeof(a) / sizeof(a[0]))
+
+// Character classes (bits); must match the CC_* names used by cpplex.c.
+#define CC_TEXT      0x00
+#define CC_ALPHA     0x01
+#define CC_DIGIT     0x02
+#define CC_XDIGIT    0x04
+#define CC_OPERATOR  0x08
+#define CC_QUOTE     0x10
+#define CC_SPACE     0x20
+
+// Maximum number of DFA states (trie nodes).
+#define MAX_STATES  64
+
+// Operators, any order; every prefix of length one must also be here.
+static const char *apszOperators[] = {
+    "<<=", ">>=", "...", "->*", "<=>",
+    "++", "--", "->", "<<", ">>", "<=", ">=", "==", "!=", "&&", "||",
+    "*=", "/=", "%=", "+=", "-=", "&=", "^=", "|=", ".*", "::",
+    ",", "*", "(", ")", "{", "}", "[", "]", "=", "&", "!", "+", "-",
+    ".", "<", ">", "/", "%", "^", "|", "?", ":", "~",
+};
+
+// Keywords, any order.
+static const char *apszKeywords[] = {
+    "alignas",  /* C++11 */
+    "alignof",  /* C++11 */
+    "and",
+    "and_eq",
+    "asm",
+    "auto",
+    "bitand",
+    "bitor",
+    "bool",
+    "break",
+    "case",
+    "catch",
+    "char",
+    "char16_t",  /* C++11 */
+    "char32_t",  /* C++11 */
+    "char8_t",  /* C++20 */
+    "class",
+    "co_await",  /* C++20 */
+    "co_return",  /* C++20 */
+    "co_yield",  /* C++20 */
+    "compl",
+    "concept",  /* C++20 */
+    "const",
+    "const_cast",
+    "consteval",  /* C++20 */
+    "constexpr",  /* C++11 */
+    "constinit",  /* C++20 */
+    "continue",
+    "decltype",  /* C++11 */
+    "default",
+    "delete",
+    "do",
+    "double",
+    "dynamic_cast",
+    "else",
+    "enum",
+    "explicit",
+    "export",
+    "extern",
+    "false",
+    "float",
+    "for",
+    "friend",
+    "goto",
+    "if",
+    "inline",
+    "int",
+    "long",
+    "mutable",
+    "namespace",
+    "new",
+    "noexcept",  /* C++11 */
+    "not",
+    "not_eq",
+    "nullptr",  /* C++11 */
+    "operator",
+    "or",
+    "or_eq",
+    "private",
+    "protected",
+    "public",
+    "register",
+    "reinterpret_cast",
+    "requires",  /* C++20 */
+    "return",
+    "short",
+    "signed",
+    "sizeof",
+    "static",
+    "static_assert",  /* C++11 */
+    "static_cast",
+    "struct",
+    "switch",
+    "template",
+    "this",
+    "thread_local",  /* C++11 */
+    "throw",
+    "true",
+    "try",
+    "typedef",
+    "typeid",
+    "typename",
+    "union",
+    "unsigned",
+    "using",
+    "virtual",
+    "void",
+    "volatile",
+    "wchar_t",
+    "while",
+    "xor",
+    "xor_eq",
+};
+
+// Not here: final, override (C++11), import and module (C++20). They are
+// keywords only in a few places, and ordinary names everywhere else; the
+// lexer can't tell which, so they are colored as names.
+
+// Largest keyword hash table tried, in bits, and multiplier sets tried for each size.
+#define MAX_HASHBITS  12
+#define C_HASHTRIES   1000000
+
+// Keyword hash: the hash function parameters, and the table.
+static int iKeyPos;                     // Index of the key character (the first, for shorter keywords).
+static uint32_t auMul[4];               // Multipliers: length, first, last, key character.
+static int cHashBits;
+static unsigned char abHash[1 << MAX_HASHBITS];  // Keyword index (1-n), or 0.
+
+// DFA, built as a trie over the operators.
+static unsigned char abOpChar[128];     // Operator character index (1-n), or 0.
+static char achOpChars[128];            // Operator characters, by index.
+static int cOpChars;
+static unsigned char abNext[MAX_STATES][128];
+static unsigned char abAccept[MAX_STATES];
+static int cStates = 1;  /* start state */
+
+// Static function prototypes.
+static int BuildDFA(void);
+static int BuildHash(void);
+static int TryHash(void);
+static uint32_t Hash(const char *, size_t);
+static uint32_t Random(uint32_t *);
+static void WriteTables(void);
+
+/****************************************************************************
+ *                                                                          *
+ * Function: main                                                           *
+ *                                                                          *
+ * Purpose : Main entry point.                                              *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+int main(void)
+{
+    if (!BuildDFA())
+    {
+        fprintf(stderr, "mkcpptab: too many states\n");
+        return 1;
+    }
+
+    if (!BuildHash())
+    {
+        fprintf(stderr, "mkcpptab: no perfect hash for the keywords\n");
+        return 1;
+    }
+
+    WriteTables();
+    return 0;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: BuildDFA                                                       *
+ *                                                                          *
+ * Purpose : Build the operator trie; state 0 is the start state, and a     *
+ *           transition to state 0 means "no longer operator".              *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int BuildDFA(void)
+{
+    size_t i;
+
+    for (i = 0; i < NELEMS(apszOperators); i++)
+    {
+        const char *psz;
+        int iState = 0;
+
+        for (psz = apszOperators[i]; *psz != '\0'; psz++)
+        {
+            int ch = (unsigned char)*psz;
+
+            if (abOpChar[ch] == 0)
+            {
+                abOpChar[ch] = (unsigned char)++cOpChars;
+                achOpChars[cOpChars] = (char)ch;
+            }
+
+            if (abNext[iState][abOpChar[ch]] == 0)
+            {
+                if (cStates == MAX_STATES)
+                    return 0;
+                abNext[iState][abOpChar[ch]] = (unsigned char)cStates++;
+            }
+            iState = abNext[iState][abOpChar[ch]];
+        }
+        abAccept[iState] = 1;
+    }
+
+    return 1;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: BuildHash                                                      *
+ *                                                                          *
+ * Purpose : Find a perfect hash for the keywords, in the smallest table.   *
+ *                                                                          *
+ *           The key is the length, the first and last character, and the   *
+ *           character at iKeyPos; a position is picked where no two        *
+ *           keywords have the same key. Then multipliers are searched      *
+ *           until no two keywords hash to the same slot.                   *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int BuildHash(void)
+{
+    size_t i, j;
+
+    // Find a position that tells all keywords apart.
+    for (iKeyPos = 1; iKeyPos < 16; iKeyPos++)
+    {
+        for (i = 0; i < NELEMS(apszKeywords); i++)
+        {
+            size_t cch = strlen(apszKeywords[i]);
+            for (j = 0; j < i; j++)
+            {
+                if (strlen(apszKeywords[j]) == cch && apszKeywords[j][0] == apszKeywords[i][0] && apszKeywords[j][cch - 1] == apszKeywords[i][cch - 1] &&
+                    apszKeywords[j][(size_t)iKeyPos < cch ? iKeyPos : 0] == apszKeywords[i][(size_t)iKeyPos < cch ? iKeyPos : 0])
+                    break;
+            }
+            if (j < i)
+                break;
+        }
+        if (i == NELEMS(apszKeywords))
+            break;
+    }
+    if (iKeyPos == 16)
+        return 0;
+
+    for (cHashBits = 1; (1u << cHashBits) < NELEMS(apszKeywords); cHashBits++)
+        ;
+    for (; cHashBits <= MAX_HASHBITS; cHashBits++)
+    {
+        uint32_t uSeed = 1;
+        int iTry;
+
+        for (iTry = 0; iTry < C_HASHTRIES; iTry++)
+        {
+            // Small multipliers, so the compiler can use shifts and adds.
+            for (i = 0; i < NELEMS(auMul); i++)
+                auMul[i] = Random(&uSeed) % 255 + 1;
+
+            if (TryHash())
+                return 1;
+        }
+    }
+
+    return 0;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: TryHash                                                        *
+ *                                                                          *
+ * Purpose : Fill the hash table; return zero on a collision.               *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static int TryHash(void)
+{
+    size_t i;
+
+    memset(abHash, 0, sizeof(abHash));
+    for (i = 0; i < NELEMS(apszKeywords); i++)
+    {
+        uint32_t iSlot = Hash(apszKeywords[i], strlen(apszKeywords[i]));
+        if (abHash[iSlot] != 0)
+            return 0;
+        abHash[iSlot] = (unsigned char)(i + 1);
+    }
+
+    return 1;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Hash                                                           *
+ *                                                                          *
+ * Purpose : Keyword hash; must match KeywordHash() in cpplex.c.            *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static uint32_t Hash(const char *pch, size_t cch)
+{
+    uint32_t u = (uint32_t)cch * auMul[0] +
+        (unsigned char)pch[0] * auMul[1] +
+        (unsigned char)pch[cch - 1] * auMul[2] +
+        (unsigned char)pch[(size_t)iKeyPos < cch ? iKeyPos : 0] * auMul[3];
+
+    return (u * 0x9E3779B1u) >> (32 - cHashBits);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: Random                                                         *
+ *                                                                          *
+ * Purpose : Return pseudo-random number; same sequence on every host.      *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static uint32_t Random(uint32_t *puSeed)
+{
+    // xorshift32.
+    *puSeed ^= *puSeed << 13;
+    *puSeed ^= *puSeed >> 17;
+    *puSeed ^= *puSeed << 5;
+    return *puSeed;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: WriteTables                                                    *
+ *                                                                          *
+ * Purpose : Write the tables, as C source.                                 *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static void WriteTables(void)
+{
+    int ch, iState, i;
+
+    printf("/* Generated by mkcpptab - do not edit. */\n\n");
+
+    printf("// Character classes (bits), for ASCII characters.\n");
+    printf("#define CC_TEXT      0x%02X\n", CC_TEXT);
+    printf("#define CC_ALPHA     0x%02X  /* A-Z a-z _ */\n", CC_ALPHA);
+    printf("#define CC_DIGIT     0x%02X  /* 0-9 */\n", CC_DIGIT);
+    printf("#define CC_XDIGIT    0x%02X  /* 0-9 A-F a-f */\n", CC_XDIGIT);
+    printf("#define CC_OPERATOR  0x%02X  /* first character of an operator */\n", CC_OPERATOR);
+    printf("#define CC_QUOTE     0x%02X  /* \" ' */\n", CC_QUOTE);
+    printf("#define CC_SPACE     0x%02X  /* space, tab */\n\n", CC_SPACE);
+
+    printf("static const BYTE abCharClass[128] = {");
+    for (ch = 0; ch < 128; ch++)
+    {
+        int bClass = CC_TEXT;
+
+        if (isalpha(ch) || ch == '_') bClass |= CC_ALPHA;
+        if (isdigit(ch)) bClass |= CC_DIGIT;
+        if (isxdigit(ch)) bClass |= CC_XDIGIT;
+        if (abOpChar[ch] != 0) bClass |= CC_OPERATOR;
+        if (ch == '\"' || ch == '\'') bClass |= CC_QUOTE;
+        if (ch == ' ' || ch == '\t') bClass |= CC_SPACE;
+
+        printf("%s0x%02X,", (ch % 16 == 0) ? "\n    " : " ", bClass);
+    }
+    printf("\n};\n\n");
+
+    printf("// Operator characters; column in abOpNext[], or 0.\n");
+    printf("#define OP_CHARS   %d\n", cOpChars + 1);
+    printf("#define OP_STATES  %d\n\n", cStates);
+
+    printf("static const BYTE abOpChar[128] = {");
+    for (ch = 0; ch < 128; ch++)
+        printf("%s%2d,", (ch % 16 == 0) ? "\n    " : " ", abOpChar[ch]);
+    printf("\n};\n\n");
+
+    printf("// Operator DFA: next state, from state 0 (start); 0 = end of operator.\n");
+    printf("static const BYTE abOpNext[OP_STATES][OP_CHARS] = {\n");
+    printf("    /*  ");
+    for (i = 1; i <= cOpChars; i++)
+        printf(" %c ", achOpChars[i]);
+    printf(" */\n");
+    for (iState = 0; iState < cStates; iState++)
+    {
+        printf("    { 0,");
+        for (i = 1; i <= cOpChars; i++)
+            printf("%2d,", abNext[iState][i]);
+        printf(" },\n");
+    }
+    printf("};\n\n");
+
+    printf("// Operator DFA: non-zero for states that end a complete operator.\n");
+    printf("static const BYTE abOpAccept[OP_STATES] = {");
+    for (iState = 0; iState < cStates; iState++)
+        printf("%s%d,", (iState % 16 == 0) ? "\n    " : " ", abAccept[iState]);
+    printf("\n};\n\n");
+
+    printf("// Keywords.\n");
+    printf("#define KW_COUNT    %zu\n\n", NELEMS(apszKeywords));
+    printf("static const char *apszKeywords[KW_COUNT] = {");
+    for (i = 0; (size_t)i < NELEMS(apszKeywords); i++)
+        printf("\n    \"%s\",", apszKeywords[i]);
+    printf("\n};\n\n");
+
+    printf("// Keyword hash: length, first, last, and character KW_KEYPOS (or first).\n");
+    printf("#define KW_KEYPOS    %d\n", iKeyPos);
+    printf("#define KW_MULLEN    %u\n", auMul[0]);
+    printf("#define KW_MULFIRST  %u\n", auMul[1]);
+    printf("#define KW_MULLAST   %u\n", auMul[2]);
+    printf("#define KW_MULKEY    %u\n", auMul[3]);
+    printf("#define KW_HASHBITS  %d\n\n", cHashBits);
+
+    printf("// Keyword hash table: keyword index (1-KW_COUNT), or 0.\n");
+    printf("static const BYTE abKeywordHash[1 << KW_HASHBITS] = {");
+    for (i = 0; i < (1 << cHashBits); i++)
+        printf("%s%3d,", (i % 16 == 0) ? "\n    " : " ", abHash[i]);
+    printf("\n};\n");
+}
@@ -16,9 +16,13 @@
 #include <addin.h>
 #include <wchar.h>
 #include <wctype.h>
+#include "../Shared/parsecache.h"
 
 #define NELEMS(a)  (sizeof(a) / sizeof(a[0]))
 
+// Lines kept by the parse cache.
+#define C_CACHELINES  2048
+
 // Flags for usCookie.
 #define FLAG_STRING  0x01
 
@@ -48,9 +52,11 @@ static PCWSTR apcszKeywords[] = {
 
 // Locals.
 static HANDLE g_hmod = NULL;
+static PPARSECACHE g_pCache = NULL;
 
 // Function prototypes.
-static USHORT Parser(USHORT, PCWSTR, int, ADDIN_PARSE_POINT [], PINT);
+static USHORT CALLBACK CachedParser(USHORT, PCWSTR, int, ADDIN_PARSE_POINT [], PINT);
+static USHORT CALLBACK Parser(USHORT, PCWSTR, int, ADDIN_PARSE_POINT [], PINT);
 static size_t IsKeyword(PCWSTR [], size_t, PCWSTR, size_t);
 static PCWSTR ParseNumber(PCWSTR, PCWSTR);
 
@@ -74,6 +80,8 @@ BOOL WINAPI DllMain(HANDLE hDLL, DWORD dwReason, LPVOID lpReserved)
             return TRUE;
 
         case DLL_PROCESS_DETACH:
+            ParseCacheDestroy(g_pCache);
+            g_pCache = NULL;
             return TRUE;
 
         default:
@@ -104,7 +112,8 @@ ADDINAPI BOOL WINAPI AddInMain(HWND hwnd, ADDIN_EVENT eEvent)
             AddFile.cbSize = sizeof(AddFile);
             AddFile.pszDescription = L"JSON file";
             AddFile.pszExtension = L"json";  /* support *.json files */
-            AddFile.pfnParser = Parser;
+            g_pCache = ParseCacheCreate(Parser, C_CACHELINES);
+            AddFile.pfnParser = (g_pCache != NULL) ? CachedParser : Parser;
             AddFile.pszShells = NULL;  /* not possible to build this type */
             AddFile.pfnScanner = NULL;  /* nothing to scan in this type */
             if (!AddIn_AddFileType(hwnd, &AddFile))
@@ -118,6 +127,22 @@ ADDINAPI BOOL WINAPI AddInMain(HWND hwnd, ADDIN_EVENT eEvent)
     }
 }
 
+/****************************************************************************
+ *                                                                          *
+ * Function: CachedParser                                                   *
+ *                                                                          *
+ * Purpose : Syntax color parser, through the parse cache.                  *
+ *                                                                          *
+ * History : Date        Reason                                             *
+ *           00/00/00   Created                                             *
+ *                                                                          *
+ ****************************************************************************/
+
+static USHORT CALLBACK CachedParser(USHORT usCookie, PCWSTR pchText, int cchText, ADDIN_PARSE_POINT pPoints[], PINT pcPoints)
+{
+    return ParseCacheParse(g_pCache, usCookie, pchText, cchText, pPoints, pcPoints);
+}
+
 /****************************************************************************
  *                                                                          *
  * Function: Parser                                                         *
@@ -137,7 +162,7 @@ ADDINAPI BOOL WINAPI AddInMain(HWND hwnd, ADDIN_EVENT eEvent)
  *            on each character in the largest supported line length (4096 characters).
  * pcPoints - (OUT) number of entries stored in pPoints[].
  */
-static USHORT Parser(USHORT usCookie, PCWSTR pchText, int cchText, ADDIN_PARSE_POINT pPoints[4096], PINT pcPoints)
+static USHORT CALLBACK Parser(USHORT usCookie, PCWSTR pchText, int cchText, ADDIN_PARSE_POINT pPoints[4096], PINT pcPoints)
 {
     PCWSTR pch = pchText, pchEnd = &pchText[cchText];
     BYTE cFoldLevel = ADDIN_GET_COOKIE_LEVEL(usCookie);
@@ -0,0 +1,286 @@
+﻿/****************************************************************************
+ *                                                                          *
+ * File    : parsecache.c                                                   *
+ *                                                                          *
+ * Purpose : Syntax color parse cache.                                      *
+ *                                                                          *
+ *           Set associative: a line goes into one set (by hash), and may   *
+ *           replace the least recently used of its C_WAYS lines. Each set  *
+ *           has its own lock, so threads only wait for each other when     *
+ *           they want the same set, and never while parsing.               *
+ *                                                                          *
+ *           A line is found by input cookie, length and a 64-bit hash of   *
+ *           the text; the text itself is not kept. Two different lines     *
+ *           with the same hash would get the same colors - very unlikely,  *
+ *           and only ever a cosmetic problem.                              *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define UNICODE   /* for Windows API */
+#define _UNICODE  /* for C runtime */
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include "parsecache.h"
+
+// Lines in each set.
+#define C_WAYS  4
+
+// Most color changes kept for one line; lines with more are always parsed.
+#define C_POINTSMAX  30
+
+// Cached line.
+typedef struct CACHELINE {
+    uint64_t hash;          // Hash of cookie and text.
+    int cchText;            // Length of text, or -1 for an unused line.
+    USHORT usCookieIn;      // Cookie from the previous line.
+    USHORT usCookieOut;     // Cookie returned by the parser.
+    UINT uStamp;            // Time of last use (set clock).
+    int cPoints;            // Number of color changes.
+    ADDIN_PARSE_POINT aPoints[C_POINTSMAX];  // Color changes.
+} CACHELINE;
+
+// Set of lines, with lock and statistics.
+typedef struct CACHESET {
+    CRITICAL_SECTION cs;    // Lock, for this set only.
+    UINT uClock;            // Incremented on each use.
+    uint64_t cHits;         // Statistics, for this set.
+    uint64_t cMisses;
+    uint64_t cUncached;
+    CACHELINE aLines[C_WAYS];  // Lines.
+} CACHESET;
+
+// Parse cache.
+struct PARSECACHE {
+    PARSEPROC pfnParser;    // Parser to call on a miss.
+    size_t cSets;           // Number of sets (power of two).
+    CACHESET aSets[];       // Sets.
+};
+
+// Static function prototypes.
+static uint64_t HashLine(USHORT, PCWSTR, int);
+
+// Inline functions.
+static inline uint64_t Mix(uint64_t u)
+{
+    u *= 0xFF51AFD7ED558CCDull;
+    return u ^ (u >> 32);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ParseCacheCreate                                               *
+ *                                                                          *
+ * Purpose : Create a cache for at least cLines lines, in front of the      *
+ *           given parser.                                                  *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+PPARSECACHE ParseCacheCreate(PARSEPROC pfnParser, size_t cLines)
+{
+    PPARSECACHE pCache;
+    size_t cSets, iSet;
+    int iWay;
+
+    for (cSets = 1; cSets * C_WAYS < cLines; cSets <<= 1)
+        ;
+
+    if ((pCache = calloc(1, sizeof(*pCache) + cSets * sizeof(CACHESET))) == NULL)
+        return NULL;
+
+    pCache->pfnParser = pfnParser;
+    pCache->cSets = cSets;
+    for (iSet = 0; iSet < cSets; iSet++)
+    {
+        InitializeCriticalSection(&pCache->aSets[iSet].cs);
+        for (iWay = 0; iWay < C_WAYS; iWay++)
+            pCache->aSets[iSet].aLines[iWay].cchText = -1;
+    }
+
+    return pCache;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ParseCacheDestroy                                              *
+ *                                                                          *
+ * Purpose : Destroy a cache; no other thread may be using it.              *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+void ParseCacheDestroy(PPARSECACHE pCache)
+{
+    size_t iSet;
+
+    if (pCache == NULL)
+        return;
+
+    for (iSet = 0; iSet < pCache->cSets; iSet++)
+        DeleteCriticalSection(&pCache->aSets[iSet].cs);
+
+    free(pCache);
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ParseCacheParse                                                *
+ *                                                                          *
+ * Purpose : Parse a line, or copy the result from the last time the same   *
+ *           line was parsed with the same cookie. Same arguments as the    *
+ *           parser; lines appended to earlier points are not cached.       *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+USHORT ParseCacheParse(PPARSECACHE pCache, USHORT usCookie, PCWSTR pchText, int cchText, ADDIN_PARSE_POINT pPoints[], PINT pcPoints)
+{
+    uint64_t hash;
+    CACHESET *pSet;
+    CACHELINE *pLine, *pOldest;
+    USHORT usCookieOut;
+    int cPoints;
+    int iWay;
+
+    // Points already there? The first new one may depend on the last color, which isn't in the key.
+    if (pPoints != NULL && *pcPoints != 0)
+        return pCache->pfnParser(usCookie, pchText, cchText, pPoints, pcPoints);
+
+    hash = HashLine(usCookie, pchText, cchText);
+    pSet = &pCache->aSets[hash & (pCache->cSets - 1)];
+
+    EnterCriticalSection(&pSet->cs);
+    for (iWay = 0; iWay < C_WAYS; iWay++)
+    {
+        pLine = &pSet->aLines[iWay];
+        if (pLine->hash == hash && pLine->cchText == cchText && pLine->usCookieIn == usCookie)
+        {
+            // Hit - copy the result.
+            pLine->uStamp = ++pSet->uClock;
+            pSet->cHits++;
+            if (pPoints != NULL)
+            {
+                memcpy(pPoints, pLine->aPoints, pLine->cPoints * sizeof(ADDIN_PARSE_POINT));
+                *pcPoints = pLine->cPoints;
+            }
+            usCookieOut = pLine->usCookieOut;
+            LeaveCriticalSection(&pSet->cs);
+            return usCookieOut;
+        }
+    }
+    pSet->cMisses++;
+    LeaveCriticalSection(&pSet->cs);
+
+    // Miss - parse, without holding the lock.
+    usCookieOut = pCache->pfnParser(usCookie, pchText, cchText, pPoints, pcPoints);
+
+    // Can only keep the result if we got all of it.
+    if (pPoints == NULL)
+        return usCookieOut;
+
+    cPoints = *pcPoints;
+
+    EnterCriticalSection(&pSet->cs);
+    if (cPoints > C_POINTSMAX)
+    {
+        pSet->cUncached++;
+    }
+    else
+    {
+        // Replace an unused, or the least recently used, line.
+        for (pOldest = pLine = &pSet->aLines[0]; pLine < &pSet->aLines[C_WAYS]; pLine++)
+        {
+            if (pLine->cchText < 0)
+            {
+                pOldest = pLine;
+                break;
+            }
+            if (pSet->uClock - pLine->uStamp > pSet->uClock - pOldest->uStamp)
+                pOldest = pLine;
+        }
+
+        pOldest->hash = hash;
+        pOldest->cchText = cchText;
+        pOldest->usCookieIn = usCookie;
+        pOldest->usCookieOut = usCookieOut;
+        pOldest->uStamp = ++pSet->uClock;
+        pOldest->cPoints = cPoints;
+        memcpy(pOldest->aPoints, pPoints, cPoints * sizeof(ADDIN_PARSE_POINT));
+    }
+    LeaveCriticalSection(&pSet->cs);
+
+    return usCookieOut;
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: ParseCacheGetStats                                             *
+ *                                                                          *
+ * Purpose : Return hit and miss counters, for all sets.                    *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+void ParseCacheGetStats(PPARSECACHE pCache, PPARSECACHESTATS pStats)
+{
+    size_t iSet;
+
+    memset(pStats, 0, sizeof(*pStats));
+    for (iSet = 0; iSet < pCache->cSets; iSet++)
+    {
+        CACHESET *pSet = &pCache->aSets[iSet];
+
+        EnterCriticalSection(&pSet->cs);
+        pStats->cHits += pSet->cHits;
+        pStats->cMisses += pSet->cMisses;
+        pStats->cUncached += pSet->cUncached;
+        LeaveCriticalSection(&pSet->cs);
+    }
+}
+
+/****************************************************************************
+ *                                                                          *
+ * Function: HashLine                                                       *
+ *                                                                          *
+ * Purpose : Hash cookie and line text; four characters at a time.          *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+static uint64_t HashLine(USHORT usCookie, PCWSTR pchText, int cchText)
+{
+    uint64_t hash = Mix(0x9E3779B97F4A7C15ull ^ ((uint64_t)usCookie << 32) ^ (uint32_t)cchText);
+    size_t cch = (cchText > 0) ? (size_t)cchText : 0;
+    uint64_t u;
+
+    for (; cch >= 4; cch -= 4, pchText += 4)
+    {
+        memcpy(&u, pchText, sizeof(u));
+        hash = Mix(hash ^ u);
+    }
+
+    if (cch > 0)
+    {
+        u = 0;
+        memcpy(&u, pchText, cch * sizeof(WCHAR));
+        hash = Mix(hash ^ u);
+    }
+
+    return Mix(hash);
+}
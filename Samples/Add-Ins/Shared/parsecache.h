@@ -0,0 +1,50 @@
+﻿/****************************************************************************
+ *                                                                          *
+ * File    : parsecache.h                                                   *
+ *                                                                          *
+ * Purpose : Definitions for the syntax color parse cache.                  *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+#ifndef _PARSECACHE_H
+#define _PARSECACHE_H
+
+/*
+ * The IDE calls the parser again for every visible line on each repaint,
+ * and most lines are the same as a moment ago. The cache remembers the
+ * result for (input cookie, line text), so a hit is one lookup and a copy.
+ * Used by the C++ and JSON add-ins; safe to call from several threads.
+ */
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <addin.h>
+#else /* !_WIN32 */
+#include "winhost.h"
+#endif /* !_WIN32 */
+#include <stddef.h>
+#include <stdint.h>
+
+// Parser, as given to the IDE.
+typedef USHORT (CALLBACK *PARSEPROC)(USHORT, PCWSTR, int, ADDIN_PARSE_POINT [], PINT);
+
+// Cache statistics.
+typedef struct PARSECACHESTATS {
+    uint64_t cHits;         // Lines found in the cache.
+    uint64_t cMisses;       // Lines parsed.
+    uint64_t cUncached;     // Lines parsed, but with too many points to keep.
+} PARSECACHESTATS, *PPARSECACHESTATS;
+
+typedef struct PARSECACHE *PPARSECACHE;
+
+/****** Function prototypes ************************************************/
+
+PPARSECACHE ParseCacheCreate(PARSEPROC /*pfnParser*/, size_t /*cLines*/);
+void ParseCacheDestroy(PPARSECACHE /*pCache*/);
+USHORT ParseCacheParse(PPARSECACHE /*pCache*/, USHORT /*usCookie*/, PCWSTR /*pchText*/, int /*cchText*/, ADDIN_PARSE_POINT [] /*pPoints*/, PINT /*pcPoints*/);
+void ParseCacheGetStats(PPARSECACHE /*pCache*/, PPARSECACHESTATS /*pStats*/);
+
+#endif /* _PARSECACHE_H */
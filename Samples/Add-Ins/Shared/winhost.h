@@ -0,0 +1,76 @@
+﻿/****************************************************************************
+ *                                                                          *
+ * File    : winhost.h                                                      *
+ *                                                                          *
+ * Purpose : Stand-ins for the few Windows and add-in definitions used by   *
+ *           the shared and C++ add-in sources, so they can be built and    *
+ *           profiled on other hosts. Never included on Windows; the real   *
+ *           <windows.h> and <addin.h> are used there.                      *
+ *                                                                          *
+ * History : Date      Reason                                               *
+ *           00/00/00  Created                                              *
+ *                                                                          *
+ ****************************************************************************/
+
+#ifndef _WINHOST_H
+#define _WINHOST_H
+
+#if defined(_WIN32)
+#error Use <windows.h> and <addin.h> on Windows.
+#endif /* _WIN32 */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <wctype.h>
+#include <threads.h>
+
+#define CALLBACK
+#define WINAPI
+#define TRUE   1
+#define FALSE  0
+
+typedef int BOOL;
+typedef int INT, *PINT;
+typedef unsigned int UINT;
+typedef unsigned char BYTE, *PBYTE;
+typedef long LONG;
+typedef unsigned long DWORD;
+typedef void *LPVOID;
+typedef const void *LPCVOID;
+typedef unsigned short USHORT;
+typedef uint16_t WCHAR;  /* UTF-16, like on Windows */
+typedef WCHAR *PWSTR;
+typedef const WCHAR *PCWSTR, *LPCWSTR;
+
+// Parse point, and colors; values don't matter, only that they differ.
+typedef struct ADDIN_PARSE_POINT {
+    UINT iChar;
+    UINT iColor;
+} ADDIN_PARSE_POINT;
+
+#define ADDIN_COLOR_TEXT          0
+#define ADDIN_COLOR_KEYWORD       1
+#define ADDIN_COLOR_COMMENT       2
+#define ADDIN_COLOR_STRING        3
+#define ADDIN_COLOR_NUMBER        4
+#define ADDIN_COLOR_OPERATOR      5
+#define ADDIN_COLOR_PREPROCESSOR  6
+
+#define ADDIN_GET_COOKIE_FLAGS(c)    ((BYTE)(c))
+#define ADDIN_GET_COOKIE_LEVEL(c)    ((BYTE)((c) >> 8))
+#define ADDIN_MAKE_COOKIE(f,l)       ((USHORT)((BYTE)(f) | ((USHORT)(BYTE)(l) << 8)))
+
+// Character classification; the C library is close enough for a benchmark.
+#define IsCharAlphaW(ch)         (iswalpha((wint_t)(ch)) != 0)
+#define IsCharAlphaNumericW(ch)  (iswalnum((wint_t)(ch)) != 0)
+
+// Locks; C11 mutexes are close enough (nobody here locks recursively).
+typedef mtx_t CRITICAL_SECTION;
+
+#define InitializeCriticalSection(pcs)  ((void)mtx_init((pcs), mtx_plain))
+#define DeleteCriticalSection(pcs)      mtx_destroy(pcs)
+#define EnterCriticalSection(pcs)       ((void)mtx_lock(pcs))
+#define LeaveCriticalSection(pcs)       ((void)mtx_unlock(pcs))
+
+#endif /* _WINHOST_H */